@@ -0,0 +1,827 @@
+#include "aas_local.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Bot-local collision against the BSP hull loaded by AAS_LoadMap.  The
+ * sweep follows CM_BoxTrace from the Quake II engine so results line up
+ * with the trace import, but all scratch state lives in a per-call work
+ * structure instead of globals, which keeps the routines re-entrant.
+ */
+
+#define AAS_BSP_DIST_EPSILON 0.03125f
+#define AAS_BSP_MAX_BOXLEAFS 128
+
+aas_bspworld_t bspworld = {0};
+
+typedef struct aas_bsptracework_s
+{
+    vec3_t start;
+    vec3_t end;
+    vec3_t mins;
+    vec3_t maxs;
+    vec3_t extents;
+    int contents;
+    bool ispoint;
+    bsp_trace_t trace;
+} aas_bsptracework_t;
+
+void AAS_BSPClearCollision(void)
+{
+    free(bspworld.planes);
+    free(bspworld.nodes);
+    free(bspworld.leafs);
+    free(bspworld.leafbrushes);
+    free(bspworld.brushes);
+    free(bspworld.brushsides);
+    free(bspworld.surfaces);
+    free(bspworld.models);
+    free(bspworld.pvs);
+    memset(&bspworld, 0, sizeof(bspworld));
+}
+
+bool AAS_BSPCollisionLoaded(void)
+{
+    return bspworld.loaded && bspworld.numNodes > 0;
+}
+
+static float AAS_BSPPlaneDiff(const cplane_t *plane, const vec3_t point)
+{
+    if (plane->type < 3)
+    {
+        return point[plane->type] - plane->dist;
+    }
+
+    return DotProduct(plane->normal, point) - plane->dist;
+}
+
+static int AAS_BSPPointLeafnumFromNode(const vec3_t point, int num)
+{
+    while (num >= 0)
+    {
+        const aas_bspnode_t *node = &bspworld.nodes[num];
+        num = (AAS_BSPPlaneDiff(node->plane, point) < 0.0f) ? node->children[1] : node->children[0];
+    }
+
+    return -1 - num;
+}
+
+int AAS_BSPPointLeafnum(const vec3_t point)
+{
+    if (point == NULL || !AAS_BSPCollisionLoaded())
+    {
+        return 0;
+    }
+
+    return AAS_BSPPointLeafnumFromNode(point, bspworld.models[0].headnode);
+}
+
+int AAS_BSPPointContents(const vec3_t point)
+{
+    if (point == NULL || !AAS_BSPCollisionLoaded())
+    {
+        return 0;
+    }
+
+    return bspworld.leafs[AAS_BSPPointLeafnum(point)].contents;
+}
+
+/* returns -1 for solid leaves, points outside the world or maps without vis */
+int AAS_BSPPointCluster(const vec3_t point)
+{
+    if (point == NULL || !AAS_BSPCollisionLoaded() || bspworld.pvs == NULL)
+    {
+        return -1;
+    }
+
+    int cluster = bspworld.leafs[AAS_BSPPointLeafnum(point)].cluster;
+    return (cluster < bspworld.numClusters) ? cluster : -1;
+}
+
+/*
+ * Conservative visibility test between two clusters.  Answers true whenever
+ * the PVS cannot rule the pair out, including for cluster -1.
+ */
+bool AAS_BSPClustersInPVS(int cluster1, int cluster2)
+{
+    if (bspworld.pvs == NULL || cluster1 < 0 || cluster2 < 0 ||
+        cluster1 >= bspworld.numClusters || cluster2 >= bspworld.numClusters)
+    {
+        return true;
+    }
+
+    const byte *row = bspworld.pvs + (size_t)cluster1 * (size_t)bspworld.clusterBytes;
+    return (row[cluster2 >> 3] & (1 << (cluster2 & 7))) != 0;
+}
+
+bool AAS_BSPInPVS(const vec3_t p1, const vec3_t p2)
+{
+    return AAS_BSPClustersInPVS(AAS_BSPPointCluster(p1), AAS_BSPPointCluster(p2));
+}
+
+static void AAS_BSPBoxLeafnums(int num,
+                               const vec3_t mins,
+                               const vec3_t maxs,
+                               int *leafs,
+                               int *count,
+                               int maxcount)
+{
+    while (num >= 0)
+    {
+        const aas_bspnode_t *node = &bspworld.nodes[num];
+        const cplane_t *plane = node->plane;
+
+        vec3_t nearCorner;
+        vec3_t farCorner;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            nearCorner[axis] = (plane->normal[axis] < 0.0f) ? maxs[axis] : mins[axis];
+            farCorner[axis] = (plane->normal[axis] < 0.0f) ? mins[axis] : maxs[axis];
+        }
+
+        bool front = DotProduct(plane->normal, farCorner) >= plane->dist;
+        bool back = DotProduct(plane->normal, nearCorner) < plane->dist;
+        if (front && back)
+        {
+            AAS_BSPBoxLeafnums(node->children[0], mins, maxs, leafs, count, maxcount);
+            num = node->children[1];
+        }
+        else
+        {
+            num = front ? node->children[0] : node->children[1];
+        }
+    }
+
+    if (*count < maxcount)
+    {
+        leafs[(*count)++] = -1 - num;
+    }
+}
+
+static void AAS_BSPClipBoxToBrush(aas_bsptracework_t *work,
+                                  const vec3_t p1,
+                                  const vec3_t p2,
+                                  const aas_bspbrush_t *brush)
+{
+    if (brush->numsides <= 0)
+    {
+        return;
+    }
+
+    float enterfrac = -1.0f;
+    float leavefrac = 1.0f;
+    const cplane_t *clipplane = NULL;
+    const aas_bspbrushside_t *leadside = NULL;
+    bool getout = false;
+    bool startout = false;
+
+    for (int i = 0; i < brush->numsides; ++i)
+    {
+        const aas_bspbrushside_t *side = &bspworld.brushsides[brush->firstside + i];
+        const cplane_t *plane = side->plane;
+
+        float dist = plane->dist;
+        if (!work->ispoint)
+        {
+            vec3_t ofs;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                ofs[axis] = (plane->normal[axis] < 0.0f) ? work->maxs[axis] : work->mins[axis];
+            }
+            dist -= DotProduct(ofs, plane->normal);
+        }
+
+        float d1 = DotProduct(p1, plane->normal) - dist;
+        float d2 = DotProduct(p2, plane->normal) - dist;
+
+        if (d2 > 0.0f)
+        {
+            getout = true;
+        }
+        if (d1 > 0.0f)
+        {
+            startout = true;
+        }
+
+        /* completely in front of this face, no intersection */
+        if (d1 > 0.0f && d2 >= d1)
+        {
+            return;
+        }
+
+        if (d1 <= 0.0f && d2 <= 0.0f)
+        {
+            continue;
+        }
+
+        if (d1 > d2)
+        {
+            float f = (d1 - AAS_BSP_DIST_EPSILON) / (d1 - d2);
+            if (f > enterfrac)
+            {
+                enterfrac = f;
+                clipplane = plane;
+                leadside = side;
+            }
+        }
+        else
+        {
+            float f = (d1 + AAS_BSP_DIST_EPSILON) / (d1 - d2);
+            if (f < leavefrac)
+            {
+                leavefrac = f;
+            }
+        }
+    }
+
+    if (!startout)
+    {
+        work->trace.startsolid = qtrue;
+        if (!getout)
+        {
+            work->trace.allsolid = qtrue;
+        }
+        return;
+    }
+
+    if (enterfrac < leavefrac && enterfrac > -1.0f && enterfrac < work->trace.fraction)
+    {
+        if (enterfrac < 0.0f)
+        {
+            enterfrac = 0.0f;
+        }
+
+        work->trace.fraction = enterfrac;
+        work->trace.plane = *clipplane;
+        if (leadside->surface >= 0)
+        {
+            work->trace.surface = bspworld.surfaces[leadside->surface];
+        }
+        work->trace.contents = brush->contents;
+    }
+}
+
+static void AAS_BSPTestBoxInBrush(aas_bsptracework_t *work, const vec3_t p1, const aas_bspbrush_t *brush)
+{
+    if (brush->numsides <= 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < brush->numsides; ++i)
+    {
+        const cplane_t *plane = bspworld.brushsides[brush->firstside + i].plane;
+
+        vec3_t ofs;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            ofs[axis] = (plane->normal[axis] < 0.0f) ? work->maxs[axis] : work->mins[axis];
+        }
+
+        float dist = plane->dist - DotProduct(ofs, plane->normal);
+        if (DotProduct(p1, plane->normal) - dist > 0.0f)
+        {
+            return;
+        }
+    }
+
+    work->trace.startsolid = qtrue;
+    work->trace.allsolid = qtrue;
+    work->trace.fraction = 0.0f;
+    work->trace.contents = brush->contents;
+}
+
+/*
+ * Brushes shared by several leafs may be clipped more than once.  The
+ * engine skips them with a global checkcount; clipping twice yields the
+ * same fraction, so the repeat is accepted to stay free of shared state.
+ */
+static void AAS_BSPTraceToLeaf(aas_bsptracework_t *work, int leafnum)
+{
+    const aas_bspleaf_t *leaf = &bspworld.leafs[leafnum];
+    if (!(leaf->contents & work->contents))
+    {
+        return;
+    }
+
+    for (int i = 0; i < leaf->numleafbrushes; ++i)
+    {
+        const aas_bspbrush_t *brush = &bspworld.brushes[bspworld.leafbrushes[leaf->firstleafbrush + i]];
+        if (!(brush->contents & work->contents))
+        {
+            continue;
+        }
+
+        AAS_BSPClipBoxToBrush(work, work->start, work->end, brush);
+        if (work->trace.fraction <= 0.0f)
+        {
+            return;
+        }
+    }
+}
+
+static void AAS_BSPTestInLeaf(aas_bsptracework_t *work, int leafnum)
+{
+    const aas_bspleaf_t *leaf = &bspworld.leafs[leafnum];
+    if (!(leaf->contents & work->contents))
+    {
+        return;
+    }
+
+    for (int i = 0; i < leaf->numleafbrushes; ++i)
+    {
+        const aas_bspbrush_t *brush = &bspworld.brushes[bspworld.leafbrushes[leaf->firstleafbrush + i]];
+        if (!(brush->contents & work->contents))
+        {
+            continue;
+        }
+
+        AAS_BSPTestBoxInBrush(work, work->start, brush);
+        if (work->trace.fraction <= 0.0f)
+        {
+            return;
+        }
+    }
+}
+
+static void AAS_BSPRecursiveHullCheck(aas_bsptracework_t *work,
+                                      int num,
+                                      float p1f,
+                                      float p2f,
+                                      const vec3_t p1,
+                                      const vec3_t p2)
+{
+    if (work->trace.fraction <= p1f)
+    {
+        return; /* already hit something nearer */
+    }
+
+    if (num < 0)
+    {
+        AAS_BSPTraceToLeaf(work, -1 - num);
+        return;
+    }
+
+    const aas_bspnode_t *node = &bspworld.nodes[num];
+    const cplane_t *plane = node->plane;
+
+    float t1;
+    float t2;
+    float offset;
+    if (plane->type < 3)
+    {
+        t1 = p1[plane->type] - plane->dist;
+        t2 = p2[plane->type] - plane->dist;
+        offset = work->extents[plane->type];
+    }
+    else
+    {
+        t1 = DotProduct(plane->normal, p1) - plane->dist;
+        t2 = DotProduct(plane->normal, p2) - plane->dist;
+        offset = work->ispoint ? 0.0f
+                               : fabsf(work->extents[0] * plane->normal[0]) +
+                                     fabsf(work->extents[1] * plane->normal[1]) +
+                                     fabsf(work->extents[2] * plane->normal[2]);
+    }
+
+    if (t1 >= offset && t2 >= offset)
+    {
+        AAS_BSPRecursiveHullCheck(work, node->children[0], p1f, p2f, p1, p2);
+        return;
+    }
+    if (t1 < -offset && t2 < -offset)
+    {
+        AAS_BSPRecursiveHullCheck(work, node->children[1], p1f, p2f, p1, p2);
+        return;
+    }
+
+    /* put the crosspoint DIST_EPSILON pixels on the near side */
+    int side;
+    float frac;
+    float frac2;
+    if (t1 < t2)
+    {
+        float idist = 1.0f / (t1 - t2);
+        side = 1;
+        frac2 = (t1 + offset + AAS_BSP_DIST_EPSILON) * idist;
+        frac = (t1 - offset + AAS_BSP_DIST_EPSILON) * idist;
+    }
+    else if (t1 > t2)
+    {
+        float idist = 1.0f / (t1 - t2);
+        side = 0;
+        frac2 = (t1 - offset - AAS_BSP_DIST_EPSILON) * idist;
+        frac = (t1 + offset + AAS_BSP_DIST_EPSILON) * idist;
+    }
+    else
+    {
+        side = 0;
+        frac = 1.0f;
+        frac2 = 0.0f;
+    }
+
+    frac = (frac < 0.0f) ? 0.0f : ((frac > 1.0f) ? 1.0f : frac);
+    float midf = p1f + (p2f - p1f) * frac;
+    vec3_t mid;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        mid[axis] = p1[axis] + frac * (p2[axis] - p1[axis]);
+    }
+    AAS_BSPRecursiveHullCheck(work, node->children[side], p1f, midf, p1, mid);
+
+    frac2 = (frac2 < 0.0f) ? 0.0f : ((frac2 > 1.0f) ? 1.0f : frac2);
+    midf = p1f + (p2f - p1f) * frac2;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        mid[axis] = p1[axis] + frac2 * (p2[axis] - p1[axis]);
+    }
+    AAS_BSPRecursiveHullCheck(work, node->children[side ^ 1], midf, p2f, mid, p2);
+}
+
+static bsp_trace_t AAS_BSPBoxTrace(const vec3_t start,
+                                   const vec3_t end,
+                                   const vec3_t mins,
+                                   const vec3_t maxs,
+                                   int headnode,
+                                   int contentmask)
+{
+    aas_bsptracework_t work;
+    memset(&work, 0, sizeof(work));
+    work.trace.fraction = 1.0f;
+    work.contents = contentmask;
+    VectorCopy(start, work.start);
+    VectorCopy(end, work.end);
+    VectorCopy(mins, work.mins);
+    VectorCopy(maxs, work.maxs);
+
+    if (start[0] == end[0] && start[1] == end[1] && start[2] == end[2])
+    {
+        vec3_t c1;
+        vec3_t c2;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            c1[axis] = start[axis] + mins[axis] - 1.0f;
+            c2[axis] = start[axis] + maxs[axis] + 1.0f;
+        }
+
+        int leafs[AAS_BSP_MAX_BOXLEAFS];
+        int count = 0;
+        AAS_BSPBoxLeafnums(headnode, c1, c2, leafs, &count, AAS_BSP_MAX_BOXLEAFS);
+        for (int i = 0; i < count; ++i)
+        {
+            AAS_BSPTestInLeaf(&work, leafs[i]);
+            if (work.trace.allsolid)
+            {
+                break;
+            }
+        }
+
+        VectorCopy(start, work.trace.endpos);
+        return work.trace;
+    }
+
+    work.ispoint = mins[0] == 0.0f && mins[1] == 0.0f && mins[2] == 0.0f && maxs[0] == 0.0f &&
+                   maxs[1] == 0.0f && maxs[2] == 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        work.extents[axis] = (-mins[axis] > maxs[axis]) ? -mins[axis] : maxs[axis];
+    }
+
+    AAS_BSPRecursiveHullCheck(&work, headnode, 0.0f, 1.0f, start, end);
+
+    if (work.trace.fraction >= 1.0f)
+    {
+        VectorCopy(end, work.trace.endpos);
+    }
+    else
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            work.trace.endpos[axis] = start[axis] + work.trace.fraction * (end[axis] - start[axis]);
+        }
+    }
+
+    return work.trace;
+}
+
+static void AAS_BSPAngleVectors(const vec3_t angles, vec3_t forward, vec3_t right, vec3_t up)
+{
+    const float deg2rad = 3.14159265358979323846f / 180.0f;
+    float sy = sinf(angles[YAW] * deg2rad);
+    float cy = cosf(angles[YAW] * deg2rad);
+    float sp = sinf(angles[PITCH] * deg2rad);
+    float cp = cosf(angles[PITCH] * deg2rad);
+    float sr = sinf(angles[ROLL] * deg2rad);
+    float cr = cosf(angles[ROLL] * deg2rad);
+
+    VectorSet(forward, cp * cy, cp * sy, -sp);
+    VectorSet(right, -sr * sp * cy + cr * sy, -sr * sp * sy - cr * cy, -sr * cp);
+    VectorSet(up, cr * sp * cy + sr * sy, cr * sp * sy - sr * cy, cr * cp);
+}
+
+static void AAS_BSPRotatePoint(const vec3_t in,
+                               const vec3_t forward,
+                               const vec3_t right,
+                               const vec3_t up,
+                               vec3_t out)
+{
+    vec3_t temp;
+    VectorCopy(in, temp);
+    out[0] = DotProduct(temp, forward);
+    out[1] = -DotProduct(temp, right);
+    out[2] = DotProduct(temp, up);
+}
+
+/* CM_TransformedBoxTrace: sweep through a brush model placed at origin/angles. */
+static bsp_trace_t AAS_BSPTransformedBoxTrace(const vec3_t start,
+                                              const vec3_t end,
+                                              const vec3_t mins,
+                                              const vec3_t maxs,
+                                              int headnode,
+                                              int contentmask,
+                                              const vec3_t origin,
+                                              const vec3_t angles)
+{
+    vec3_t localStart;
+    vec3_t localEnd;
+    VectorSubtract(start, origin, localStart);
+    VectorSubtract(end, origin, localEnd);
+
+    bool rotated = angles[0] != 0.0f || angles[1] != 0.0f || angles[2] != 0.0f;
+    if (rotated)
+    {
+        vec3_t forward;
+        vec3_t right;
+        vec3_t up;
+        AAS_BSPAngleVectors(angles, forward, right, up);
+        AAS_BSPRotatePoint(localStart, forward, right, up, localStart);
+        AAS_BSPRotatePoint(localEnd, forward, right, up, localEnd);
+    }
+
+    bsp_trace_t trace = AAS_BSPBoxTrace(localStart, localEnd, mins, maxs, headnode, contentmask);
+
+    if (rotated && trace.fraction != 1.0f)
+    {
+        vec3_t inverse;
+        vec3_t forward;
+        vec3_t right;
+        vec3_t up;
+        VectorNegate(angles, inverse);
+        AAS_BSPAngleVectors(inverse, forward, right, up);
+        AAS_BSPRotatePoint(trace.plane.normal, forward, right, up, trace.plane.normal);
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        trace.endpos[axis] = start[axis] + trace.fraction * (end[axis] - start[axis]);
+    }
+
+    return trace;
+}
+
+/*
+ * Swept box against an axis aligned entity box, used for clients and other
+ * SOLID_BBOX entities which the engine clips with CM_HeadnodeForBox.
+ */
+static bool AAS_BSPClipBoxToEntityBox(const vec3_t start,
+                                      const vec3_t end,
+                                      const vec3_t mins,
+                                      const vec3_t maxs,
+                                      const aas_entity_t *entity,
+                                      bsp_trace_t *trace)
+{
+    float enterfrac = -1.0f;
+    float leavefrac = 1.0f;
+    int enteraxis = -1;
+    float entersign = 0.0f;
+    bool startout = false;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float boxmin = entity->origin[axis] + entity->mins[axis] - maxs[axis];
+        float boxmax = entity->origin[axis] + entity->maxs[axis] - mins[axis];
+
+        for (int side = 0; side < 2; ++side)
+        {
+            /* side 0 is the +axis face, side 1 the -axis face */
+            float d1 = (side == 0) ? start[axis] - boxmax : boxmin - start[axis];
+            float d2 = (side == 0) ? end[axis] - boxmax : boxmin - end[axis];
+
+            if (d1 > 0.0f)
+            {
+                startout = true;
+            }
+            if (d1 > 0.0f && d2 >= d1)
+            {
+                return false;
+            }
+            if (d1 <= 0.0f && d2 <= 0.0f)
+            {
+                continue;
+            }
+
+            if (d1 > d2)
+            {
+                float f = (d1 - AAS_BSP_DIST_EPSILON) / (d1 - d2);
+                if (f > enterfrac)
+                {
+                    enterfrac = f;
+                    enteraxis = axis;
+                    entersign = (side == 0) ? 1.0f : -1.0f;
+                }
+            }
+            else
+            {
+                float f = (d1 + AAS_BSP_DIST_EPSILON) / (d1 - d2);
+                if (f < leavefrac)
+                {
+                    leavefrac = f;
+                }
+            }
+        }
+    }
+
+    if (!startout)
+    {
+        trace->startsolid = qtrue;
+        trace->fraction = 0.0f;
+        trace->ent = entity->number;
+        trace->contents = CONTENTS_MONSTER;
+        return true;
+    }
+
+    if (enterfrac < leavefrac && enterfrac > -1.0f && enterfrac < trace->fraction && enteraxis >= 0)
+    {
+        trace->fraction = (enterfrac < 0.0f) ? 0.0f : enterfrac;
+        memset(&trace->plane, 0, sizeof(trace->plane));
+        trace->plane.normal[enteraxis] = entersign;
+        trace->plane.type = (byte)enteraxis;
+        trace->ent = entity->number;
+        trace->contents = CONTENTS_MONSTER;
+        return true;
+    }
+
+    return false;
+}
+
+static void AAS_BSPMergeTrace(bsp_trace_t *trace, const bsp_trace_t *clip, int entnum)
+{
+    if (clip->allsolid || clip->fraction < trace->fraction)
+    {
+        qboolean startsolid = trace->startsolid;
+        *trace = *clip;
+        trace->ent = entnum;
+        if (startsolid)
+        {
+            trace->startsolid = qtrue;
+        }
+    }
+    else if (clip->startsolid)
+    {
+        trace->startsolid = qtrue;
+    }
+}
+
+static bool AAS_BSPBoundsOverlap(const vec3_t mins1, const vec3_t maxs1, const vec3_t mins2, const vec3_t maxs2)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (mins1[axis] > maxs2[axis] || maxs1[axis] < mins2[axis])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * SV_Trace equivalent: clip against the world hull, then against the brush
+ * models and bounding boxes of the entities linked into the AAS world.
+ * Only the SOLID_BSP and SOLID_BBOX lists kept by AAS_UpdateEntity are
+ * walked, so non-solid entities cost nothing.  Movers are matched to their
+ * inline model through modelindex - 1.
+ */
+bsp_trace_t AAS_BSPTrace(const vec3_t start,
+                         const vec3_t mins,
+                         const vec3_t maxs,
+                         const vec3_t end,
+                         int passent,
+                         int contentmask)
+{
+    bsp_trace_t trace;
+    memset(&trace, 0, sizeof(trace));
+    trace.fraction = 1.0f;
+
+    if (start == NULL || end == NULL || !AAS_BSPCollisionLoaded())
+    {
+        return trace;
+    }
+
+    vec3_t zero = {0.0f, 0.0f, 0.0f};
+    const float *boxmins = (mins != NULL) ? mins : zero;
+    const float *boxmaxs = (maxs != NULL) ? maxs : zero;
+
+    trace = AAS_BSPBoxTrace(start, end, boxmins, boxmaxs, bspworld.models[0].headnode, contentmask);
+    trace.ent = 0;
+    if (trace.fraction <= 0.0f || aasworld.entities == NULL)
+    {
+        return trace;
+    }
+
+    vec3_t tracemins;
+    vec3_t tracemaxs;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float lo = (start[axis] < end[axis]) ? start[axis] : end[axis];
+        float hi = (start[axis] < end[axis]) ? end[axis] : start[axis];
+        tracemins[axis] = lo + boxmins[axis] - 1.0f;
+        tracemaxs[axis] = hi + boxmaxs[axis] + 1.0f;
+    }
+
+    for (int i = 0; i < aasworld.numMoverEntities && !trace.allsolid; ++i)
+    {
+        int entnum = aasworld.moverEntities[i];
+        const aas_entity_t *entity = &aasworld.entities[entnum];
+        if (!entity->inuse || entnum == passent || entity->areas == NULL)
+        {
+            continue;
+        }
+
+        int modelnum = entity->modelindex - 1;
+        if (modelnum <= 0 || modelnum >= bspworld.numModels)
+        {
+            continue;
+        }
+
+        const aas_bspmodel_t *model = &bspworld.models[modelnum];
+        vec3_t absmins;
+        vec3_t absmaxs;
+        if (entity->angles[0] != 0.0f || entity->angles[1] != 0.0f || entity->angles[2] != 0.0f)
+        {
+            /* rotated models: bound by the radius of the model box */
+            float radius = 0.0f;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float extent = fmaxf(fabsf(model->mins[axis]), fabsf(model->maxs[axis]));
+                radius += extent * extent;
+            }
+            radius = sqrtf(radius);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                absmins[axis] = entity->origin[axis] - radius;
+                absmaxs[axis] = entity->origin[axis] + radius;
+            }
+        }
+        else
+        {
+            VectorAdd(entity->origin, model->mins, absmins);
+            VectorAdd(entity->origin, model->maxs, absmaxs);
+        }
+
+        if (!AAS_BSPBoundsOverlap(absmins, absmaxs, tracemins, tracemaxs))
+        {
+            continue;
+        }
+
+        bsp_trace_t clip = AAS_BSPTransformedBoxTrace(start,
+                                                      end,
+                                                      boxmins,
+                                                      boxmaxs,
+                                                      model->headnode,
+                                                      contentmask,
+                                                      entity->origin,
+                                                      entity->angles);
+        AAS_BSPMergeTrace(&trace, &clip, entnum);
+    }
+
+    for (int i = 0; i < aasworld.numBoxEntities && !trace.allsolid && (contentmask & CONTENTS_MONSTER); ++i)
+    {
+        int entnum = aasworld.boxEntities[i];
+        const aas_entity_t *entity = &aasworld.entities[entnum];
+        if (!entity->inuse || entnum == passent || entity->areas == NULL)
+        {
+            continue;
+        }
+
+        vec3_t absmins;
+        vec3_t absmaxs;
+        VectorAdd(entity->origin, entity->mins, absmins);
+        VectorAdd(entity->origin, entity->maxs, absmaxs);
+        if (AAS_BSPBoundsOverlap(absmins, absmaxs, tracemins, tracemaxs) &&
+            AAS_BSPClipBoxToEntityBox(start, end, boxmins, boxmaxs, entity, &trace))
+        {
+            memset(&trace.surface, 0, sizeof(trace.surface));
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        trace.endpos[axis] = start[axis] + trace.fraction * (end[axis] - start[axis]);
+    }
+
+    return trace;
+}
@@ -28,6 +28,13 @@ typedef struct aas_area_s
     vec3_t center;      /* cached centroid used by routing */
 } aas_area_t;
 
+typedef struct aas_plane_s
+{
+    vec3_t normal;
+    float dist;
+    int type;
+} aas_plane_t;
+
 typedef struct aas_node_s
 {
     int planenum;       /* splitting plane */
@@ -123,10 +130,30 @@ typedef struct aas_areasettings_s
     int firstreachablearea;
 } aas_areasettings_t;
 
+/*
+ * Occupant classes tracked by the per-area crowd counters.  An entity is
+ * classified when it is linked so the counters can be maintained without
+ * revisiting the entity table.
+ */
+typedef enum aas_occupantclass_e
+{
+    AAS_OCCUPANT_PLAYER = 0,
+    AAS_OCCUPANT_PROJECTILE,
+    AAS_OCCUPANT_ITEM,
+    AAS_OCCUPANT_MOVER,
+    AAS_OCCUPANT_OTHER,
+    AAS_OCCUPANT_NUMCLASSES
+} aas_occupantclass_t;
+
+#define AAS_OCCUPANT_MASK(occupant) (1 << (occupant))
+#define AAS_OCCUPANT_ALL ((1 << AAS_OCCUPANT_NUMCLASSES) - 1)
+
 typedef struct aas_link_s
 {
     int entnum;
     int areanum;
+    int occupant;           /* aas_occupantclass_t recorded at link time */
+    qboolean firstInCluster; /* this link accounts for the entity in its cluster */
     struct aas_link_s *next_ent;
     struct aas_link_s *prev_ent;
     struct aas_link_s *next_area;
@@ -178,6 +205,9 @@ typedef struct aas_entity_s
     int areaOccupancyCount;          /* total linked areas for diagnostics */
     qboolean outsideAllAreas;        /* qtrue if no valid areas were found */
     float lastOutsideUpdate;         /* aasworld.time when outsideAllAreas became true */
+
+    int collisionSolid; /* SOLID_BSP or SOLID_BBOX list holding the entity, SOLID_NOT if none */
+    int collisionSlot;  /* index of the entity in that list */
 } aas_entity_t;
 
 typedef struct aas_reversedreachability_s
@@ -205,6 +235,7 @@ typedef struct aas_world_s
     int numFrames;          /* frame counter updated each BotStartFrame */
     int bspChecksum;        /* checksum recorded during AAS_LoadMap */
     int aasChecksum;        /* checksum of the loaded .aas file */
+    qboolean sharedData;    /* immutable arrays are mapped from a shared segment */
 
     char aasFilePath[MAX_FILEPATH];
     char mapName[MAX_FILEPATH];
@@ -224,23 +255,145 @@ typedef struct aas_world_s
     int numNodes;
     aas_node_t *nodes;
 
+    int numPlanes;
+    aas_plane_t *planes;
+
+    int *areaOverlapOffsets; /* CSR offsets into areaOverlaps, numAreas + 2 entries */
+    int *areaOverlaps;       /* lower-numbered areas whose boxes touch each area */
+
     int maxEntities;
     aas_entity_t *entities; /* base pointer from data_100669a0 */
+    int maxClients;         /* maxclients at map load, the client entity range */
+
+    /* entities a trace can clip against, sized to maxEntities and kept by AAS_UpdateEntity */
+    int *moverEntities; /* SOLID_BSP */
+    int numMoverEntities;
+    int *boxEntities; /* SOLID_BBOX */
+    int numBoxEntities;
 
     size_t areaEntityListCount;  /* number of heads in areaEntityLists */
     aas_link_t **areaEntityLists; /* entities linked per area */
 
+    int *areaOccupancy;    /* areaEntityListCount * AAS_OCCUPANT_NUMCLASSES counters */
+    int numClusters;       /* highest cluster number referenced by areasettings */
+    int *clusterOccupancy; /* (numClusters + 1) * AAS_OCCUPANT_NUMCLASSES counters */
+
     int travelflagfortype[MAX_TRAVELTYPES];
 
     size_t routingCacheTableSize;
     aas_routingcache_t **routingCacheTable;
     aas_routingcache_t *routingCacheHead;
     aas_routingcache_t *routingCacheTail;
+    unsigned int routeEpoch; /* bumped whenever cached routes become stale */
+    unsigned int reachabilityEpoch; /* bumped whenever the reachability links are rebuilt */
 } aas_world_t;
 
 extern aas_world_t aasworld;
 
+/*
+ * Collision hull copied from the BSP so traces can be answered without a
+ * round trip through the engine.  Plane pointers are resolved at load time
+ * and leaf children use the Quake II -(leaf + 1) encoding.
+ */
+typedef struct aas_bspnode_s
+{
+    const cplane_t *plane;
+    int children[2];
+} aas_bspnode_t;
+
+typedef struct aas_bspleaf_s
+{
+    int contents;
+    int cluster;
+    int area;
+    int firstleafbrush;
+    int numleafbrushes;
+} aas_bspleaf_t;
+
+typedef struct aas_bspbrushside_s
+{
+    const cplane_t *plane;
+    int surface; /* index into surfaces, -1 for none */
+} aas_bspbrushside_t;
+
+typedef struct aas_bspbrush_s
+{
+    int contents;
+    int firstside;
+    int numsides;
+} aas_bspbrush_t;
+
+typedef struct aas_bspmodel_s
+{
+    vec3_t mins;
+    vec3_t maxs;
+    vec3_t origin;
+    int headnode;
+} aas_bspmodel_t;
+
+typedef struct aas_bspworld_s
+{
+    qboolean loaded;
+
+    int numPlanes;
+    cplane_t *planes;
+
+    int numNodes;
+    aas_bspnode_t *nodes;
+
+    int numLeafs;
+    aas_bspleaf_t *leafs;
+
+    int numLeafBrushes;
+    int *leafbrushes;
+
+    int numBrushes;
+    aas_bspbrush_t *brushes;
+
+    int numBrushSides;
+    aas_bspbrushside_t *brushsides;
+
+    int numSurfaces;
+    bsp_surface_t *surfaces;
+
+    int numModels;
+    aas_bspmodel_t *models;
+
+    /* decompressed PVS rows, numClusters rows of clusterBytes; NULL when the map has no vis */
+    int numClusters;
+    int clusterBytes;
+    byte *pvs;
+} aas_bspworld_t;
+
+extern aas_bspworld_t bspworld;
+
+#define AAS_TRAVELMEMO_SIZE 128 /* power of two */
+
+/*
+ * Route times looked up by one bot during a think.  Only the part of a travel
+ * time that does not depend on the start point is kept, so queries from
+ * different origins in the same area share an entry.  Entries from an older
+ * frame or route epoch are ignored.
+ */
+typedef struct aas_travelmemo_entry_s
+{
+    int areanum;
+    int goalareanum;
+    int travelflags;
+    unsigned short traveltime;
+    unsigned int stamp;
+} aas_travelmemo_entry_t;
+
+typedef struct aas_travelmemo_s
+{
+    aas_travelmemo_entry_t entries[AAS_TRAVELMEMO_SIZE];
+    unsigned int stamp;
+    int frame;
+    unsigned int epoch;
+} aas_travelmemo_t;
+
 void AAS_InitTravelFlagFromType(void);
+int AAS_TravelFlagForType(int traveltype);
 void AAS_ClearReachabilityData(void);
 int AAS_PrepareReachability(void);
 void AAS_FreeAllRoutingCaches(void);
@@ -250,12 +403,24 @@ void AAS_UnlinkInvalidEntities(void);
 void AAS_InvalidateEntities(void);
 void AAS_FrameSynchronise(float time);
 int AAS_AreaTravelTimeToGoalArea(int areanum, vec3_t origin, int goalareanum, int travelflags);
+int AAS_AreasWithinTravelTime(int areanum,
+                              const vec3_t origin,
+                              int travelflags,
+                              int maxtime,
+                              int *areas,
+                              int *traveltimes,
+                              int maxareas);
+void AAS_FreeLocalRouteScratch(void);
 void AAS_RouteFrameUpdate(void);
 void AAS_RouteFrameResetDiagnostics(void);
 int AAS_RouteFrameWorkCounter(void);
 int AAS_RouteFrameSkipCounter(void);
 int AAS_RouteFrameLastBudget(void);
 bool AAS_RouteFrameForceWriteActive(void);
+void AAS_SetTravelMemo(aas_travelmemo_t *memo);
+int AAS_RouteFrameMemoLookups(void);
+int AAS_RouteFrameMemoHits(void);
+float AAS_RouteFrameMemoHitRate(void);
 void AAS_ReachabilityFrameUpdate(void);
 void AAS_ReachabilityFrameResetDiagnostics(void);
 int AAS_ReachabilityFrameWorkCounter(void);
@@ -263,6 +428,72 @@ int AAS_ReachabilityFrameSkipCounter(void);
 bool AAS_ReachabilityForceReachabilityActive(void);
 bool AAS_ReachabilityForceClusteringActive(void);
 
+bool AAS_AreaContainsPoint(int areanum, const vec3_t point);
+int AAS_PrepareAreaOverlaps(void);
+void AAS_ClearAreaOverlaps(void);
+int AAS_PointAreaNum(const vec3_t point);
+int AAS_PointAreaNumHinted(const vec3_t point, int hintArea);
+int AAS_TraceAreas(const vec3_t start, const vec3_t end, int *areas, vec3_t *points, int maxareas);
+
+int AAS_AreaOccupancy(int areanum, int occupantMask);
+int AAS_ClusterOccupancy(int cluster, int occupantMask);
+int AAS_AreaCluster(int areanum);
+
+void AAS_BSPClearCollision(void);
+bool AAS_BSPCollisionLoaded(void);
+int AAS_BSPPointLeafnum(const vec3_t point);
+int AAS_BSPPointContents(const vec3_t point);
+int AAS_BSPPointCluster(const vec3_t point);
+bool AAS_BSPClustersInPVS(int cluster1, int cluster2);
+bool AAS_BSPInPVS(const vec3_t p1, const vec3_t p2);
+bsp_trace_t AAS_BSPTrace(const vec3_t start,
+                         const vec3_t mins,
+                         const vec3_t maxs,
+                         const vec3_t end,
+                         int passent,
+                         int contentmask);
+
+/* stop events reported by AAS_PredictClientMovement */
+#define SE_NONE            0
+#define SE_HITGROUND       1
+#define SE_LEAVEGROUND     2
+#define SE_ENTERWATER      4
+#define SE_ENTERSLIME      8
+#define SE_ENTERLAVA       16
+#define SE_HITGROUNDDAMAGE 32
+#define SE_ENTERAREA       64
+#define SE_HITGROUNDAREA   128
+
+typedef struct aas_clientmove_s
+{
+    vec3_t endpos;      /* position when the prediction stopped */
+    int endarea;        /* area containing endpos, 0 when outside the AAS */
+    vec3_t velocity;    /* velocity when the prediction stopped */
+    int endcontents;    /* contents at the feet when the prediction stopped */
+    int stopevent;      /* SE_* event that ended the prediction */
+    int events;         /* every SE_* event seen along the way */
+    float time;         /* simulated time in seconds */
+    int frames;         /* number of simulated frames */
+} aas_clientmove_t;
+
+bool AAS_PredictClientMovement(aas_clientmove_t *move,
+                               int entnum,
+                               const vec3_t origin,
+                               const vec3_t mins,
+                               const vec3_t maxs,
+                               bool onground,
+                               const vec3_t velocity,
+                               const vec3_t cmdmove,
+                               int cmdframes,
+                               int maxframes,
+                               float frametime,
+                               int stopevent,
+                               int stopareanum);
+
+qboolean AAS_SharedWorldAttach(int bspChecksum, int aasChecksum);
+void AAS_SharedWorldPublish(void);
+void AAS_SharedWorldDetach(void);
+
 int AAS_NextModelReachability(int startIndex, int modelnum);
 int AAS_ModelNumForEntity(int entnum);
 
@@ -13,18 +13,23 @@
 #include "aas_local.h"
 #include "aas_sound.h"
 #include "botlib/ai_move/mover_catalogue.h"
+#include "botlib/common/l_libvar.h"
 #include "botlib/common/l_log.h"
 #include "botlib/interface/botlib_interface.h"
 #include "botlib/ai_move/mover_catalogue.h"
 
 static void AAS_UnlinkEntityFromAreas(aas_entity_t *entity);
-static int AAS_LinkEntityToComputedAreas(aas_entity_t *entity, const vec3_t absmins, const vec3_t absmaxs);
+static int AAS_LinkEntityToComputedAreas(aas_entity_t *entity,
+                                         const vec3_t absmins,
+                                         const vec3_t absmaxs,
+                                         qboolean isMover);
 static void AAS_ResetEntityBitset(aas_entity_t *entity);
 static int AAS_PrepareEntityBitset(aas_entity_t *entity);
 static int AAS_EnsureAreaListArray(void);
 static size_t AAS_AreaBitWordCount(void);
 static void AAS_ClampMinsMaxs(vec3_t mins, vec3_t maxs);
 static void AAS_ClearWorld(void);
+static void AAS_FreeOccupancyCounters(void);
 static void AAS_ParseEntityLump(const char *data, size_t length);
 
 /*
@@ -787,6 +792,23 @@ static void AAS_FixupReachability(aas_reachability_t *reachability, int count)
     }
 }
 
+static void AAS_FixupPlanes(aas_plane_t *planes, int count)
+{
+    if (planes == NULL || count <= 0)
+    {
+        return;
+    }
+
+    for (int index = 0; index < count; ++index)
+    {
+        planes[index].normal[0] = AAS_LittleFloat(planes[index].normal[0]);
+        planes[index].normal[1] = AAS_LittleFloat(planes[index].normal[1]);
+        planes[index].normal[2] = AAS_LittleFloat(planes[index].normal[2]);
+        planes[index].dist = AAS_LittleFloat(planes[index].dist);
+        planes[index].type = AAS_LittleLong(planes[index].type);
+    }
+}
+
 static void AAS_FixupNodes(aas_node_t *nodes, int count)
 {
     if (nodes == NULL || count <= 0)
@@ -1095,6 +1117,7 @@ static void AAS_ClearWorld(void)
     AAS_RouteFrameResetDiagnostics();
     AAS_ReachabilityFrameResetDiagnostics();
     AAS_FreeAllRoutingCaches();
+    AAS_FreeLocalRouteScratch();
     AAS_ClearReachabilityData();
 
     if (aasworld.entities != NULL)
@@ -1115,6 +1138,13 @@ static void AAS_ClearWorld(void)
         aasworld.entities = NULL;
     }
 
+    free(aasworld.moverEntities);
+    aasworld.moverEntities = NULL;
+    aasworld.numMoverEntities = 0;
+    free(aasworld.boxEntities);
+    aasworld.boxEntities = NULL;
+    aasworld.numBoxEntities = 0;
+
     if (aasworld.areaEntityLists != NULL)
     {
         free(aasworld.areaEntityLists);
@@ -1122,6 +1152,20 @@ static void AAS_ClearWorld(void)
         aasworld.areaEntityListCount = 0U;
     }
 
+    AAS_FreeOccupancyCounters();
+    AAS_ClearAreaOverlaps();
+
+    if (aasworld.sharedData)
+    {
+        /* Mapped arrays are released together with the segment. */
+        aasworld.areas = NULL;
+        aasworld.areasettings = NULL;
+        aasworld.reachability = NULL;
+        aasworld.nodes = NULL;
+        aasworld.planes = NULL;
+    }
+    AAS_SharedWorldDetach();
+
     if (aasworld.areas != NULL)
     {
         free(aasworld.areas);
@@ -1146,14 +1190,478 @@ static void AAS_ClearWorld(void)
         aasworld.nodes = NULL;
     }
 
+    if (aasworld.planes != NULL)
+    {
+        free(aasworld.planes);
+        aasworld.planes = NULL;
+    }
+
     AAS_SoundSubsystem_ClearMapAssets();
+    AAS_BSPClearCollision();
     BotMove_MoverCatalogueReset();
+
+    /* paths planned against the old world must never look current again */
+    unsigned int routeEpoch = aasworld.routeEpoch + 1U;
+    unsigned int reachabilityEpoch = aasworld.reachabilityEpoch + 1U;
     memset(&aasworld, 0, sizeof(aasworld));
+    aasworld.routeEpoch = routeEpoch;
+    aasworld.reachabilityEpoch = reachabilityEpoch;
 
     TranslateEntity_SetCurrentTime(0.0f);
     TranslateEntity_SetWorldLoaded(qfalse);
 }
 
+/*
+ * Expands every PVS row of the visibility lump into bspworld.pvs.  The lump
+ * holds the cluster count, a pair of row offsets per cluster (PVS, PHS) and
+ * run-length encoded rows where a zero byte is followed by the number of
+ * zero bytes it stands for, as decoded by CM_DecompressVis.  Malformed data
+ * only drops the PVS; the filter then lets every pair through.
+ */
+static void AAS_DecompressBSPVisibility(const uint8_t *vis, int visSize)
+{
+    if (vis == NULL || visSize < (int)sizeof(int32_t))
+    {
+        return;
+    }
+
+    int32_t numClusters;
+    memcpy(&numClusters, vis, sizeof(numClusters));
+    numClusters = AAS_LittleLong(numClusters);
+    if (numClusters <= 0 || numClusters > (visSize - (int)sizeof(int32_t)) / (2 * (int)sizeof(int32_t)))
+    {
+        BotLib_Print(PRT_WARNING, "AAS_LoadBSPCollision: bad visibility lump, PVS disabled\n");
+        return;
+    }
+
+    int rowBytes = (numClusters + 7) >> 3;
+    byte *pvs = (byte *)calloc((size_t)numClusters, (size_t)rowBytes);
+    if (pvs == NULL)
+    {
+        return;
+    }
+
+    for (int cluster = 0; cluster < numClusters; ++cluster)
+    {
+        int32_t offset;
+        memcpy(&offset, vis + sizeof(int32_t) * (1 + 2 * (size_t)cluster), sizeof(offset));
+        offset = AAS_LittleLong(offset);
+        if (offset < 0 || offset >= visSize)
+        {
+            free(pvs);
+            BotLib_Print(PRT_WARNING, "AAS_LoadBSPCollision: bad visibility lump, PVS disabled\n");
+            return;
+        }
+
+        const uint8_t *in = vis + offset;
+        const uint8_t *end = vis + visSize;
+        byte *out = pvs + (size_t)cluster * (size_t)rowBytes;
+        int written = 0;
+        while (written < rowBytes && in < end)
+        {
+            if (*in != 0)
+            {
+                out[written++] = *in++;
+                continue;
+            }
+
+            if (in + 1 >= end)
+            {
+                break;
+            }
+
+            /* the row was zeroed by calloc, so a run only advances */
+            written += in[1];
+            in += 2;
+        }
+    }
+
+    bspworld.pvs = pvs;
+    bspworld.numClusters = numClusters;
+    bspworld.clusterBytes = rowBytes;
+}
+
+/*
+ * Copies the collision lumps into bspworld.  Any failure leaves the local
+ * trace unavailable and callers keep using the engine trace import.
+ */
+static int AAS_ReadBSPCollisionLumps(FILE *file, const q2_bsp_header_t *header, long fileSize)
+{
+    q2_dplane_t *planes = NULL;
+    q2_dnode_t *nodes = NULL;
+    q2_dleaf_t *leafs = NULL;
+    uint16_t *leafbrushes = NULL;
+    q2_dbrush_t *brushes = NULL;
+    q2_dbrushside_t *brushsides = NULL;
+    q2_texinfo_t *texinfo = NULL;
+    q2_dmodel_t *models = NULL;
+    uint8_t *vis = NULL;
+    int numPlanes = 0;
+    int numNodes = 0;
+    int numLeafs = 0;
+    int numLeafBrushes = 0;
+    int numBrushes = 0;
+    int numBrushSides = 0;
+    int numTexinfo = 0;
+    int numModels = 0;
+    int visSize = 0;
+
+    const struct
+    {
+        q2_bsp_lump_id_t lump;
+        size_t elementSize;
+        void **buffer;
+        int *count;
+    } lumps[] = {
+        {Q2_BSP_LUMP_PLANES, sizeof(q2_dplane_t), (void **)&planes, &numPlanes},
+        {Q2_BSP_LUMP_NODES, sizeof(q2_dnode_t), (void **)&nodes, &numNodes},
+        {Q2_BSP_LUMP_LEAFS, sizeof(q2_dleaf_t), (void **)&leafs, &numLeafs},
+        {Q2_BSP_LUMP_LEAFBRUSHES, sizeof(uint16_t), (void **)&leafbrushes, &numLeafBrushes},
+        {Q2_BSP_LUMP_BRUSHES, sizeof(q2_dbrush_t), (void **)&brushes, &numBrushes},
+        {Q2_BSP_LUMP_BRUSHSIDES, sizeof(q2_dbrushside_t), (void **)&brushsides, &numBrushSides},
+        {Q2_BSP_LUMP_TEXINFO, sizeof(q2_texinfo_t), (void **)&texinfo, &numTexinfo},
+        {Q2_BSP_LUMP_MODELS, sizeof(q2_dmodel_t), (void **)&models, &numModels},
+        {Q2_BSP_LUMP_VISIBILITY, sizeof(uint8_t), (void **)&vis, &visSize},
+    };
+
+    int status = BLERR_NOERROR;
+    for (size_t i = 0; i < sizeof(lumps) / sizeof(lumps[0]) && status == BLERR_NOERROR; ++i)
+    {
+        status = AAS_ReadLump(file,
+                              &header->lumps[lumps[i].lump],
+                              lumps[i].elementSize,
+                              lumps[i].buffer,
+                              lumps[i].count,
+                              fileSize,
+                              BLERR_CANNOTREADBSPHEADER,
+                              BLERR_CANNOTREADBSPHEADER);
+    }
+
+    if (status == BLERR_NOERROR && (numPlanes <= 0 || numNodes <= 0 || numLeafs <= 0 || numModels <= 0))
+    {
+        status = BLERR_CANNOTREADBSPHEADER;
+    }
+
+    if (status == BLERR_NOERROR)
+    {
+        bspworld.planes = (cplane_t *)calloc((size_t)numPlanes, sizeof(cplane_t));
+        bspworld.nodes = (aas_bspnode_t *)calloc((size_t)numNodes, sizeof(aas_bspnode_t));
+        bspworld.leafs = (aas_bspleaf_t *)calloc((size_t)numLeafs, sizeof(aas_bspleaf_t));
+        bspworld.leafbrushes = (int *)calloc((size_t)numLeafBrushes + 1U, sizeof(int));
+        bspworld.brushes = (aas_bspbrush_t *)calloc((size_t)numBrushes + 1U, sizeof(aas_bspbrush_t));
+        bspworld.brushsides =
+            (aas_bspbrushside_t *)calloc((size_t)numBrushSides + 1U, sizeof(aas_bspbrushside_t));
+        bspworld.surfaces = (bsp_surface_t *)calloc((size_t)numTexinfo + 1U, sizeof(bsp_surface_t));
+        bspworld.models = (aas_bspmodel_t *)calloc((size_t)numModels, sizeof(aas_bspmodel_t));
+        if (bspworld.planes == NULL || bspworld.nodes == NULL || bspworld.leafs == NULL ||
+            bspworld.leafbrushes == NULL || bspworld.brushes == NULL || bspworld.brushsides == NULL ||
+            bspworld.surfaces == NULL || bspworld.models == NULL)
+        {
+            status = BLERR_CANNOTREADBSPHEADER;
+        }
+    }
+
+    for (int i = 0; status == BLERR_NOERROR && i < numPlanes; ++i)
+    {
+        cplane_t *plane = &bspworld.planes[i];
+        int signbits = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            plane->normal[axis] = AAS_LittleFloat(planes[i].normal[axis]);
+            if (plane->normal[axis] < 0.0f)
+            {
+                signbits |= 1 << axis;
+            }
+        }
+        plane->dist = AAS_LittleFloat(planes[i].dist);
+        plane->type = (byte)AAS_LittleLong(planes[i].type);
+        plane->signbits = (byte)signbits;
+    }
+
+    for (int i = 0; status == BLERR_NOERROR && i < numTexinfo; ++i)
+    {
+        bsp_surface_t *surface = &bspworld.surfaces[i];
+        memcpy(surface->name, texinfo[i].texture, sizeof(surface->name) - 1U);
+        surface->name[sizeof(surface->name) - 1U] = '\0';
+        surface->flags = AAS_LittleLong(texinfo[i].flags);
+        surface->value = AAS_LittleLong(texinfo[i].value);
+    }
+
+    for (int i = 0; status == BLERR_NOERROR && i < numNodes; ++i)
+    {
+        int planenum = AAS_LittleLong(nodes[i].planenum);
+        if (planenum < 0 || planenum >= numPlanes)
+        {
+            status = BLERR_CANNOTREADBSPHEADER;
+            break;
+        }
+
+        bspworld.nodes[i].plane = &bspworld.planes[planenum];
+        for (int side = 0; side < 2; ++side)
+        {
+            int child = AAS_LittleLong(nodes[i].children[side]);
+            if (child >= numNodes || (child < 0 && -1 - child >= numLeafs))
+            {
+                status = BLERR_CANNOTREADBSPHEADER;
+                break;
+            }
+            bspworld.nodes[i].children[side] = child;
+        }
+    }
+
+    for (int i = 0; status == BLERR_NOERROR && i < numLeafs; ++i)
+    {
+        aas_bspleaf_t *leaf = &bspworld.leafs[i];
+        leaf->contents = AAS_LittleLong(leafs[i].contents);
+        leaf->cluster = (int16_t)AAS_LittleShort((uint16_t)leafs[i].cluster);
+        leaf->area = (int16_t)AAS_LittleShort((uint16_t)leafs[i].area);
+        leaf->firstleafbrush = AAS_LittleShort(leafs[i].firstleafbrush);
+        leaf->numleafbrushes = AAS_LittleShort(leafs[i].numleafbrushes);
+        if (leaf->firstleafbrush + leaf->numleafbrushes > numLeafBrushes)
+        {
+            status = BLERR_CANNOTREADBSPHEADER;
+        }
+    }
+
+    for (int i = 0; status == BLERR_NOERROR && i < numLeafBrushes; ++i)
+    {
+        bspworld.leafbrushes[i] = AAS_LittleShort(leafbrushes[i]);
+        if (bspworld.leafbrushes[i] >= numBrushes)
+        {
+            status = BLERR_CANNOTREADBSPHEADER;
+        }
+    }
+
+    for (int i = 0; status == BLERR_NOERROR && i < numBrushes; ++i)
+    {
+        aas_bspbrush_t *brush = &bspworld.brushes[i];
+        brush->firstside = AAS_LittleLong(brushes[i].firstside);
+        brush->numsides = AAS_LittleLong(brushes[i].numsides);
+        brush->contents = AAS_LittleLong(brushes[i].contents);
+        if (brush->firstside < 0 || brush->numsides < 0 ||
+            brush->firstside + brush->numsides > numBrushSides)
+        {
+            status = BLERR_CANNOTREADBSPHEADER;
+        }
+    }
+
+    for (int i = 0; status == BLERR_NOERROR && i < numBrushSides; ++i)
+    {
+        int planenum = AAS_LittleShort(brushsides[i].planenum);
+        int surface = (int16_t)AAS_LittleShort((uint16_t)brushsides[i].texinfo);
+        if (planenum >= numPlanes)
+        {
+            status = BLERR_CANNOTREADBSPHEADER;
+            break;
+        }
+
+        bspworld.brushsides[i].plane = &bspworld.planes[planenum];
+        bspworld.brushsides[i].surface = (surface >= 0 && surface < numTexinfo) ? surface : -1;
+    }
+
+    for (int i = 0; status == BLERR_NOERROR && i < numModels; ++i)
+    {
+        aas_bspmodel_t *model = &bspworld.models[i];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            /* spread the bounds by a unit, matching CMod_LoadSubmodels */
+            model->mins[axis] = AAS_LittleFloat(models[i].mins[axis]) - 1.0f;
+            model->maxs[axis] = AAS_LittleFloat(models[i].maxs[axis]) + 1.0f;
+            model->origin[axis] = AAS_LittleFloat(models[i].origin[axis]);
+        }
+        model->headnode = AAS_LittleLong(models[i].headnode);
+        if (model->headnode < 0 || model->headnode >= numNodes)
+        {
+            status = BLERR_CANNOTREADBSPHEADER;
+        }
+    }
+
+    free(planes);
+    free(nodes);
+    free(leafs);
+    free(leafbrushes);
+    free(brushes);
+    free(brushsides);
+    free(texinfo);
+    free(models);
+
+    if (status == BLERR_NOERROR)
+    {
+        AAS_DecompressBSPVisibility(vis, visSize);
+    }
+    free(vis);
+
+    if (status != BLERR_NOERROR)
+    {
+        AAS_BSPClearCollision();
+        return status;
+    }
+
+    bspworld.numPlanes = numPlanes;
+    bspworld.numNodes = numNodes;
+    bspworld.numLeafs = numLeafs;
+    bspworld.numLeafBrushes = numLeafBrushes;
+    bspworld.numBrushes = numBrushes;
+    bspworld.numBrushSides = numBrushSides;
+    bspworld.numSurfaces = numTexinfo;
+    bspworld.numModels = numModels;
+    bspworld.loaded = qtrue;
+    return BLERR_NOERROR;
+}
+
+int AAS_LoadBSPCollision(const char *bspPath)
+{
+    AAS_BSPClearCollision();
+
+    if (bspPath == NULL || *bspPath == '\0')
+    {
+        return BLERR_CANNOTOPENBSPFILE;
+    }
+
+    FILE *bspFile = fopen(bspPath, "rb");
+    if (bspFile == NULL)
+    {
+        return BLERR_CANNOTOPENBSPFILE;
+    }
+
+    q2_bsp_header_t bspHeader;
+    if (fread(&bspHeader, sizeof(bspHeader), 1U, bspFile) != 1U)
+    {
+        fclose(bspFile);
+        return BLERR_CANNOTREADBSPHEADER;
+    }
+
+    bspHeader.ident = AAS_LittleLong(bspHeader.ident);
+    bspHeader.version = AAS_LittleLong(bspHeader.version);
+    for (int index = 0; index < Q2_BSP_LUMP_MAX; ++index)
+    {
+        bspHeader.lumps[index].offset = AAS_LittleLong(bspHeader.lumps[index].offset);
+        bspHeader.lumps[index].length = AAS_LittleLong(bspHeader.lumps[index].length);
+    }
+
+    if (bspHeader.ident != Q2_BSP_IDENT)
+    {
+        fclose(bspFile);
+        return BLERR_WRONGBSPFILEID;
+    }
+
+    if (bspHeader.version != Q2_BSP_VERSION)
+    {
+        fclose(bspFile);
+        return BLERR_WRONGBSPFILEVERSION;
+    }
+
+    int status = AAS_ReadBSPCollisionLumps(bspFile, &bspHeader, AAS_GetFileSize(bspFile));
+    fclose(bspFile);
+    return status;
+}
+
+static int AAS_ReadWorldLumps(FILE *file, const q2_aas_header_t *header, long fileSize)
+{
+    aas_area_t *areas = NULL;
+    int numAreas = 0;
+    int result = AAS_ReadLump(file,
+                              &header->lumps[Q2_AAS_LUMP_AREAS],
+                              sizeof(aas_area_t),
+                              (void **)&areas,
+                              &numAreas,
+                              fileSize,
+                              BLERR_CANNOTSEEKTOAASFILE,
+                              BLERR_CANNOTREADAASLUMP);
+    if (result != BLERR_NOERROR)
+    {
+        return result;
+    }
+
+    aas_areasettings_t *areasettings = NULL;
+    int numAreaSettings = 0;
+    result = AAS_ReadLump(file,
+                          &header->lumps[Q2_AAS_LUMP_AREASETTINGS],
+                          sizeof(aas_areasettings_t),
+                          (void **)&areasettings,
+                          &numAreaSettings,
+                          fileSize,
+                          BLERR_CANNOTSEEKTOAASFILE,
+                          BLERR_CANNOTREADAASLUMP);
+    if (result != BLERR_NOERROR)
+    {
+        free(areas);
+        return result;
+    }
+
+    aas_reachability_t *reachability = NULL;
+    int numReachability = 0;
+    result = AAS_ReadLump(file,
+                          &header->lumps[Q2_AAS_LUMP_REACHABILITY],
+                          sizeof(aas_reachability_t),
+                          (void **)&reachability,
+                          &numReachability,
+                          fileSize,
+                          BLERR_CANNOTSEEKTOAASFILE,
+                          BLERR_CANNOTREADAASLUMP);
+    if (result != BLERR_NOERROR)
+    {
+        free(areas);
+        free(areasettings);
+        return result;
+    }
+
+    aas_node_t *nodes = NULL;
+    int numNodes = 0;
+    result = AAS_ReadLump(file,
+                          &header->lumps[Q2_AAS_LUMP_NODES],
+                          sizeof(aas_node_t),
+                          (void **)&nodes,
+                          &numNodes,
+                          fileSize,
+                          BLERR_CANNOTSEEKTOAASFILE,
+                          BLERR_CANNOTREADAASLUMP);
+    if (result != BLERR_NOERROR)
+    {
+        free(areas);
+        free(areasettings);
+        free(reachability);
+        return result;
+    }
+
+    aas_plane_t *planes = NULL;
+    int numPlanes = 0;
+    result = AAS_ReadLump(file,
+                          &header->lumps[Q2_AAS_LUMP_PLANES],
+                          sizeof(aas_plane_t),
+                          (void **)&planes,
+                          &numPlanes,
+                          fileSize,
+                          BLERR_CANNOTSEEKTOAASFILE,
+                          BLERR_CANNOTREADAASLUMP);
+    if (result != BLERR_NOERROR)
+    {
+        free(areas);
+        free(areasettings);
+        free(reachability);
+        free(nodes);
+        return result;
+    }
+
+    AAS_FixupAreas(areas, numAreas);
+    AAS_FixupAreaSettings(areasettings, numAreaSettings);
+    AAS_FixupReachability(reachability, numReachability);
+    AAS_FixupNodes(nodes, numNodes);
+    AAS_FixupPlanes(planes, numPlanes);
+
+    aasworld.numAreas = numAreas;
+    aasworld.areas = areas;
+    aasworld.numReachability = numReachability;
+    aasworld.reachability = reachability;
+    aasworld.numAreaSettings = numAreaSettings;
+    aasworld.areasettings = areasettings;
+    aasworld.numNodes = numNodes;
+    aasworld.nodes = nodes;
+    aasworld.numPlanes = numPlanes;
+    aasworld.planes = planes;
+    return BLERR_NOERROR;
+}
+
 int AAS_LoadMap(const char *mapname,
                 int modelindexes, char *modelindex[],
                 int soundindexes, char *soundindex[],
@@ -1286,6 +1794,13 @@ int AAS_LoadMap(const char *mapname,
         }
     }
 
+    if (AAS_ReadBSPCollisionLumps(bspFile, &bspHeader, AAS_GetFileSize(bspFile)) != BLERR_NOERROR)
+    {
+        BotLib_Print(PRT_WARNING,
+                     "AAS_LoadMap: collision lumps in %s are unusable, local traces disabled\n",
+                     bspPath);
+    }
+
     fclose(bspFile);
 
     uint32_t bspChecksum = 0U;
@@ -1295,6 +1810,13 @@ int AAS_LoadMap(const char *mapname,
         return BLERR_CANNOTREADBSPHEADER;
     }
 
+    uint32_t aasChecksum = 0U;
+    if (!AAS_ComputeFileChecksum(aasPath, &aasChecksum))
+    {
+        BotLib_Print(PRT_ERROR, "AAS_LoadMap: failed to compute checksum for %s\n", aasPath);
+        return BLERR_CANNOTREADAASHEADER;
+    }
+
     FILE *aasFile = fopen(aasPath, "rb");
     if (aasFile == NULL)
     {
@@ -1348,109 +1870,27 @@ int AAS_LoadMap(const char *mapname,
         return BLERR_CANNOTREADAASHEADER;
     }
 
-    aas_area_t *areas = NULL;
-    int numAreas = 0;
-    int result = AAS_ReadLump(aasFile,
-                              &aasHeader.lumps[Q2_AAS_LUMP_AREAS],
-                              sizeof(aas_area_t),
-                              (void **)&areas,
-                              &numAreas,
-                              aasFileSize,
-                              BLERR_CANNOTSEEKTOAASFILE,
-                              BLERR_CANNOTREADAASLUMP);
-    if (result != BLERR_NOERROR)
-    {
-        fclose(aasFile);
-        return result;
-    }
-
-    aas_areasettings_t *areasettings = NULL;
-    int numAreaSettings = 0;
-    result = AAS_ReadLump(aasFile,
-                          &aasHeader.lumps[Q2_AAS_LUMP_AREASETTINGS],
-                          sizeof(aas_areasettings_t),
-                          (void **)&areasettings,
-                          &numAreaSettings,
-                          aasFileSize,
-                          BLERR_CANNOTSEEKTOAASFILE,
-                          BLERR_CANNOTREADAASLUMP);
-    if (result != BLERR_NOERROR)
+    qboolean sharedWorld = AAS_SharedWorldAttach((int)bspChecksum, (int)aasChecksum);
+    if (!sharedWorld)
     {
-        free(areas);
-        fclose(aasFile);
-        return result;
-    }
-
-    aas_reachability_t *reachability = NULL;
-    int numReachability = 0;
-    result = AAS_ReadLump(aasFile,
-                          &aasHeader.lumps[Q2_AAS_LUMP_REACHABILITY],
-                          sizeof(aas_reachability_t),
-                          (void **)&reachability,
-                          &numReachability,
-                          aasFileSize,
-                          BLERR_CANNOTSEEKTOAASFILE,
-                          BLERR_CANNOTREADAASLUMP);
-    if (result != BLERR_NOERROR)
-    {
-        free(areas);
-        free(areasettings);
-        fclose(aasFile);
-        return result;
-    }
-
-    aas_node_t *nodes = NULL;
-    int numNodes = 0;
-    result = AAS_ReadLump(aasFile,
-                          &aasHeader.lumps[Q2_AAS_LUMP_NODES],
-                          sizeof(aas_node_t),
-                          (void **)&nodes,
-                          &numNodes,
-                          aasFileSize,
-                          BLERR_CANNOTSEEKTOAASFILE,
-                          BLERR_CANNOTREADAASLUMP);
-    if (result != BLERR_NOERROR)
-    {
-        free(areas);
-        free(areasettings);
-        free(reachability);
-        fclose(aasFile);
-        return result;
+        int result = AAS_ReadWorldLumps(aasFile, &aasHeader, aasFileSize);
+        if (result != BLERR_NOERROR)
+        {
+            fclose(aasFile);
+            return result;
+        }
     }
 
     fclose(aasFile);
 
-    AAS_FixupAreas(areas, numAreas);
-    AAS_FixupAreaSettings(areasettings, numAreaSettings);
-    AAS_FixupReachability(reachability, numReachability);
-    AAS_FixupNodes(nodes, numNodes);
-
-    uint32_t aasChecksum = 0U;
-    if (!AAS_ComputeFileChecksum(aasPath, &aasChecksum))
-    {
-        BotLib_Print(PRT_ERROR, "AAS_LoadMap: failed to compute checksum for %s\n", aasPath);
-        free(areas);
-        free(areasettings);
-        free(reachability);
-        free(nodes);
-        return BLERR_CANNOTREADAASHEADER;
-    }
-
     strncpy(aasworld.aasFilePath, aasPath, sizeof(aasworld.aasFilePath) - 1U);
     aasworld.aasFilePath[sizeof(aasworld.aasFilePath) - 1U] = '\0';
 
     aasworld.bspChecksum = (int)bspChecksum;
     aasworld.aasChecksum = (int)aasChecksum;
-    aasworld.numAreas = numAreas;
-    aasworld.areas = areas;
-    aasworld.numReachability = numReachability;
-    aasworld.reachability = reachability;
-    aasworld.numAreaSettings = numAreaSettings;
-    aasworld.areasettings = areasettings;
-    aasworld.numNodes = numNodes;
-    aasworld.nodes = nodes;
     aasworld.maxEntities = 0;
     aasworld.entities = NULL;
+    aasworld.maxClients = (int)LibVarValue("maxclients", "4");
     aasworld.entitiesValid = qfalse;
     aasworld.numFrames = 0;
     aasworld.loaded = qtrue;
@@ -1466,11 +1906,23 @@ int AAS_LoadMap(const char *mapname,
     }
 
     AAS_InitTravelFlagFromType();
-    int reachStatus = AAS_PrepareReachability();
-    if (reachStatus != BLERR_NOERROR)
+    if (!sharedWorld)
+    {
+        int reachStatus = AAS_PrepareReachability();
+        if (reachStatus != BLERR_NOERROR)
+        {
+            AAS_ClearWorld();
+            return reachStatus;
+        }
+
+        AAS_SharedWorldPublish();
+    }
+
+    int overlapStatus = AAS_PrepareAreaOverlaps();
+    if (overlapStatus != BLERR_NOERROR)
     {
         AAS_ClearWorld();
-        return reachStatus;
+        return overlapStatus;
     }
 
     int areaStatus = AAS_EnsureAreaListArray();
@@ -1507,15 +1959,31 @@ static int AAS_EnsureEntityCapacity(int ent)
         return BLERR_INVALIDENTITYNUMBER;
     }
 
-    if (ent < aasworld.maxEntities)
+    /* a table built without this function still needs its collision lists */
+    if (ent < aasworld.maxEntities && aasworld.moverEntities != NULL && aasworld.boxEntities != NULL)
     {
         return BLERR_NOERROR;
     }
 
     size_t previousCount = (size_t)aasworld.maxEntities;
-    size_t requiredCount = (size_t)ent + 1U;
+    size_t requiredCount = (ent < aasworld.maxEntities) ? previousCount : (size_t)ent + 1U;
     size_t newSize = requiredCount * sizeof(aas_entity_t);
 
+    /* the collision lists can hold every entity, so listing one never fails */
+    int *movers = realloc(aasworld.moverEntities, requiredCount * sizeof(int));
+    if (movers == NULL)
+    {
+        return BLERR_INVALIDENTITYNUMBER;
+    }
+    aasworld.moverEntities = movers;
+
+    int *boxes = realloc(aasworld.boxEntities, requiredCount * sizeof(int));
+    if (boxes == NULL)
+    {
+        return BLERR_INVALIDENTITYNUMBER;
+    }
+    aasworld.boxEntities = boxes;
+
     aas_entity_t *resized = realloc(aasworld.entities, newSize);
     if (resized == NULL)
     {
@@ -1534,6 +2002,53 @@ static int AAS_EnsureEntityCapacity(int ent)
     return BLERR_NOERROR;
 }
 
+static int *AAS_CollisionList(int solid, int **count)
+{
+    if (solid == SOLID_BSP)
+    {
+        *count = &aasworld.numMoverEntities;
+        return aasworld.moverEntities;
+    }
+    if (solid == SOLID_BBOX)
+    {
+        *count = &aasworld.numBoxEntities;
+        return aasworld.boxEntities;
+    }
+
+    *count = NULL;
+    return NULL;
+}
+
+/*
+ * Moves the entity into the collision list for solid, so AAS_BSPTrace only
+ * visits entities it can clip against.  The last entry fills a removed slot.
+ */
+static void AAS_SetCollisionSolid(aas_entity_t *entity, int solid)
+{
+    if (entity->collisionSolid == solid)
+    {
+        return;
+    }
+
+    int *count = NULL;
+    int *list = AAS_CollisionList(entity->collisionSolid, &count);
+    if (list != NULL)
+    {
+        int last = list[--*count];
+        list[entity->collisionSlot] = last;
+        aasworld.entities[last].collisionSlot = entity->collisionSlot;
+    }
+
+    entity->collisionSolid = SOLID_NOT;
+    list = AAS_CollisionList(solid, &count);
+    if (list != NULL)
+    {
+        entity->collisionSlot = *count;
+        list[(*count)++] = entity->number;
+        entity->collisionSolid = solid;
+    }
+}
+
 static void AAS_ResetEntityBitset(aas_entity_t *entity)
 {
     if (entity->areaOccupancyBits != NULL && entity->areaOccupancyWords > 0U)
@@ -1619,6 +2134,7 @@ static int AAS_EnsureAreaListArray(void)
         aasworld.areaEntityLists = NULL;
         aasworld.areaEntityListCount = 0U;
     }
+    AAS_FreeOccupancyCounters();
 
     aasworld.areaEntityLists = (aas_link_t **)calloc(desired, sizeof(aas_link_t *));
     if (aasworld.areaEntityLists == NULL)
@@ -1627,9 +2143,163 @@ static int AAS_EnsureAreaListArray(void)
     }
 
     aasworld.areaEntityListCount = desired;
+
+    int numClusters = 0;
+    if (aasworld.areasettings != NULL)
+    {
+        for (int i = 0; i < aasworld.numAreaSettings; ++i)
+        {
+            if (aasworld.areasettings[i].cluster > numClusters)
+            {
+                numClusters = aasworld.areasettings[i].cluster;
+            }
+        }
+    }
+
+    aasworld.areaOccupancy = (int *)calloc(desired * AAS_OCCUPANT_NUMCLASSES, sizeof(int));
+    aasworld.clusterOccupancy =
+        (int *)calloc(((size_t)numClusters + 1U) * AAS_OCCUPANT_NUMCLASSES, sizeof(int));
+    if (aasworld.areaOccupancy == NULL || aasworld.clusterOccupancy == NULL)
+    {
+        AAS_FreeOccupancyCounters();
+        free(aasworld.areaEntityLists);
+        aasworld.areaEntityLists = NULL;
+        aasworld.areaEntityListCount = 0U;
+        return BLERR_INVALIDENTITYNUMBER;
+    }
+
+    aasworld.numClusters = numClusters;
     return BLERR_NOERROR;
 }
 
+static void AAS_FreeOccupancyCounters(void)
+{
+    free(aasworld.areaOccupancy);
+    aasworld.areaOccupancy = NULL;
+    free(aasworld.clusterOccupancy);
+    aasworld.clusterOccupancy = NULL;
+    aasworld.numClusters = 0;
+}
+
+int AAS_AreaCluster(int areanum)
+{
+    if (aasworld.areasettings == NULL || areanum <= 0 || areanum >= aasworld.numAreaSettings)
+    {
+        return 0;
+    }
+
+    return aasworld.areasettings[areanum].cluster;
+}
+
+/*
+ * Crowd counters are adjusted as links are created and removed so callers
+ * can ask how busy an area or cluster is without walking the link lists.
+ * Area counts are per link; cluster counts are per entity, so an entity
+ * straddling several areas of one cluster is only counted once.  Portal
+ * areas carry a negative cluster number and belong to no single cluster;
+ * entities in them only show up in the area counts.
+ */
+static void AAS_AdjustOccupancy(aas_link_t *link, int delta)
+{
+    if (aasworld.areaOccupancy == NULL || link->occupant < 0 ||
+        link->occupant >= AAS_OCCUPANT_NUMCLASSES)
+    {
+        return;
+    }
+
+    size_t areaIndex = (size_t)link->areanum * AAS_OCCUPANT_NUMCLASSES + (size_t)link->occupant;
+    aasworld.areaOccupancy[areaIndex] += delta;
+
+    int cluster = AAS_AreaCluster(link->areanum);
+    if (link->firstInCluster && cluster > 0 && cluster <= aasworld.numClusters &&
+        aasworld.clusterOccupancy != NULL)
+    {
+        size_t clusterIndex = (size_t)cluster * AAS_OCCUPANT_NUMCLASSES + (size_t)link->occupant;
+        aasworld.clusterOccupancy[clusterIndex] += delta;
+    }
+}
+
+static int AAS_SumOccupancy(const int *counters, int occupantMask)
+{
+    int total = 0;
+    for (int occupant = 0; occupant < AAS_OCCUPANT_NUMCLASSES; ++occupant)
+    {
+        if (occupantMask & AAS_OCCUPANT_MASK(occupant))
+        {
+            total += counters[occupant];
+        }
+    }
+
+    return total;
+}
+
+int AAS_AreaOccupancy(int areanum, int occupantMask)
+{
+    if (aasworld.areaOccupancy == NULL || areanum <= 0 ||
+        (size_t)areanum >= aasworld.areaEntityListCount)
+    {
+        return 0;
+    }
+
+    return AAS_SumOccupancy(&aasworld.areaOccupancy[(size_t)areanum * AAS_OCCUPANT_NUMCLASSES],
+                            occupantMask);
+}
+
+int AAS_ClusterOccupancy(int cluster, int occupantMask)
+{
+    if (aasworld.clusterOccupancy == NULL || cluster <= 0 || cluster > aasworld.numClusters)
+    {
+        return 0;
+    }
+
+    return AAS_SumOccupancy(&aasworld.clusterOccupancy[(size_t)cluster * AAS_OCCUPANT_NUMCLASSES],
+                            occupantMask);
+}
+
+/*
+ * Clients occupy the first maxclients slots.  Q2 projectiles are point
+ * sized SOLID_BBOX entities, items are triggers and movers are brush models
+ * or entries in the mover catalogue.  maxclients is latched by the server,
+ * so the value read at map load holds until the next one.
+ */
+static int AAS_ClassifyOccupant(const aas_entity_t *entity, qboolean isMover)
+{
+    if (entity->number >= 0 && entity->number < aasworld.maxClients)
+    {
+        return AAS_OCCUPANT_PLAYER;
+    }
+
+    if (isMover || entity->solid == SOLID_BSP)
+    {
+        return AAS_OCCUPANT_MOVER;
+    }
+
+    if (entity->solid == SOLID_TRIGGER)
+    {
+        return AAS_OCCUPANT_ITEM;
+    }
+
+    if (entity->solid == SOLID_BBOX)
+    {
+        qboolean pointSized = qtrue;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (entity->maxs[axis] - entity->mins[axis] > 8.0f)
+            {
+                pointSized = qfalse;
+                break;
+            }
+        }
+
+        if (pointSized)
+        {
+            return AAS_OCCUPANT_PROJECTILE;
+        }
+    }
+
+    return AAS_OCCUPANT_OTHER;
+}
+
 static void AAS_RemoveLinkFromAreaList(aas_link_t *link)
 {
     if (link == NULL)
@@ -1662,6 +2332,8 @@ static void AAS_RemoveLinkFromAreaList(aas_link_t *link)
     {
         link->next_ent->prev_ent = link->prev_ent;
     }
+
+    AAS_AdjustOccupancy(link, -1);
 }
 
 static void AAS_UnlinkEntityFromAreas(aas_entity_t *entity)
@@ -1683,7 +2355,7 @@ static void AAS_UnlinkEntityFromAreas(aas_entity_t *entity)
     entity->areas = NULL;
 }
 
-static int AAS_LinkEntityToArea(aas_entity_t *entity, int areanum)
+static int AAS_LinkEntityToArea(aas_entity_t *entity, int areanum, int occupant)
 {
     if (areanum < 0)
     {
@@ -1704,6 +2376,18 @@ static int AAS_LinkEntityToArea(aas_entity_t *entity, int areanum)
 
     link->entnum = entity->number;
     link->areanum = areanum;
+    link->occupant = occupant;
+    link->firstInCluster = qtrue;
+
+    int cluster = AAS_AreaCluster(areanum);
+    for (const aas_link_t *other = entity->areas; other != NULL; other = other->next_area)
+    {
+        if (AAS_AreaCluster(other->areanum) == cluster)
+        {
+            link->firstInCluster = qfalse;
+            break;
+        }
+    }
 
     link->prev_area = NULL;
     link->next_area = entity->areas;
@@ -1721,6 +2405,7 @@ static int AAS_LinkEntityToArea(aas_entity_t *entity, int areanum)
     }
     aasworld.areaEntityLists[areanum] = link;
 
+    AAS_AdjustOccupancy(link, 1);
     return BLERR_NOERROR;
 }
 
@@ -1755,7 +2440,10 @@ static void AAS_ClampMinsMaxs(vec3_t mins, vec3_t maxs)
     }
 }
 
-static int AAS_LinkEntityToComputedAreas(aas_entity_t *entity, const vec3_t absmins, const vec3_t absmaxs)
+static int AAS_LinkEntityToComputedAreas(aas_entity_t *entity,
+                                         const vec3_t absmins,
+                                         const vec3_t absmaxs,
+                                         qboolean isMover)
 {
     if (entity == NULL)
     {
@@ -1784,6 +2472,7 @@ static int AAS_LinkEntityToComputedAreas(aas_entity_t *entity, const vec3_t absm
         return status;
     }
 
+    int occupant = AAS_ClassifyOccupant(entity, isMover);
     int occupied = 0;
     for (int areanum = 1; areanum <= aasworld.numAreas; ++areanum)
     {
@@ -1793,7 +2482,7 @@ static int AAS_LinkEntityToComputedAreas(aas_entity_t *entity, const vec3_t absm
             continue;
         }
 
-        status = AAS_LinkEntityToArea(entity, areanum);
+        status = AAS_LinkEntityToArea(entity, areanum, occupant);
         if (status != BLERR_NOERROR)
         {
             return status;
@@ -1842,6 +2531,7 @@ int AAS_UpdateEntity(int ent, const AASEntityFrame *state)
     {
         AAS_UnlinkEntityFromAreas(entity);
         AAS_ResetEntityBitset(entity);
+        AAS_SetCollisionSolid(entity, SOLID_NOT);
         entity->inuse = qfalse;
         entity->outsideAllAreas = qtrue;
         entity->lastOutsideUpdate = aasworld.time;
@@ -1852,6 +2542,7 @@ int AAS_UpdateEntity(int ent, const AASEntityFrame *state)
 
     entity->inuse = qtrue;
     entity->solid = state->solid;
+    AAS_SetCollisionSolid(entity, entity->solid);
     entity->modelindex = state->modelindex;
     entity->modelindex2 = state->modelindex2;
     entity->modelindex3 = state->modelindex3;
@@ -1881,7 +2572,10 @@ int AAS_UpdateEntity(int ent, const AASEntityFrame *state)
         VectorAdd(entity->origin, entity->maxs, absmaxs);
         AAS_ClampMinsMaxs(absmins, absmaxs);
 
-        int linkStatus = AAS_LinkEntityToComputedAreas(entity, absmins, absmaxs);
+        int linkStatus = AAS_LinkEntityToComputedAreas(entity,
+                                                       absmins,
+                                                       absmaxs,
+                                                       state->is_mover ? qtrue : qfalse);
         if (linkStatus != BLERR_NOERROR)
         {
             return linkStatus;
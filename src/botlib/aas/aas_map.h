@@ -49,6 +49,70 @@ typedef struct q2_bsp_header_s
     q2_lump_t lumps[Q2_BSP_LUMP_MAX];
 } q2_bsp_header_t;
 
+/* Collision lumps consumed by the bot-local trace (qfiles.h layouts). */
+
+typedef struct q2_dplane_s
+{
+    float normal[3];
+    float dist;
+    int32_t type;
+} q2_dplane_t;
+
+typedef struct q2_dnode_s
+{
+    int32_t planenum;
+    int32_t children[2]; /* negative numbers are -(leafs+1) */
+    int16_t mins[3];
+    int16_t maxs[3];
+    uint16_t firstface;
+    uint16_t numfaces;
+} q2_dnode_t;
+
+typedef struct q2_dleaf_s
+{
+    int32_t contents;
+    int16_t cluster;
+    int16_t area;
+    int16_t mins[3];
+    int16_t maxs[3];
+    uint16_t firstleafface;
+    uint16_t numleaffaces;
+    uint16_t firstleafbrush;
+    uint16_t numleafbrushes;
+} q2_dleaf_t;
+
+typedef struct q2_dbrush_s
+{
+    int32_t firstside;
+    int32_t numsides;
+    int32_t contents;
+} q2_dbrush_t;
+
+typedef struct q2_dbrushside_s
+{
+    uint16_t planenum;
+    int16_t texinfo;
+} q2_dbrushside_t;
+
+typedef struct q2_texinfo_s
+{
+    float vecs[2][4];
+    int32_t flags;
+    int32_t value;
+    char texture[32];
+    int32_t nexttexinfo;
+} q2_texinfo_t;
+
+typedef struct q2_dmodel_s
+{
+    float mins[3];
+    float maxs[3];
+    float origin[3];
+    int32_t headnode;
+    int32_t firstface;
+    int32_t numfaces;
+} q2_dmodel_t;
+
 /*
  * Quake II AAS file layout -------------------------------------------------
  */
@@ -92,6 +156,8 @@ int AAS_LoadMap(const char *mapname,
                 int soundindexes, char *soundindex[],
                 int imageindexes, char *imageindex[]);
 
+int AAS_LoadBSPCollision(const char *bspPath);
+
 int AAS_Init(void);
 void AAS_Shutdown(void);
 
@@ -0,0 +1,544 @@
+#include "aas_local.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "botlib/interface/botlib_interface.h"
+
+/*
+ * Client movement prediction against the bot-local collision hull.  The
+ * physics follow Quake II pmove (friction, acceleration, gravity and the
+ * step/slide move) closely enough to tell where a jump or a drop lands and
+ * whether it ends in lava or slime, without any trace imports.
+ */
+
+#define AAS_PREDICT_ACCELERATE       10.0f
+#define AAS_PREDICT_WATERACCELERATE  10.0f
+#define AAS_PREDICT_AIRWISHSPEED     30.0f
+#define AAS_PREDICT_VIEWHEIGHT       22.0f
+#define AAS_PREDICT_STANDHEIGHT      32.0f
+#define AAS_PREDICT_MAXCLIPPLANES    5
+#define AAS_PREDICT_NUMBUMPS         4
+#define AAS_PREDICT_OVERCLIP         1.01f
+#define AAS_PREDICT_GROUNDDIST       0.25f
+#define AAS_PREDICT_MAXGROUNDZVEL    180.0f
+#define AAS_PREDICT_WATERSINK        60.0f
+#define AAS_PREDICT_FALLDAMAGE       30.0f /* P_FallingDamage threshold on delta^2 * 0.0001 */
+
+typedef struct aas_predictphysics_s
+{
+    float gravity;
+    float friction;
+    float stopspeed;
+    float maxwalkvelocity;
+    float maxcrouchvelocity;
+    float maxswimvelocity;
+    float jumpvel;
+    float airaccelerate;
+    float maxstep;
+    float maxsteepness;
+    float waterfriction;
+} aas_predictphysics_t;
+
+typedef struct aas_predictstate_s
+{
+    vec3_t origin;
+    vec3_t velocity;
+    vec3_t mins;
+    vec3_t maxs;
+    int entnum;
+    float frametime;
+} aas_predictstate_t;
+
+static float AAS_PredictVectorLength(const vec3_t v)
+{
+    return sqrtf(DotProduct(v, v));
+}
+
+static float AAS_PredictVectorNormalize(vec3_t v)
+{
+    float length = AAS_PredictVectorLength(v);
+    if (length > 0.0f)
+    {
+        float inv = 1.0f / length;
+        v[0] *= inv;
+        v[1] *= inv;
+        v[2] *= inv;
+    }
+    return length;
+}
+
+static void AAS_PredictVectorMA(const vec3_t start, float scale, const vec3_t dir, vec3_t out)
+{
+    out[0] = start[0] + scale * dir[0];
+    out[1] = start[1] + scale * dir[1];
+    out[2] = start[2] + scale * dir[2];
+}
+
+static void AAS_PredictVectorScale(const vec3_t in, float scale, vec3_t out)
+{
+    out[0] = in[0] * scale;
+    out[1] = in[1] * scale;
+    out[2] = in[2] * scale;
+}
+
+static float AAS_PredictValue(float value, float fallback)
+{
+    return (value > 0.0f) ? value : fallback;
+}
+
+static void AAS_PredictLoadPhysics(aas_predictphysics_t *phys)
+{
+    const botlib_library_variables_t *vars = BotInterface_GetLibraryVariables();
+
+    phys->gravity = AAS_PredictValue(vars->sv_gravity, 800.0f);
+    phys->friction = AAS_PredictValue(vars->sv_friction, 6.0f);
+    phys->stopspeed = AAS_PredictValue(vars->sv_stopspeed, 100.0f);
+    phys->maxwalkvelocity = AAS_PredictValue(vars->sv_maxwalkvelocity, 300.0f);
+    phys->maxcrouchvelocity = AAS_PredictValue(vars->sv_maxcrouchvelocity, 100.0f);
+    phys->maxswimvelocity = AAS_PredictValue(vars->sv_maxswimvelocity, 150.0f);
+    phys->jumpvel = AAS_PredictValue(vars->sv_jumpvel, 224.0f);
+    phys->airaccelerate = (vars->sv_airaccelerate > 0.0f) ? vars->sv_airaccelerate : 0.0f;
+    phys->maxstep = AAS_PredictValue(vars->sv_maxstep, 18.0f);
+    phys->maxsteepness = AAS_PredictValue(vars->sv_maxsteepness, 0.7f);
+    phys->waterfriction = AAS_PredictValue(vars->sv_waterfriction, 1.0f);
+}
+
+static void AAS_PredictClipVelocity(const vec3_t in, const vec3_t normal, vec3_t out)
+{
+    float backoff = DotProduct(in, normal) * AAS_PREDICT_OVERCLIP;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        out[axis] = in[axis] - normal[axis] * backoff;
+        if (out[axis] > -0.1f && out[axis] < 0.1f)
+        {
+            out[axis] = 0.0f;
+        }
+    }
+}
+
+/* PM_StepSlideMove_: returns false when the box is stuck in solid. */
+static bool AAS_PredictSlideMove(aas_predictstate_t *ps)
+{
+    vec3_t planes[AAS_PREDICT_MAXCLIPPLANES];
+    vec3_t primal;
+    VectorCopy(ps->velocity, primal);
+    int numplanes = 0;
+    float timeleft = ps->frametime;
+
+    for (int bump = 0; bump < AAS_PREDICT_NUMBUMPS; ++bump)
+    {
+        vec3_t end;
+        AAS_PredictVectorMA(ps->origin, timeleft, ps->velocity, end);
+        bsp_trace_t trace = AAS_BSPTrace(ps->origin, ps->mins, ps->maxs, end, ps->entnum, MASK_PLAYERSOLID);
+        if (trace.allsolid)
+        {
+            ps->velocity[2] = 0.0f;
+            return false;
+        }
+
+        if (trace.fraction > 0.0f)
+        {
+            VectorCopy(trace.endpos, ps->origin);
+            numplanes = 0;
+        }
+        if (trace.fraction == 1.0f)
+        {
+            break;
+        }
+
+        timeleft -= timeleft * trace.fraction;
+        if (numplanes >= AAS_PREDICT_MAXCLIPPLANES)
+        {
+            VectorClear(ps->velocity);
+            break;
+        }
+        VectorCopy(trace.plane.normal, planes[numplanes]);
+        ++numplanes;
+
+        int i;
+        for (i = 0; i < numplanes; ++i)
+        {
+            AAS_PredictClipVelocity(ps->velocity, planes[i], ps->velocity);
+            int j;
+            for (j = 0; j < numplanes; ++j)
+            {
+                if (j != i && DotProduct(ps->velocity, planes[j]) < 0.0f)
+                {
+                    break;
+                }
+            }
+            if (j == numplanes)
+            {
+                break;
+            }
+        }
+
+        if (i == numplanes)
+        {
+            /* slide along the crease of two planes */
+            if (numplanes != 2)
+            {
+                VectorClear(ps->velocity);
+                break;
+            }
+            vec3_t dir;
+            dir[0] = planes[0][1] * planes[1][2] - planes[0][2] * planes[1][1];
+            dir[1] = planes[0][2] * planes[1][0] - planes[0][0] * planes[1][2];
+            dir[2] = planes[0][0] * planes[1][1] - planes[0][1] * planes[1][0];
+            float d = DotProduct(dir, ps->velocity);
+            AAS_PredictVectorScale(dir, d, ps->velocity);
+        }
+
+        /* never turn back against the original direction */
+        if (DotProduct(ps->velocity, primal) <= 0.0f)
+        {
+            VectorClear(ps->velocity);
+            break;
+        }
+    }
+
+    return true;
+}
+
+/* PM_StepSlideMove: keep whichever of the plain and the stepped move got further. */
+static void AAS_PredictStepSlideMove(aas_predictstate_t *ps, const aas_predictphysics_t *phys)
+{
+    vec3_t startorigin;
+    vec3_t startvelocity;
+    VectorCopy(ps->origin, startorigin);
+    VectorCopy(ps->velocity, startvelocity);
+
+    AAS_PredictSlideMove(ps);
+
+    vec3_t downorigin;
+    vec3_t downvelocity;
+    VectorCopy(ps->origin, downorigin);
+    VectorCopy(ps->velocity, downvelocity);
+
+    vec3_t up;
+    VectorCopy(startorigin, up);
+    up[2] += phys->maxstep;
+    bsp_trace_t trace = AAS_BSPTrace(up, ps->mins, ps->maxs, up, ps->entnum, MASK_PLAYERSOLID);
+    if (trace.allsolid)
+    {
+        /* no room to step up */
+        return;
+    }
+
+    VectorCopy(up, ps->origin);
+    VectorCopy(startvelocity, ps->velocity);
+    AAS_PredictSlideMove(ps);
+
+    vec3_t down;
+    VectorCopy(ps->origin, down);
+    down[2] -= phys->maxstep;
+    trace = AAS_BSPTrace(ps->origin, ps->mins, ps->maxs, down, ps->entnum, MASK_PLAYERSOLID);
+    if (!trace.allsolid)
+    {
+        VectorCopy(trace.endpos, ps->origin);
+    }
+
+    float downdist = (downorigin[0] - startorigin[0]) * (downorigin[0] - startorigin[0])
+                     + (downorigin[1] - startorigin[1]) * (downorigin[1] - startorigin[1]);
+    float updist = (ps->origin[0] - startorigin[0]) * (ps->origin[0] - startorigin[0])
+                   + (ps->origin[1] - startorigin[1]) * (ps->origin[1] - startorigin[1]);
+    if (downdist > updist || trace.plane.normal[2] < phys->maxsteepness)
+    {
+        VectorCopy(downorigin, ps->origin);
+        VectorCopy(downvelocity, ps->velocity);
+        return;
+    }
+
+    ps->velocity[2] = downvelocity[2];
+}
+
+static bool AAS_PredictOnGround(const aas_predictstate_t *ps, const aas_predictphysics_t *phys)
+{
+    if (ps->velocity[2] > AAS_PREDICT_MAXGROUNDZVEL)
+    {
+        return false;
+    }
+
+    vec3_t point;
+    VectorCopy(ps->origin, point);
+    point[2] -= AAS_PREDICT_GROUNDDIST;
+    bsp_trace_t trace = AAS_BSPTrace(ps->origin, ps->mins, ps->maxs, point, ps->entnum, MASK_PLAYERSOLID);
+    if (trace.fraction == 1.0f || trace.allsolid)
+    {
+        return false;
+    }
+
+    return trace.plane.normal[2] >= phys->maxsteepness;
+}
+
+static int AAS_PredictFeetContents(const aas_predictstate_t *ps, int *waterlevel)
+{
+    vec3_t point;
+    VectorCopy(ps->origin, point);
+    point[2] += ps->mins[2] + 1.0f;
+    int contents = AAS_BSPPointContents(point);
+
+    *waterlevel = 0;
+    if (contents & MASK_WATER)
+    {
+        *waterlevel = 1;
+        point[2] = ps->origin[2] + ps->mins[2] + (AAS_PREDICT_VIEWHEIGHT - ps->mins[2]) * 0.5f;
+        if (AAS_BSPPointContents(point) & MASK_WATER)
+        {
+            *waterlevel = 2;
+        }
+    }
+
+    return contents;
+}
+
+static void AAS_PredictFriction(aas_predictstate_t *ps,
+                                const aas_predictphysics_t *phys,
+                                bool onground,
+                                int waterlevel)
+{
+    float speed = AAS_PredictVectorLength(ps->velocity);
+    if (speed < 1.0f)
+    {
+        ps->velocity[0] = 0.0f;
+        ps->velocity[1] = 0.0f;
+        return;
+    }
+
+    float drop = 0.0f;
+    if (onground)
+    {
+        float control = (speed < phys->stopspeed) ? phys->stopspeed : speed;
+        drop += control * phys->friction * ps->frametime;
+    }
+    if (waterlevel > 0)
+    {
+        drop += speed * phys->waterfriction * (float)waterlevel * ps->frametime;
+    }
+
+    float newspeed = speed - drop;
+    if (newspeed < 0.0f)
+    {
+        newspeed = 0.0f;
+    }
+    AAS_PredictVectorScale(ps->velocity, newspeed / speed, ps->velocity);
+}
+
+static void AAS_PredictAccelerate(aas_predictstate_t *ps,
+                                  const vec3_t wishdir,
+                                  float wishspeed,
+                                  float accel,
+                                  float wishcap)
+{
+    float currentspeed = DotProduct(ps->velocity, wishdir);
+    float addspeed = ((wishspeed < wishcap) ? wishspeed : wishcap) - currentspeed;
+    if (addspeed <= 0.0f)
+    {
+        return;
+    }
+
+    float accelspeed = accel * wishspeed * ps->frametime;
+    if (accelspeed > addspeed)
+    {
+        accelspeed = addspeed;
+    }
+    AAS_PredictVectorMA(ps->velocity, accelspeed, wishdir, ps->velocity);
+}
+
+/*
+ * Simulates a client from origin for up to maxframes frames of frametime
+ * seconds.  cmdmove is the wished velocity applied during the first
+ * cmdframes frames; a positive cmdmove[2] jumps when on the ground, or
+ * swims upwards in water.  mins/maxs default to the standing player box.
+ * Every event seen is accumulated in move->events, and the prediction stops
+ * at the first event in stopevent; SE_ENTERAREA and SE_HITGROUNDAREA refer
+ * to stopareanum.  Returns true when a stop event ended the prediction and
+ * false when it ran out of frames or the collision hull is unavailable.
+ */
+bool AAS_PredictClientMovement(aas_clientmove_t *move,
+                               int entnum,
+                               const vec3_t origin,
+                               const vec3_t mins,
+                               const vec3_t maxs,
+                               bool onground,
+                               const vec3_t velocity,
+                               const vec3_t cmdmove,
+                               int cmdframes,
+                               int maxframes,
+                               float frametime,
+                               int stopevent,
+                               int stopareanum)
+{
+    if (move == NULL)
+    {
+        return false;
+    }
+
+    memset(move, 0, sizeof(*move));
+    if (origin == NULL)
+    {
+        return false;
+    }
+    VectorCopy(origin, move->endpos);
+    if (velocity != NULL)
+    {
+        VectorCopy(velocity, move->velocity);
+    }
+
+    if (!AAS_BSPCollisionLoaded() || maxframes <= 0 || frametime <= 0.0f)
+    {
+        return false;
+    }
+
+    aas_predictphysics_t phys;
+    AAS_PredictLoadPhysics(&phys);
+
+    aas_predictstate_t ps;
+    VectorCopy(origin, ps.origin);
+    VectorCopy(move->velocity, ps.velocity);
+    if (mins != NULL && maxs != NULL)
+    {
+        VectorCopy(mins, ps.mins);
+        VectorCopy(maxs, ps.maxs);
+    }
+    else
+    {
+        VectorSet(ps.mins, -16.0f, -16.0f, -24.0f);
+        VectorSet(ps.maxs, 16.0f, 16.0f, AAS_PREDICT_STANDHEIGHT);
+    }
+    ps.entnum = entnum;
+    ps.frametime = frametime;
+
+    bool crouched = ps.maxs[2] < AAS_PREDICT_STANDHEIGHT;
+    int waterlevel = 0;
+    int contents = AAS_PredictFeetContents(&ps, &waterlevel);
+    int areanum = AAS_PointAreaNum(ps.origin);
+
+    for (int frame = 0; frame < maxframes; ++frame)
+    {
+        vec3_t wishvel = {0.0f, 0.0f, 0.0f};
+        if (cmdmove != NULL && frame < cmdframes)
+        {
+            VectorCopy(cmdmove, wishvel);
+        }
+
+        bool jumped = false;
+        if (waterlevel >= 2)
+        {
+            AAS_PredictFriction(&ps, &phys, false, waterlevel);
+            if (wishvel[0] == 0.0f && wishvel[1] == 0.0f && wishvel[2] <= 0.0f)
+            {
+                wishvel[2] -= AAS_PREDICT_WATERSINK;
+            }
+            vec3_t wishdir;
+            float wishspeed = AAS_PredictVectorLength(wishvel);
+            VectorCopy(wishvel, wishdir);
+            AAS_PredictVectorNormalize(wishdir);
+            if (wishspeed > phys.maxswimvelocity)
+            {
+                wishspeed = phys.maxswimvelocity;
+            }
+            wishspeed *= 0.5f;
+            AAS_PredictAccelerate(&ps, wishdir, wishspeed, AAS_PREDICT_WATERACCELERATE, wishspeed);
+        }
+        else
+        {
+            if (onground && wishvel[2] > 0.0f)
+            {
+                ps.velocity[2] = phys.jumpvel;
+                onground = false;
+                jumped = true;
+            }
+
+            AAS_PredictFriction(&ps, &phys, onground, waterlevel);
+
+            vec3_t wishdir = {wishvel[0], wishvel[1], 0.0f};
+            float wishspeed = AAS_PredictVectorNormalize(wishdir);
+            float maxspeed = crouched ? phys.maxcrouchvelocity : phys.maxwalkvelocity;
+            if (wishspeed > maxspeed)
+            {
+                wishspeed = maxspeed;
+            }
+
+            if (onground)
+            {
+                ps.velocity[2] = 0.0f;
+                AAS_PredictAccelerate(&ps, wishdir, wishspeed, AAS_PREDICT_ACCELERATE, wishspeed);
+            }
+            else
+            {
+                if (phys.airaccelerate > 0.0f)
+                {
+                    AAS_PredictAccelerate(&ps, wishdir, wishspeed, phys.airaccelerate, AAS_PREDICT_AIRWISHSPEED);
+                }
+                else
+                {
+                    AAS_PredictAccelerate(&ps, wishdir, wishspeed, 1.0f, wishspeed);
+                }
+                ps.velocity[2] -= phys.gravity * frametime;
+            }
+        }
+
+        float fallspeed = ps.velocity[2];
+        AAS_PredictStepSlideMove(&ps, &phys);
+
+        bool wasonground = onground;
+        onground = AAS_PredictOnGround(&ps, &phys);
+        int lastcontents = contents;
+        contents = AAS_PredictFeetContents(&ps, &waterlevel);
+        int lastareanum = areanum;
+        areanum = AAS_PointAreaNumHinted(ps.origin, areanum);
+
+        int events = SE_NONE;
+        if ((contents & CONTENTS_LAVA) && !(lastcontents & CONTENTS_LAVA))
+        {
+            events |= SE_ENTERLAVA;
+        }
+        if ((contents & CONTENTS_SLIME) && !(lastcontents & CONTENTS_SLIME))
+        {
+            events |= SE_ENTERSLIME;
+        }
+        if ((contents & CONTENTS_WATER) && !(lastcontents & CONTENTS_WATER))
+        {
+            events |= SE_ENTERWATER;
+        }
+        if (onground && !wasonground && !jumped)
+        {
+            events |= SE_HITGROUND;
+            if (fallspeed * fallspeed * 0.0001f > AAS_PREDICT_FALLDAMAGE)
+            {
+                events |= SE_HITGROUNDDAMAGE;
+            }
+            if (stopareanum > 0 && areanum == stopareanum)
+            {
+                events |= SE_HITGROUNDAREA;
+            }
+        }
+        if (!onground && wasonground && !jumped)
+        {
+            events |= SE_LEAVEGROUND;
+        }
+        if (stopareanum > 0 && areanum == stopareanum && lastareanum != stopareanum)
+        {
+            events |= SE_ENTERAREA;
+        }
+
+        move->events |= events;
+        move->frames = frame + 1;
+        move->time = (float)move->frames * frametime;
+        if (events & stopevent)
+        {
+            move->stopevent = events & stopevent;
+            break;
+        }
+    }
+
+    VectorCopy(ps.origin, move->endpos);
+    VectorCopy(ps.velocity, move->velocity);
+    move->endarea = areanum;
+    move->endcontents = contents;
+    return move->stopevent != SE_NONE;
+}
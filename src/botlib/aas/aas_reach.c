@@ -20,6 +20,13 @@ static aas_reachability_frame_state_t g_reach_frame_state;
 
 static void AAS_FreeReverseReachability(void)
 {
+    if (aasworld.reversedReachability != NULL && aasworld.sharedData)
+    {
+        /* The index lists live in the shared segment; only the table is local. */
+        free(aasworld.reversedReachability);
+        aasworld.reversedReachability = NULL;
+    }
+
     if (aasworld.reversedReachability != NULL)
     {
         int areaCount = (aasworld.numAreas > 0) ? aasworld.numAreas : 0;
@@ -37,8 +44,12 @@ static void AAS_FreeReverseReachability(void)
 void AAS_ClearReachabilityData(void)
 {
     AAS_FreeReverseReachability();
-    free(aasworld.reachabilityFromArea);
+    if (!aasworld.sharedData)
+    {
+        free(aasworld.reachabilityFromArea);
+    }
     aasworld.reachabilityFromArea = NULL;
+    aasworld.reachabilityEpoch++;
 }
 
 int AAS_PrepareReachability(void)
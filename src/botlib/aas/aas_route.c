@@ -7,6 +7,7 @@
 
 #include "botlib/common/l_log.h"
 #include "botlib/common/l_libvar.h"
+#include "botlib/common/l_memory.h"
 #include "q2bridge/bridge_config.h"
 
 #define ROUTECACHE_TABLE_SIZE 256U
@@ -18,9 +19,14 @@ typedef struct
     int frames_skipped;
     int last_budget;
     bool forcewrite_active;
+    int memo_lookups;
+    int memo_hits;
+    int last_memo_lookups;
+    int last_memo_hits;
 } aas_route_frame_state_t;
 
 static aas_route_frame_state_t g_route_frame_state;
+static aas_travelmemo_t *g_route_travel_memo = NULL;
 
 typedef struct
 {
@@ -45,7 +51,7 @@ static int Heap_Init(routing_minheap_t *heap, int initialCapacity)
         return 1;
     }
 
-    heap->nodes = (routing_heap_node_t *)malloc((size_t)heap->capacity * sizeof(routing_heap_node_t));
+    heap->nodes = (routing_heap_node_t *)BotMemory_Malloc((size_t)heap->capacity * sizeof(routing_heap_node_t));
     if (heap->nodes == NULL)
     {
         heap->capacity = 0;
@@ -68,7 +74,7 @@ static int Heap_Push(routing_minheap_t *heap, int area, unsigned int time)
     if (heap->capacity == 0)
     {
         heap->capacity = 16;
-        heap->nodes = (routing_heap_node_t *)malloc((size_t)heap->capacity * sizeof(routing_heap_node_t));
+        heap->nodes = (routing_heap_node_t *)BotMemory_Malloc((size_t)heap->capacity * sizeof(routing_heap_node_t));
         if (heap->nodes == NULL)
         {
             heap->capacity = 0;
@@ -84,7 +90,7 @@ static int Heap_Push(routing_minheap_t *heap, int area, unsigned int time)
         }
 
         routing_heap_node_t *grown =
-            (routing_heap_node_t *)realloc(heap->nodes, (size_t)newCapacity * sizeof(routing_heap_node_t));
+            (routing_heap_node_t *)BotMemory_Realloc(heap->nodes, (size_t)newCapacity * sizeof(routing_heap_node_t));
         if (grown == NULL)
         {
             return 0;
@@ -170,8 +176,8 @@ static int RouteCache_EnsureTable(void)
         return 1;
     }
 
-    aasworld.routingCacheTable = (aas_routingcache_t **)calloc(ROUTECACHE_TABLE_SIZE,
-                                                               sizeof(aas_routingcache_t *));
+    aasworld.routingCacheTable = (aas_routingcache_t **)BotMemory_Calloc(ROUTECACHE_TABLE_SIZE,
+                                                                         sizeof(aas_routingcache_t *));
     if (aasworld.routingCacheTable == NULL)
     {
         return 0;
@@ -261,13 +267,13 @@ static aas_routingcache_t *RouteCache_Alloc(int goalArea, int travelflags)
 {
     size_t numAreas = (aasworld.numAreas > 0) ? (size_t)aasworld.numAreas + 1U : 1U;
 
-    aas_routingcache_t *cache = (aas_routingcache_t *)calloc(1, sizeof(aas_routingcache_t));
+    aas_routingcache_t *cache = (aas_routingcache_t *)BotMemory_Calloc(1, sizeof(aas_routingcache_t));
     if (cache == NULL)
     {
         return NULL;
     }
 
-    cache->traveltimes = (unsigned short *)malloc(numAreas * sizeof(unsigned short));
+    cache->traveltimes = (unsigned short *)BotMemory_Malloc(numAreas * sizeof(unsigned short));
     if (cache->traveltimes == NULL)
     {
         free(cache);
@@ -313,6 +319,7 @@ void AAS_FreeAllRoutingCaches(void)
 void AAS_InvalidateRouteCache(void)
 {
     AAS_FreeAllRoutingCaches();
+    aasworld.routeEpoch++;
 }
 
 void AAS_InitTravelFlagFromType(void)
@@ -343,7 +350,7 @@ void AAS_InitTravelFlagFromType(void)
     aasworld.travelflagfortype[TRAVEL_FUNCBOB] = TFL_FUNCBOB;
 }
 
-static int AAS_TravelFlagForType(int traveltype)
+int AAS_TravelFlagForType(int traveltype)
 {
     int flags = 0;
     if (traveltype & TRAVELFLAG_NOTTEAM1)
@@ -516,6 +523,63 @@ static aas_routingcache_t *RouteCache_Get(int goalArea, int travelflags)
     return cache;
 }
 
+/* drops the memo's entries when the frame or the routes have moved on */
+static void AAS_TravelMemoValidate(aas_travelmemo_t *memo)
+{
+    if (memo->stamp != 0 && memo->frame == aasworld.numFrames && memo->epoch == aasworld.routeEpoch)
+    {
+        return;
+    }
+
+    memo->stamp += 1;
+    if (memo->stamp == 0)
+    {
+        memset(memo->entries, 0, sizeof(memo->entries));
+        memo->stamp = 1;
+    }
+    memo->frame = aasworld.numFrames;
+    memo->epoch = aasworld.routeEpoch;
+}
+
+void AAS_SetTravelMemo(aas_travelmemo_t *memo)
+{
+    g_route_travel_memo = memo;
+    if (memo != NULL)
+    {
+        AAS_TravelMemoValidate(memo);
+    }
+}
+
+static aas_travelmemo_entry_t *AAS_TravelMemoSlot(aas_travelmemo_t *memo,
+                                                  int areanum,
+                                                  int goalareanum,
+                                                  int travelflags,
+                                                  bool *found)
+{
+    unsigned int hash = (unsigned int)areanum * 73856093u ^ (unsigned int)goalareanum * 19349663u
+                        ^ (unsigned int)travelflags * 83492791u;
+    unsigned int home = hash & (AAS_TRAVELMEMO_SIZE - 1);
+
+    /* a short probe run; when it is full the home slot is overwritten */
+    for (unsigned int probe = 0; probe < 8; ++probe)
+    {
+        aas_travelmemo_entry_t *entry = &memo->entries[(home + probe) & (AAS_TRAVELMEMO_SIZE - 1)];
+        if (entry->stamp != memo->stamp)
+        {
+            *found = false;
+            return entry;
+        }
+        if (entry->areanum == areanum && entry->goalareanum == goalareanum && entry->travelflags == travelflags)
+        {
+            *found = true;
+            return entry;
+        }
+    }
+
+    *found = false;
+    return &memo->entries[home];
+}
+
 int AAS_AreaTravelTimeToGoalArea(int areanum, vec3_t origin, int goalareanum, int travelflags)
 {
     if (!aasworld.loaded)
@@ -540,13 +604,41 @@ int AAS_AreaTravelTimeToGoalArea(int areanum, vec3_t origin, int goalareanum, in
         return (int)AAS_LocalTravelTime(areanum, origin);
     }
 
-    aas_routingcache_t *cache = RouteCache_Get(goalareanum, travelflags);
-    if (cache == NULL)
+    aas_travelmemo_t *memo = g_route_travel_memo;
+    aas_travelmemo_entry_t *slot = NULL;
+    bool found = false;
+    if (memo != NULL)
     {
-        return 0;
+        AAS_TravelMemoValidate(memo);
+        slot = AAS_TravelMemoSlot(memo, areanum, goalareanum, travelflags, &found);
+        g_route_frame_state.memo_lookups += 1;
+    }
+
+    unsigned short base;
+    if (found)
+    {
+        g_route_frame_state.memo_hits += 1;
+        base = slot->traveltime;
+    }
+    else
+    {
+        aas_routingcache_t *cache = RouteCache_Get(goalareanum, travelflags);
+        if (cache == NULL)
+        {
+            return 0;
+        }
+
+        base = cache->traveltimes[areanum];
+        if (slot != NULL)
+        {
+            slot->areanum = areanum;
+            slot->goalareanum = goalareanum;
+            slot->travelflags = travelflags;
+            slot->traveltime = base;
+            slot->stamp = memo->stamp;
+        }
     }
 
-    unsigned short base = cache->traveltimes[areanum];
     if (base == 0 || base == (unsigned short)ROUTE_INVALID_TIME)
     {
         return 0;
@@ -561,6 +653,155 @@ int AAS_AreaTravelTimeToGoalArea(int areanum, vec3_t origin, int goalareanum, in
     return (int)total;
 }
 
+/*
+ * Scratch for AAS_AreasWithinTravelTime, kept between calls so that a search
+ * only touches the areas it expands.  Entries hold ROUTE_INVALID_TIME unless a
+ * search is in progress.
+ */
+static unsigned short *g_route_local_times = NULL;
+static int *g_route_local_touched = NULL;
+static int g_route_local_size = 0;
+static routing_minheap_t g_route_local_heap;
+
+void AAS_FreeLocalRouteScratch(void)
+{
+    free(g_route_local_times);
+    free(g_route_local_touched);
+    Heap_Destroy(&g_route_local_heap);
+    g_route_local_times = NULL;
+    g_route_local_touched = NULL;
+    g_route_local_size = 0;
+}
+
+static bool AAS_EnsureLocalRouteScratch(void)
+{
+    int size = aasworld.numAreas + 1;
+    if (g_route_local_times != NULL && g_route_local_size == size)
+    {
+        return true;
+    }
+
+    AAS_FreeLocalRouteScratch();
+    g_route_local_times = (unsigned short *)BotMemory_Malloc((size_t)size * sizeof(unsigned short));
+    g_route_local_touched = (int *)BotMemory_Malloc((size_t)size * sizeof(int));
+    if (g_route_local_times == NULL || g_route_local_touched == NULL || !Heap_Init(&g_route_local_heap, 64))
+    {
+        AAS_FreeLocalRouteScratch();
+        return false;
+    }
+
+    for (int area = 0; area < size; ++area)
+    {
+        g_route_local_times[area] = (unsigned short)ROUTE_INVALID_TIME;
+    }
+    g_route_local_size = size;
+    return true;
+}
+
+/*
+ * Expands outwards from areanum along the reachabilities allowed by
+ * travelflags and stores every area whose travel time from origin is at most
+ * maxtime, nearest first.  The times match AAS_AreaTravelTimeToGoalArea but
+ * only the neighbourhood is visited, no routing cache is built.  Returns the
+ * number of areas stored.
+ */
+int AAS_AreasWithinTravelTime(int areanum,
+                              const vec3_t origin,
+                              int travelflags,
+                              int maxtime,
+                              int *areas,
+                              int *traveltimes,
+                              int maxareas)
+{
+    if (areas == NULL || traveltimes == NULL || maxareas <= 0 || maxtime < 0)
+    {
+        return 0;
+    }
+
+    if (!aasworld.loaded || aasworld.areas == NULL || areanum <= 0 || areanum > aasworld.numAreas)
+    {
+        return 0;
+    }
+
+    unsigned int local = AAS_LocalTravelTime(areanum, origin);
+    if (local > (unsigned int)maxtime || !AAS_EnsureLocalRouteScratch())
+    {
+        return 0;
+    }
+
+    int numtouched = 0;
+    g_route_local_heap.size = 0;
+    g_route_local_times[areanum] = 0;
+    g_route_local_touched[numtouched++] = areanum;
+    Heap_Push(&g_route_local_heap, areanum, 0);
+
+    int count = 0;
+    while (g_route_local_heap.size > 0 && count < maxareas)
+    {
+        routing_heap_node_t node = Heap_Pop(&g_route_local_heap);
+        if (node.time != g_route_local_times[node.area])
+        {
+            continue;
+        }
+
+        areas[count] = node.area;
+        traveltimes[count] = (int)(node.time + local);
+        ++count;
+
+        if (aasworld.areasettings == NULL || node.area >= aasworld.numAreaSettings || aasworld.reachability == NULL)
+        {
+            continue;
+        }
+
+        const aas_areasettings_t *settings = &aasworld.areasettings[node.area];
+        int first = settings->firstreachablearea;
+        int last = first + settings->numreachableareas;
+        if (first < 0 || last > aasworld.numReachability)
+        {
+            continue;
+        }
+
+        for (int reachIndex = first; reachIndex < last; ++reachIndex)
+        {
+            const aas_reachability_t *reach = &aasworld.reachability[reachIndex];
+            if (reach->areanum <= 0 || reach->areanum > aasworld.numAreas)
+            {
+                continue;
+            }
+
+            int required = AAS_TravelFlagForType(reach->traveltype);
+            if ((required & travelflags) != required)
+            {
+                continue;
+            }
+
+            unsigned int cost = node.time + reach->traveltime;
+            if (cost + local > (unsigned int)maxtime || cost >= g_route_local_times[reach->areanum])
+            {
+                continue;
+            }
+
+            if (g_route_local_times[reach->areanum] == (unsigned short)ROUTE_INVALID_TIME)
+            {
+                g_route_local_touched[numtouched++] = reach->areanum;
+            }
+            g_route_local_times[reach->areanum] = (unsigned short)cost;
+            if (!Heap_Push(&g_route_local_heap, reach->areanum, cost))
+            {
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < numtouched; ++i)
+    {
+        g_route_local_times[g_route_local_touched[i]] = (unsigned short)ROUTE_INVALID_TIME;
+    }
+    g_route_local_heap.size = 0;
+
+    return count;
+}
+
 void AAS_RouteFrameResetDiagnostics(void)
 {
     memset(&g_route_frame_state, 0, sizeof(g_route_frame_state));
@@ -588,6 +829,11 @@ static bool AAS_LibVarEnabled(libvar_t *var)
 
 void AAS_RouteFrameUpdate(void)
 {
+    g_route_frame_state.last_memo_lookups = g_route_frame_state.memo_lookups;
+    g_route_frame_state.last_memo_hits = g_route_frame_state.memo_hits;
+    g_route_frame_state.memo_lookups = 0;
+    g_route_frame_state.memo_hits = 0;
+
     int budget = AAS_ReadIntLibVar(Bridge_FrameReachability());
     g_route_frame_state.last_budget = budget;
     g_route_frame_state.forcewrite_active = AAS_LibVarEnabled(Bridge_ForceWrite());
@@ -624,6 +870,27 @@ bool AAS_RouteFrameForceWriteActive(void)
     return g_route_frame_state.forcewrite_active;
 }
 
+/* travel-time memo use during the last completed frame */
+int AAS_RouteFrameMemoLookups(void)
+{
+    return g_route_frame_state.last_memo_lookups;
+}
+
+int AAS_RouteFrameMemoHits(void)
+{
+    return g_route_frame_state.last_memo_hits;
+}
+
+float AAS_RouteFrameMemoHitRate(void)
+{
+    if (g_route_frame_state.last_memo_lookups <= 0)
+    {
+        return 0.0f;
+    }
+
+    return (float)g_route_frame_state.last_memo_hits / (float)g_route_frame_state.last_memo_lookups;
+}
+
 int AAS_NextModelReachability(int startIndex, int modelnum)
 {
     if (aasworld.reachability == NULL || aasworld.numReachability <= 0)
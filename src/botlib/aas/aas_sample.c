@@ -0,0 +1,401 @@
+#include "aas_local.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "botlib/common/l_log.h"
+
+/*
+ * Point sampling helpers shared by the movement, goal and interface code.
+ * Areas are tested against their bounding boxes, matching the linking
+ * performed by AAS_UpdateEntity.
+ */
+
+bool AAS_AreaContainsPoint(int areanum, const vec3_t point)
+{
+    if (point == NULL || aasworld.areas == NULL)
+    {
+        return false;
+    }
+
+    if (areanum <= 0 || areanum > aasworld.numAreas)
+    {
+        return false;
+    }
+
+    const aas_area_t *area = &aasworld.areas[areanum];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (point[axis] < area->mins[axis] || point[axis] > area->maxs[axis])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int AAS_PointAreaNum(const vec3_t point)
+{
+    if (point == NULL || !aasworld.loaded || aasworld.areas == NULL || aasworld.numAreas <= 0)
+    {
+        return 0;
+    }
+
+    for (int areanum = 1; areanum <= aasworld.numAreas; ++areanum)
+    {
+        if (AAS_AreaContainsPoint(areanum, point))
+        {
+            return areanum;
+        }
+    }
+
+    return 0;
+}
+
+void AAS_ClearAreaOverlaps(void)
+{
+    free(aasworld.areaOverlapOffsets);
+    free(aasworld.areaOverlaps);
+    aasworld.areaOverlapOffsets = NULL;
+    aasworld.areaOverlaps = NULL;
+}
+
+static int AAS_CompareAreaMinsX(const void *a, const void *b)
+{
+    float lhs = aasworld.areas[*(const int *)a].mins[0];
+    float rhs = aasworld.areas[*(const int *)b].mins[0];
+    if (lhs != rhs)
+    {
+        return (lhs < rhs) ? -1 : 1;
+    }
+    return *(const int *)a - *(const int *)b;
+}
+
+static bool AAS_AreaBoxesTouch(const aas_area_t *a, const aas_area_t *b)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (a->mins[axis] > b->maxs[axis] || b->mins[axis] > a->maxs[axis])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Calls visit(higher, lower) for every pair of areas whose closed boxes
+ * touch, sweeping the areas in order of their x minimum.
+ */
+static void AAS_SweepAreaOverlaps(const int *sorted, int count, int *counts, int *offsets, int *overlaps)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const aas_area_t *a = &aasworld.areas[sorted[i]];
+        for (int j = i + 1; j < count; ++j)
+        {
+            const aas_area_t *b = &aasworld.areas[sorted[j]];
+            if (b->mins[0] > a->maxs[0])
+            {
+                break;
+            }
+            if (!AAS_AreaBoxesTouch(a, b))
+            {
+                continue;
+            }
+
+            int higher = (sorted[i] > sorted[j]) ? sorted[i] : sorted[j];
+            int lower = (sorted[i] > sorted[j]) ? sorted[j] : sorted[i];
+            if (overlaps != NULL)
+            {
+                overlaps[offsets[higher] + counts[higher]] = lower;
+            }
+            counts[higher]++;
+        }
+    }
+}
+
+/*
+ * Records, for every area, the lower-numbered areas whose bounding boxes
+ * touch it.  AAS_PointAreaNum returns the first area whose box holds the
+ * point, so a box hit on area n only gives the same answer when none of
+ * these lower areas holds the point as well.  Local to each process even
+ * when the world itself is shared.
+ */
+int AAS_PrepareAreaOverlaps(void)
+{
+    AAS_ClearAreaOverlaps();
+
+    if (aasworld.areas == NULL || aasworld.numAreas <= 0)
+    {
+        return BLERR_NOERROR;
+    }
+
+    int numAreas = aasworld.numAreas;
+    int *sorted = (int *)malloc((size_t)numAreas * sizeof(int));
+    int *counts = (int *)calloc((size_t)numAreas + 2U, sizeof(int));
+    int *offsets = (int *)calloc((size_t)numAreas + 2U, sizeof(int));
+    if (sorted == NULL || counts == NULL || offsets == NULL)
+    {
+        free(sorted);
+        free(counts);
+        free(offsets);
+        return BLERR_INVALIDIMPORT;
+    }
+
+    for (int area = 1; area <= numAreas; ++area)
+    {
+        sorted[area - 1] = area;
+    }
+    qsort(sorted, (size_t)numAreas, sizeof(int), AAS_CompareAreaMinsX);
+
+    AAS_SweepAreaOverlaps(sorted, numAreas, counts, NULL, NULL);
+    for (int area = 0; area <= numAreas; ++area)
+    {
+        offsets[area + 1] = offsets[area] + counts[area];
+        counts[area] = 0;
+    }
+
+    int *overlaps = (int *)malloc(((size_t)offsets[numAreas + 1] + 1U) * sizeof(int));
+    if (overlaps == NULL)
+    {
+        free(sorted);
+        free(counts);
+        free(offsets);
+        return BLERR_INVALIDIMPORT;
+    }
+    AAS_SweepAreaOverlaps(sorted, numAreas, counts, offsets, overlaps);
+
+    free(sorted);
+    free(counts);
+    aasworld.areaOverlapOffsets = offsets;
+    aasworld.areaOverlaps = overlaps;
+    return BLERR_NOERROR;
+}
+
+/*
+ * True when AAS_PointAreaNum(point) would return areanum.  Without the
+ * overlap table nothing short of the full scan can tell, so say no.
+ */
+static bool AAS_AreaIsFirstMatch(int areanum, const vec3_t point)
+{
+    if (aasworld.areaOverlapOffsets == NULL || !AAS_AreaContainsPoint(areanum, point))
+    {
+        return false;
+    }
+
+    int end = aasworld.areaOverlapOffsets[areanum + 1];
+    for (int index = aasworld.areaOverlapOffsets[areanum]; index < end; ++index)
+    {
+        if (AAS_AreaContainsPoint(aasworld.areaOverlaps[index], point))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int AAS_PointAreaNumFromNeighbours(const vec3_t point, int hintArea)
+{
+    if (aasworld.areasettings != NULL && hintArea < aasworld.numAreaSettings)
+    {
+        const aas_areasettings_t *settings = &aasworld.areasettings[hintArea];
+        int first = settings->firstreachablearea;
+        int count = settings->numreachableareas;
+        if (first >= 0 && count > 0 && first + count <= aasworld.numReachability)
+        {
+            for (int index = first; index < first + count; ++index)
+            {
+                int areanum = aasworld.reachability[index].areanum;
+                if (AAS_AreaIsFirstMatch(areanum, point))
+                {
+                    return areanum;
+                }
+            }
+        }
+    }
+
+    if (aasworld.reversedReachability != NULL && aasworld.reachabilityFromArea != NULL)
+    {
+        const aas_reversedreachability_t *reverse = &aasworld.reversedReachability[hintArea];
+        for (int index = 0; index < reverse->count; ++index)
+        {
+            int reachIndex = reverse->reachIndexes[index];
+            if (reachIndex < 0 || reachIndex >= aasworld.numReachability)
+            {
+                continue;
+            }
+
+            int areanum = aasworld.reachabilityFromArea[reachIndex];
+            if (AAS_AreaIsFirstMatch(areanum, point))
+            {
+                return areanum;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Entities rarely leave the area they occupied last frame, and when they do
+ * they normally step into a neighbour reachable from it.  Test the previous
+ * area first, then the areas connected to it by reachabilities in either
+ * direction, and only fall back to the full lookup when both miss.  Area
+ * boxes overlap, so a candidate is only taken when none of the lower areas
+ * overlapping it holds the point; the result always equals
+ * AAS_PointAreaNum(point).
+ */
+int AAS_PointAreaNumHinted(const vec3_t point, int hintArea)
+{
+    if (point == NULL || !aasworld.loaded || aasworld.areas == NULL || aasworld.numAreas <= 0)
+    {
+        return 0;
+    }
+
+    if (hintArea > 0 && hintArea <= aasworld.numAreas)
+    {
+        if (AAS_AreaIsFirstMatch(hintArea, point))
+        {
+            return hintArea;
+        }
+
+        int neighbour = AAS_PointAreaNumFromNeighbours(point, hintArea);
+        if (neighbour > 0)
+        {
+            return neighbour;
+        }
+    }
+
+    return AAS_PointAreaNum(point);
+}
+
+#define AAS_TRACEAREAS_STACK 127
+
+typedef struct aas_tracestack_s
+{
+    vec3_t start;
+    vec3_t end;
+    int nodenum;
+} aas_tracestack_t;
+
+/*
+ * Walks the AAS node tree along the segment and stores every area it passes
+ * through in order, together with the point where the segment enters it.
+ * Solid leaves are skipped, so the list describes the open space the segment
+ * crosses.  All state lives on the stack, which makes the walk safe to run
+ * from several bot threads at once.  Returns the number of areas stored.
+ */
+int AAS_TraceAreas(const vec3_t start, const vec3_t end, int *areas, vec3_t *points, int maxareas)
+{
+    if (start == NULL || end == NULL || areas == NULL || maxareas <= 0)
+    {
+        return 0;
+    }
+
+    if (!aasworld.loaded || aasworld.nodes == NULL || aasworld.numNodes <= 1
+        || aasworld.planes == NULL || aasworld.numPlanes <= 0)
+    {
+        return 0;
+    }
+
+    aas_tracestack_t stack[AAS_TRACEAREAS_STACK];
+    aas_tracestack_t *top = stack;
+    VectorCopy(start, top->start);
+    VectorCopy(end, top->end);
+    top->nodenum = 1;
+    ++top;
+
+    int numareas = 0;
+    while (top > stack)
+    {
+        --top;
+        aas_tracestack_t current = *top;
+        int nodenum = current.nodenum;
+
+        if (nodenum < 0)
+        {
+            int areanum = -nodenum;
+            if (areanum > aasworld.numAreas)
+            {
+                continue;
+            }
+
+            /* consecutive pieces of the segment can end up in the same area */
+            if (numareas > 0 && areas[numareas - 1] == areanum)
+            {
+                continue;
+            }
+
+            areas[numareas] = areanum;
+            if (points != NULL)
+            {
+                VectorCopy(current.start, points[numareas]);
+            }
+            if (++numareas >= maxareas)
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (nodenum == 0 || nodenum >= aasworld.numNodes)
+        {
+            continue;
+        }
+
+        const aas_node_t *node = &aasworld.nodes[nodenum];
+        if (node->planenum < 0 || node->planenum >= aasworld.numPlanes)
+        {
+            continue;
+        }
+
+        const aas_plane_t *plane = &aasworld.planes[node->planenum];
+        float front = DotProduct(current.start, plane->normal) - plane->dist;
+        float back = DotProduct(current.end, plane->normal) - plane->dist;
+
+        /* the popped entry still holds the segment, reuse it for the child */
+        if (front >= 0.0f && back >= 0.0f)
+        {
+            top->nodenum = node->children[0];
+            ++top;
+            continue;
+        }
+        if (front < 0.0f && back < 0.0f)
+        {
+            top->nodenum = node->children[1];
+            ++top;
+            continue;
+        }
+
+        if (top + 2 > stack + AAS_TRACEAREAS_STACK)
+        {
+            BotLib_Print(PRT_WARNING, "AAS_TraceAreas: stack overflow\n");
+            break;
+        }
+
+        /* the segment crosses the plane: handle the near side first */
+        int side = (front < 0.0f) ? 1 : 0;
+        float frac = front / (front - back);
+        vec3_t mid;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            mid[axis] = current.start[axis] + (current.end[axis] - current.start[axis]) * frac;
+        }
+
+        VectorCopy(mid, top->start);
+        VectorCopy(current.end, top->end);
+        top->nodenum = node->children[!side];
+        ++top;
+
+        VectorCopy(current.start, top->start);
+        VectorCopy(mid, top->end);
+        top->nodenum = node->children[side];
+        ++top;
+    }
+
+    return numareas;
+}
@@ -0,0 +1,611 @@
+#include "aas_local.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "botlib/common/l_libvar.h"
+#include "botlib/common/l_log.h"
+
+/*
+ * Process-shared AAS world data.
+ *
+ * When the aas_sharedmemory libvar is set, the immutable parts of a loaded
+ * map (areas, area settings, reachabilities, nodes, planes and the reversed
+ * reachability adjacency) are published in a POSIX shared-memory segment
+ * named after the BSP and AAS checksums.  Sibling server processes that load
+ * the same files attach to the segment instead of reading and preparing
+ * their own copy.  Routing caches stay private because mover updates
+ * invalidate them per process.
+ *
+ * Segment layout: one header page followed by the read-only arrays.  The
+ * reversed reachability is stored in CSR form (per-area offsets followed by
+ * the reachability indexes) so it does not contain process-local pointers.
+ *
+ * Lifetime: every process using a segment holds a shared flock on a lock
+ * file named after it.  Creating the segment takes the lock exclusively, and
+ * a detaching process only unlinks the segment when it can take the lock
+ * exclusively, i.e. when nobody else is attached.  The kernel drops the locks
+ * of crashed processes, so a segment they leave behind is reused by the next
+ * attach and unlinked by the last clean detach.  The lock file is unlinked
+ * with the segment; a process that locked the file just before it went away
+ * notices the name now points elsewhere (or nowhere) and locks again.
+ */
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define AAS_SHARED_MAGIC   0x48534141U /* "AASH" */
+#define AAS_SHARED_VERSION 5U
+#define AAS_SHARED_ALIGN   16U
+
+typedef struct aas_shared_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t bspChecksum;
+    uint32_t aasChecksum;
+    uint64_t segmentSize;
+
+    int32_t numAreas;
+    int32_t numAreaSettings;
+    int32_t numReachability;
+    int32_t numNodes;
+    int32_t numPlanes;
+    int32_t numReverseIndexes;
+
+    uint64_t areasOffset;
+    uint64_t areaSettingsOffset;
+    uint64_t reachabilityOffset;
+    uint64_t nodesOffset;
+    uint64_t planesOffset;
+    uint64_t reachFromAreaOffset;
+    uint64_t reverseOffsetsOffset;
+    uint64_t reverseIndexesOffset;
+
+    atomic_int ready;
+} aas_shared_header_t;
+
+typedef struct aas_shared_state_s
+{
+    unsigned char *base;
+    size_t size;
+    size_t headerSize;
+    char name[64];
+    int lockfd; /* holds a shared flock while the segment is mapped */
+} aas_shared_state_t;
+
+static aas_shared_state_t g_aas_shared = {.lockfd = -1};
+
+static qboolean AAS_SharedMemoryEnabled(void)
+{
+    return LibVarValue("aas_sharedmemory", "0") != 0.0f;
+}
+
+static void AAS_SharedSegmentName(char *buffer, size_t size, uint32_t bspChecksum, uint32_t aasChecksum)
+{
+    snprintf(buffer, size, "/gladiator_aas_%08x_%08x", bspChecksum, aasChecksum);
+}
+
+static void AAS_SharedLockPath(char *buffer, size_t size, const char *name)
+{
+    snprintf(buffer, size, "/tmp%s.lock", name);
+}
+
+/*
+ * Opens the lock file for name and flocks it with operation.  Returns the
+ * locked descriptor, or -1 when the lock cannot be had.  A lock taken on a
+ * file that was unlinked in the meantime guards nothing, so the lock is
+ * only kept once the path still names the locked file.
+ */
+static int AAS_SharedLock(const char *name, int operation)
+{
+    char path[128];
+    AAS_SharedLockPath(path, sizeof(path), name);
+
+    for (;;)
+    {
+        int lockfd = open(path, O_RDWR | O_CREAT, 0644);
+        if (lockfd < 0)
+        {
+            return -1;
+        }
+
+        if (flock(lockfd, operation) != 0)
+        {
+            close(lockfd);
+            return -1;
+        }
+
+        struct stat locked;
+        struct stat current;
+        if (fstat(lockfd, &locked) == 0 && stat(path, &current) == 0 && locked.st_dev == current.st_dev
+            && locked.st_ino == current.st_ino)
+        {
+            return lockfd;
+        }
+
+        close(lockfd);
+    }
+}
+
+/* Removes the segment and its lock file.  Only called with the lock held exclusively. */
+static void AAS_SharedRemove(const char *name)
+{
+    char path[128];
+    AAS_SharedLockPath(path, sizeof(path), name);
+    shm_unlink(name);
+    unlink(path);
+}
+
+static size_t AAS_SharedAlign(size_t value)
+{
+    return (value + (AAS_SHARED_ALIGN - 1U)) & ~(size_t)(AAS_SHARED_ALIGN - 1U);
+}
+
+static size_t AAS_SharedHeaderSize(void)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0)
+    {
+        page = 4096;
+    }
+
+    size_t headerSize = (size_t)page;
+    while (headerSize < sizeof(aas_shared_header_t))
+    {
+        headerSize += (size_t)page;
+    }
+
+    return headerSize;
+}
+
+static int AAS_SharedReverseIndexCount(void)
+{
+    int total = 0;
+    if (aasworld.reversedReachability == NULL)
+    {
+        return 0;
+    }
+
+    for (int area = 0; area <= aasworld.numAreas; ++area)
+    {
+        if (aasworld.reversedReachability[area].count > 0)
+        {
+            total += aasworld.reversedReachability[area].count;
+        }
+    }
+
+    return total;
+}
+
+static qboolean AAS_SharedValidateHeader(const aas_shared_header_t *header,
+                                         size_t segmentSize,
+                                         uint32_t bspChecksum,
+                                         uint32_t aasChecksum)
+{
+    if (header->magic != AAS_SHARED_MAGIC || header->version != AAS_SHARED_VERSION)
+    {
+        return qfalse;
+    }
+
+    if (header->bspChecksum != bspChecksum || header->aasChecksum != aasChecksum)
+    {
+        return qfalse;
+    }
+
+    if (header->segmentSize != (uint64_t)segmentSize)
+    {
+        return qfalse;
+    }
+
+    if (header->numAreas < 0 || header->numAreaSettings < 0 || header->numReachability < 0
+        || header->numNodes < 0 || header->numPlanes < 0 || header->numReverseIndexes < 0)
+    {
+        return qfalse;
+    }
+
+    uint64_t reverseEnd = header->reverseIndexesOffset
+                          + (uint64_t)header->numReverseIndexes * sizeof(int);
+    if (reverseEnd > (uint64_t)segmentSize)
+    {
+        return qfalse;
+    }
+
+    return atomic_load_explicit(&((aas_shared_header_t *)header)->ready, memory_order_acquire) != 0;
+}
+
+/*
+ * Builds the process-local reversed reachability table on top of the CSR
+ * arrays held by the segment.
+ */
+static aas_reversedreachability_t *AAS_SharedBuildReverseReachability(const aas_shared_header_t *header)
+{
+    int numAreas = header->numAreas;
+    aas_reversedreachability_t *table =
+        (aas_reversedreachability_t *)calloc((size_t)numAreas + 1U, sizeof(aas_reversedreachability_t));
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+    const int32_t *offsets = (const int32_t *)(g_aas_shared.base + header->reverseOffsetsOffset);
+    int *indexes = (int *)(g_aas_shared.base + header->reverseIndexesOffset);
+    for (int area = 0; area <= numAreas; ++area)
+    {
+        int begin = offsets[area];
+        int end = offsets[area + 1];
+        if (begin < 0 || end < begin || end > header->numReverseIndexes)
+        {
+            free(table);
+            return NULL;
+        }
+
+        table[area].count = end - begin;
+        table[area].reachIndexes = (end > begin) ? &indexes[begin] : NULL;
+    }
+
+    return table;
+}
+
+static void AAS_SharedBindWorld(const aas_shared_header_t *header, aas_reversedreachability_t *reverse)
+{
+    unsigned char *base = g_aas_shared.base;
+
+    aasworld.numAreas = header->numAreas;
+    aasworld.areas = (aas_area_t *)(base + header->areasOffset);
+    aasworld.numAreaSettings = header->numAreaSettings;
+    aasworld.areasettings = (aas_areasettings_t *)(base + header->areaSettingsOffset);
+    aasworld.numReachability = header->numReachability;
+    aasworld.reachability = (aas_reachability_t *)(base + header->reachabilityOffset);
+    aasworld.numNodes = header->numNodes;
+    aasworld.nodes = (aas_node_t *)(base + header->nodesOffset);
+    aasworld.numPlanes = header->numPlanes;
+    aasworld.planes = (aas_plane_t *)(base + header->planesOffset);
+    aasworld.reachabilityFromArea = (header->numReachability > 0)
+                                        ? (int *)(base + header->reachFromAreaOffset)
+                                        : NULL;
+    aasworld.reversedReachability = reverse;
+    aasworld.sharedData = qtrue;
+}
+
+/*
+ * Returns true when an existing segment can never be attached, e.g. because
+ * its creator crashed before marking it ready.  Only called while holding the
+ * lock exclusively, so nobody else can be using it.
+ */
+static qboolean AAS_SharedSegmentIsStale(const char *name, uint32_t bspChecksum, uint32_t aasChecksum)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return qfalse;
+    }
+
+    struct stat info;
+    qboolean stale = qtrue;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size > AAS_SharedHeaderSize())
+    {
+        void *mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            stale = AAS_SharedValidateHeader((const aas_shared_header_t *)mapping, (size_t)info.st_size,
+                                             bspChecksum, aasChecksum)
+                        ? qfalse
+                        : qtrue;
+            munmap(mapping, (size_t)info.st_size);
+        }
+    }
+
+    close(fd);
+    return stale;
+}
+
+static void AAS_SharedUnmap(void)
+{
+    if (g_aas_shared.base != NULL)
+    {
+        munmap(g_aas_shared.base, g_aas_shared.size);
+    }
+
+    if (g_aas_shared.lockfd >= 0)
+    {
+        close(g_aas_shared.lockfd);
+    }
+
+    memset(&g_aas_shared, 0, sizeof(g_aas_shared));
+    g_aas_shared.lockfd = -1;
+}
+
+qboolean AAS_SharedWorldAttach(int bspChecksum, int aasChecksum)
+{
+    if (!AAS_SharedMemoryEnabled())
+    {
+        return qfalse;
+    }
+
+    char name[64];
+    AAS_SharedSegmentName(name, sizeof(name), (uint32_t)bspChecksum, (uint32_t)aasChecksum);
+
+    /* a detach holding the lock exclusively may unlink the segment, wait for it */
+    int lockfd = AAS_SharedLock(name, LOCK_SH);
+    if (lockfd < 0)
+    {
+        return qfalse;
+    }
+
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        close(lockfd);
+        return qfalse;
+    }
+
+    struct stat info;
+    size_t headerSize = AAS_SharedHeaderSize();
+    if (fstat(fd, &info) != 0 || info.st_size <= 0 || (size_t)info.st_size <= headerSize)
+    {
+        close(fd);
+        close(lockfd);
+        return qfalse;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        close(lockfd);
+        return qfalse;
+    }
+
+    g_aas_shared.lockfd = lockfd;
+    g_aas_shared.base = (unsigned char *)mapping;
+    g_aas_shared.size = size;
+    g_aas_shared.headerSize = headerSize;
+    strncpy(g_aas_shared.name, name, sizeof(g_aas_shared.name) - 1U);
+
+    aas_shared_header_t *header = (aas_shared_header_t *)g_aas_shared.base;
+    if (!AAS_SharedValidateHeader(header, size, (uint32_t)bspChecksum, (uint32_t)aasChecksum))
+    {
+        BotLib_Print(PRT_WARNING, "AAS_SharedWorldAttach: ignoring stale segment %s\n", name);
+        AAS_SharedUnmap();
+        return qfalse;
+    }
+
+    mprotect(g_aas_shared.base + headerSize, size - headerSize, PROT_READ);
+
+    aas_reversedreachability_t *reverse = AAS_SharedBuildReverseReachability(header);
+    if (reverse == NULL)
+    {
+        AAS_SharedUnmap();
+        return qfalse;
+    }
+
+    AAS_SharedBindWorld(header, reverse);
+
+    BotLib_Print(PRT_MESSAGE, "AAS: attached to shared world %s (%zu bytes)\n", name, size);
+    return qtrue;
+}
+
+void AAS_SharedWorldPublish(void)
+{
+    if (aasworld.sharedData || !AAS_SharedMemoryEnabled())
+    {
+        return;
+    }
+
+    if (aasworld.areas == NULL || aasworld.numAreas <= 0)
+    {
+        return;
+    }
+
+    int numAreas = aasworld.numAreas;
+    int numReverse = AAS_SharedReverseIndexCount();
+    size_t headerSize = AAS_SharedHeaderSize();
+
+    size_t offset = headerSize;
+    size_t areasOffset = offset;
+    offset = AAS_SharedAlign(offset + (size_t)numAreas * sizeof(aas_area_t));
+    size_t settingsOffset = offset;
+    offset = AAS_SharedAlign(offset + (size_t)aasworld.numAreaSettings * sizeof(aas_areasettings_t));
+    size_t reachOffset = offset;
+    offset = AAS_SharedAlign(offset + (size_t)aasworld.numReachability * sizeof(aas_reachability_t));
+    size_t nodesOffset = offset;
+    offset = AAS_SharedAlign(offset + (size_t)aasworld.numNodes * sizeof(aas_node_t));
+    size_t planesOffset = offset;
+    offset = AAS_SharedAlign(offset + (size_t)aasworld.numPlanes * sizeof(aas_plane_t));
+    size_t fromAreaOffset = offset;
+    offset = AAS_SharedAlign(offset + (size_t)aasworld.numReachability * sizeof(int));
+    size_t reverseOffsetsOffset = offset;
+    offset = AAS_SharedAlign(offset + ((size_t)numAreas + 2U) * sizeof(int32_t));
+    size_t reverseIndexesOffset = offset;
+    offset = AAS_SharedAlign(offset + (size_t)numReverse * sizeof(int));
+    size_t size = offset;
+
+    char name[64];
+    AAS_SharedSegmentName(name, sizeof(name), (uint32_t)aasworld.bspChecksum, (uint32_t)aasworld.aasChecksum);
+
+    /*
+     * Losing the creation race is harmless: this process keeps its private
+     * copy.  Any holder of the lock means another process is using or
+     * creating the segment, so never wait for it here.
+     */
+    int lockfd = AAS_SharedLock(name, LOCK_EX | LOCK_NB);
+    if (lockfd < 0)
+    {
+        return;
+    }
+
+    if (AAS_SharedSegmentIsStale(name, (uint32_t)aasworld.bspChecksum, (uint32_t)aasworld.aasChecksum))
+    {
+        shm_unlink(name);
+    }
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+    {
+        if (errno != EEXIST)
+        {
+            BotLib_Print(PRT_WARNING, "AAS_SharedWorldPublish: shm_open %s failed (%s)\n", name, strerror(errno));
+        }
+        close(lockfd);
+        return;
+    }
+
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        BotLib_Print(PRT_WARNING, "AAS_SharedWorldPublish: cannot size %s (%s)\n", name, strerror(errno));
+        close(fd);
+        AAS_SharedRemove(name);
+        close(lockfd);
+        return;
+    }
+
+    void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        AAS_SharedRemove(name);
+        close(lockfd);
+        return;
+    }
+
+    unsigned char *base = (unsigned char *)mapping;
+    aas_shared_header_t *header = (aas_shared_header_t *)base;
+
+    memcpy(base + areasOffset, aasworld.areas, (size_t)numAreas * sizeof(aas_area_t));
+    if (aasworld.numAreaSettings > 0)
+    {
+        memcpy(base + settingsOffset, aasworld.areasettings,
+               (size_t)aasworld.numAreaSettings * sizeof(aas_areasettings_t));
+    }
+    if (aasworld.numReachability > 0)
+    {
+        memcpy(base + reachOffset, aasworld.reachability,
+               (size_t)aasworld.numReachability * sizeof(aas_reachability_t));
+        if (aasworld.reachabilityFromArea != NULL)
+        {
+            memcpy(base + fromAreaOffset, aasworld.reachabilityFromArea,
+                   (size_t)aasworld.numReachability * sizeof(int));
+        }
+    }
+    if (aasworld.numNodes > 0)
+    {
+        memcpy(base + nodesOffset, aasworld.nodes, (size_t)aasworld.numNodes * sizeof(aas_node_t));
+    }
+    if (aasworld.numPlanes > 0)
+    {
+        memcpy(base + planesOffset, aasworld.planes, (size_t)aasworld.numPlanes * sizeof(aas_plane_t));
+    }
+
+    int32_t *reverseOffsets = (int32_t *)(base + reverseOffsetsOffset);
+    int *reverseIndexes = (int *)(base + reverseIndexesOffset);
+    int cursor = 0;
+    for (int area = 0; area <= numAreas; ++area)
+    {
+        reverseOffsets[area] = cursor;
+        const aas_reversedreachability_t *reverse =
+            (aasworld.reversedReachability != NULL) ? &aasworld.reversedReachability[area] : NULL;
+        if (reverse != NULL && reverse->count > 0 && reverse->reachIndexes != NULL)
+        {
+            memcpy(&reverseIndexes[cursor], reverse->reachIndexes, (size_t)reverse->count * sizeof(int));
+            cursor += reverse->count;
+        }
+    }
+    reverseOffsets[numAreas + 1] = cursor;
+
+    header->magic = AAS_SHARED_MAGIC;
+    header->version = AAS_SHARED_VERSION;
+    header->bspChecksum = (uint32_t)aasworld.bspChecksum;
+    header->aasChecksum = (uint32_t)aasworld.aasChecksum;
+    header->segmentSize = (uint64_t)size;
+    header->numAreas = numAreas;
+    header->numAreaSettings = aasworld.numAreaSettings;
+    header->numReachability = aasworld.numReachability;
+    header->numNodes = aasworld.numNodes;
+    header->numPlanes = aasworld.numPlanes;
+    header->numReverseIndexes = cursor;
+    header->areasOffset = areasOffset;
+    header->areaSettingsOffset = settingsOffset;
+    header->reachabilityOffset = reachOffset;
+    header->nodesOffset = nodesOffset;
+    header->planesOffset = planesOffset;
+    header->reachFromAreaOffset = fromAreaOffset;
+    header->reverseOffsetsOffset = reverseOffsetsOffset;
+    header->reverseIndexesOffset = reverseIndexesOffset;
+    atomic_store_explicit(&header->ready, 1, memory_order_release);
+
+    mprotect(base + headerSize, size - headerSize, PROT_READ);
+
+    /* let other processes attach while this one keeps the segment alive */
+    flock(lockfd, LOCK_SH);
+
+    g_aas_shared.lockfd = lockfd;
+    g_aas_shared.base = base;
+    g_aas_shared.size = size;
+    g_aas_shared.headerSize = headerSize;
+    strncpy(g_aas_shared.name, name, sizeof(g_aas_shared.name) - 1U);
+
+    aas_reversedreachability_t *reverse = AAS_SharedBuildReverseReachability(header);
+    if (reverse == NULL)
+    {
+        BotLib_Print(PRT_WARNING, "AAS_SharedWorldPublish: out of memory, keeping private copy\n");
+        AAS_SharedWorldDetach();
+        return;
+    }
+
+    /* Swap the private arrays for the shared view. */
+    AAS_ClearReachabilityData();
+    free(aasworld.areas);
+    free(aasworld.areasettings);
+    free(aasworld.reachability);
+    free(aasworld.nodes);
+    free(aasworld.planes);
+    AAS_SharedBindWorld(header, reverse);
+
+    BotLib_Print(PRT_MESSAGE, "AAS: published shared world %s (%zu bytes)\n", name, size);
+}
+
+void AAS_SharedWorldDetach(void)
+{
+    if (g_aas_shared.base == NULL)
+    {
+        return;
+    }
+
+    /* an exclusive lock means no other process holds the segment */
+    if (g_aas_shared.lockfd >= 0 && flock(g_aas_shared.lockfd, LOCK_EX | LOCK_NB) == 0)
+    {
+        AAS_SharedRemove(g_aas_shared.name);
+    }
+
+    AAS_SharedUnmap();
+}
+
+#else /* !POSIX */
+
+qboolean AAS_SharedWorldAttach(int bspChecksum, int aasChecksum)
+{
+    (void)bspChecksum;
+    (void)aasChecksum;
+    return qfalse;
+}
+
+void AAS_SharedWorldPublish(void)
+{
+}
+
+void AAS_SharedWorldDetach(void)
+{
+}
+
+#endif
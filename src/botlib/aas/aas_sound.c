@@ -2,6 +2,8 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <float.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,6 +15,28 @@
 #include "botlib/common/l_log.h"
 #include "botlib/common/l_memory.h"
 
+/*
+ * Events are filed into a coarse grid over x and y so a bot only looks at the
+ * cells around it.  A cell is as wide as the farthest an ATTN_NORM sound can
+ * be heard (full volume up to 80 units, then 0.0005 per unit), so every sound
+ * a listener can hear lies in its own cell or one of the eight around it.
+ * Sounds that carry further than that are kept on a separate list.  Cells are
+ * hashed into a fixed bucket table; collisions only cost extra distance tests.
+ */
+#define AAS_SOUND_FULLVOLUME 80.0f
+#define AAS_SOUND_DISTMULT 0.0005f
+#define AAS_SOUND_GRID_CELL (AAS_SOUND_FULLVOLUME + 1.0f / (ATTN_NORM * AAS_SOUND_DISTMULT))
+#define AAS_SOUND_GRID_BUCKETS 64
+
+typedef struct aas_sound_grid_s
+{
+    int heads[AAS_SOUND_GRID_BUCKETS]; /* event index + 1, 0 when empty */
+    int global;                        /* events heard beyond the cell size */
+    int *next;                         /* per event, next event index + 1 */
+    size_t *nearby;                    /* result buffer for the near queries */
+    bool dirty;
+} aas_sound_grid_t;
+
 typedef struct aas_sound_state_s
 {
     aas_soundinfo_t *infos;
@@ -42,6 +66,9 @@ typedef struct aas_sound_state_s
     size_t pointlight_summary_capacity;
     bool pointlight_summaries_dirty;
 
+    aas_sound_grid_t sound_grid;
+    aas_sound_grid_t pointlight_grid;
+
     float frame_time;
     float previous_frame_time;
     bool frame_time_initialised;
@@ -331,7 +358,7 @@ static char *AAS_Sound_RemoveComments(const char *input, size_t length)
         return NULL;
     }
 
-    char *output = (char *)malloc(length + 1U);
+    char *output = (char *)BotMemory_Malloc(length + 1U);
     if (output == NULL)
     {
         return NULL;
@@ -583,8 +610,13 @@ static bool AAS_Sound_EnsureInfoCapacity(void)
     }
 
     g_aas_sound_state.infos =
-        (aas_soundinfo_t *)calloc(g_aas_sound_state.info_capacity, sizeof(aas_soundinfo_t));
-    return (g_aas_sound_state.infos != NULL);
+        (aas_soundinfo_t *)BotMemory_Calloc(g_aas_sound_state.info_capacity, sizeof(aas_soundinfo_t));
+    if (g_aas_sound_state.infos == NULL)
+    {
+        return false;
+    }
+
+    return true;
 }
 
 static bool AAS_Sound_PushInfo(const aas_soundinfo_t *info)
@@ -642,10 +674,33 @@ static void AAS_Sound_FreeAssets(void)
     g_aas_sound_state.asset_count = 0U;
 }
 
+static void AAS_Sound_FreeGrid(aas_sound_grid_t *grid)
+{
+    free(grid->next);
+    free(grid->nearby);
+    memset(grid, 0, sizeof(*grid));
+}
+
+static bool AAS_Sound_AllocGrid(aas_sound_grid_t *grid, size_t capacity)
+{
+    memset(grid, 0, sizeof(*grid));
+    grid->next = (int *)BotMemory_Calloc(capacity, sizeof(int));
+    grid->nearby = (size_t *)BotMemory_Calloc(capacity, sizeof(size_t));
+    grid->dirty = true;
+    if (grid->next == NULL || grid->nearby == NULL)
+    {
+        return false;
+    }
+
+    return true;
+}
+
 static void AAS_Sound_FreeEvents(void)
 {
     free(g_aas_sound_state.sound_events);
     free(g_aas_sound_state.pointlight_events);
+    AAS_Sound_FreeGrid(&g_aas_sound_state.sound_grid);
+    AAS_Sound_FreeGrid(&g_aas_sound_state.pointlight_grid);
 
     g_aas_sound_state.sound_events = NULL;
     g_aas_sound_state.pointlight_events = NULL;
@@ -693,12 +748,18 @@ int AAS_SoundSubsystem_Init(const botlib_library_variables_t *vars)
     if (g_aas_sound_state.sound_event_capacity > 0U)
     {
         g_aas_sound_state.sound_events =
-            (aas_sound_event_t *)calloc(g_aas_sound_state.sound_event_capacity,
-                                        sizeof(aas_sound_event_t));
+            (aas_sound_event_t *)BotMemory_Calloc(g_aas_sound_state.sound_event_capacity,
+                                                  sizeof(aas_sound_event_t));
         g_aas_sound_state.pointlight_events =
-            (aas_pointlight_event_t *)calloc(g_aas_sound_state.pointlight_event_capacity,
-                                             sizeof(aas_pointlight_event_t));
-        if (g_aas_sound_state.sound_events == NULL || g_aas_sound_state.pointlight_events == NULL)
+            (aas_pointlight_event_t *)BotMemory_Calloc(g_aas_sound_state.pointlight_event_capacity,
+                                                       sizeof(aas_pointlight_event_t));
+        bool grids = AAS_Sound_AllocGrid(&g_aas_sound_state.sound_grid,
+                                         g_aas_sound_state.sound_event_capacity);
+        grids = AAS_Sound_AllocGrid(&g_aas_sound_state.pointlight_grid,
+                                    g_aas_sound_state.pointlight_event_capacity)
+                && grids;
+        if (g_aas_sound_state.sound_events == NULL || g_aas_sound_state.pointlight_events == NULL
+            || !grids)
         {
             AAS_SoundSubsystem_Shutdown();
             return BLERR_INVALIDIMPORT;
@@ -758,7 +819,7 @@ int AAS_SoundSubsystem_Init(const botlib_library_variables_t *vars)
         return BLERR_INVALIDIMPORT;
     }
 
-    char *raw_buffer = (char *)malloc((size_t)file_length + 1U);
+    char *raw_buffer = (char *)BotMemory_Malloc((size_t)file_length + 1U);
     if (raw_buffer == NULL)
     {
         BotLib_Print(PRT_ERROR, "AAS_Sound: out of memory reading %s\n", resolved_path);
@@ -813,6 +874,10 @@ void AAS_SoundSubsystem_ClearMapAssets(void)
 {
     AAS_Sound_FreeAssets();
     g_aas_sound_state.sound_summaries_dirty = true;
+
+    /* the cached event areas belong to the previous map */
+    g_aas_sound_state.sound_grid.dirty = true;
+    g_aas_sound_state.pointlight_grid.dirty = true;
 }
 
 bool AAS_SoundSubsystem_RegisterMapAssets(int count, char *assets[])
@@ -826,11 +891,11 @@ bool AAS_SoundSubsystem_RegisterMapAssets(int count, char *assets[])
 
     size_t desired = (size_t)count;
     g_aas_sound_state.asset_names =
-        (char **)calloc(desired, sizeof(char *));
+        (char **)BotMemory_Calloc(desired, sizeof(char *));
     g_aas_sound_state.asset_normalized =
-        (char **)calloc(desired, sizeof(char *));
+        (char **)BotMemory_Calloc(desired, sizeof(char *));
     g_aas_sound_state.asset_info_index =
-        (int *)calloc(desired, sizeof(int));
+        (int *)BotMemory_Calloc(desired, sizeof(int));
     if (g_aas_sound_state.asset_names == NULL || g_aas_sound_state.asset_normalized == NULL
         || g_aas_sound_state.asset_info_index == NULL)
     {
@@ -847,8 +912,8 @@ bool AAS_SoundSubsystem_RegisterMapAssets(int count, char *assets[])
         }
 
         size_t length = strlen(name);
-        g_aas_sound_state.asset_names[i] = (char *)malloc(length + 1U);
-        g_aas_sound_state.asset_normalized[i] = (char *)malloc(length + 1U);
+        g_aas_sound_state.asset_names[i] = (char *)BotMemory_Malloc(length + 1U);
+        g_aas_sound_state.asset_normalized[i] = (char *)BotMemory_Malloc(length + 1U);
         if (g_aas_sound_state.asset_names[i] == NULL
             || g_aas_sound_state.asset_normalized[i] == NULL)
         {
@@ -895,6 +960,8 @@ void AAS_SoundSubsystem_ResetFrameEvents(void)
     g_aas_sound_state.pointlight_summary_count = 0U;
     g_aas_sound_state.sound_summaries_dirty = true;
     g_aas_sound_state.pointlight_summaries_dirty = true;
+    g_aas_sound_state.sound_grid.dirty = true;
+    g_aas_sound_state.pointlight_grid.dirty = true;
 }
 
 static void AAS_Sound_SetEntitySound(int ent, int soundindex)
@@ -953,7 +1020,9 @@ bool AAS_SoundSubsystem_RecordSound(const vec3_t origin,
         (soundindex >= 0 && (size_t)soundindex < g_aas_sound_state.asset_count)
             ? g_aas_sound_state.asset_info_index[soundindex]
             : -1;
+    event->areanum = 0;
     g_aas_sound_state.sound_summaries_dirty = true;
+    g_aas_sound_state.sound_grid.dirty = true;
 
     if (soundindex >= 0)
     {
@@ -1007,7 +1076,9 @@ bool AAS_SoundSubsystem_RecordPointLight(const vec3_t origin,
     event->timestamp = g_aas_sound_state.frame_time;
     event->time = time;
     event->decay = decay;
+    event->areanum = 0;
     g_aas_sound_state.pointlight_summaries_dirty = true;
+    g_aas_sound_state.pointlight_grid.dirty = true;
     return true;
 }
 
@@ -1081,8 +1152,8 @@ static bool AAS_SoundSubsystem_EnsureSoundSummaryCapacity(size_t desired)
     }
 
     aas_sound_event_summary_t *resized =
-        (aas_sound_event_summary_t *)realloc(g_aas_sound_state.sound_summaries,
-                                             desired * sizeof(aas_sound_event_summary_t));
+        (aas_sound_event_summary_t *)BotMemory_Realloc(g_aas_sound_state.sound_summaries,
+                                                       desired * sizeof(aas_sound_event_summary_t));
     if (resized == NULL)
     {
         BotLib_Print(PRT_ERROR,
@@ -1104,7 +1175,7 @@ static bool AAS_SoundSubsystem_EnsurePointLightSummaryCapacity(size_t desired)
     }
 
     aas_pointlight_event_summary_t *resized =
-        (aas_pointlight_event_summary_t *)realloc(
+        (aas_pointlight_event_summary_t *)BotMemory_Realloc(
             g_aas_sound_state.pointlight_summaries,
             desired * sizeof(aas_pointlight_event_summary_t));
     if (resized == NULL)
@@ -1383,3 +1454,210 @@ AAS_SoundSubsystem_PointLightSummaries(const aas_pointlight_event_summary_t **su
     *summaries = g_aas_sound_state.pointlight_summaries;
     return g_aas_sound_state.pointlight_summary_count;
 }
+
+/* farthest distance at which a sound can still be heard */
+static float AAS_Sound_AudibleDistance(float attenuation)
+{
+    if (attenuation <= 0.0f)
+    {
+        return FLT_MAX;
+    }
+    return AAS_SOUND_FULLVOLUME + 1.0f / (attenuation * AAS_SOUND_DISTMULT);
+}
+
+static int AAS_Sound_GridCoord(float value)
+{
+    return (int)floorf(value / AAS_SOUND_GRID_CELL);
+}
+
+static int AAS_Sound_GridBucket(int x, int y)
+{
+    unsigned int hash = (unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u;
+    return (int)(hash & (AAS_SOUND_GRID_BUCKETS - 1));
+}
+
+static void AAS_Sound_GridLink(aas_sound_grid_t *grid, size_t index, const vec3_t origin, bool global)
+{
+    int *head = &grid->global;
+    if (!global)
+    {
+        head = &grid->heads[AAS_Sound_GridBucket(AAS_Sound_GridCoord(origin[0]),
+                                                 AAS_Sound_GridCoord(origin[1]))];
+    }
+
+    grid->next[index] = *head;
+    *head = (int)index + 1;
+}
+
+/*
+ * Files the events by cell and looks up the area of each one.  Linking in
+ * reverse keeps every chain in recording order.
+ */
+static void AAS_Sound_RebuildSoundGrid(void)
+{
+    aas_sound_grid_t *grid = &g_aas_sound_state.sound_grid;
+    memset(grid->heads, 0, sizeof(grid->heads));
+    grid->global = 0;
+
+    for (size_t index = g_aas_sound_state.sound_event_count; index-- > 0U;)
+    {
+        aas_sound_event_t *event = &g_aas_sound_state.sound_events[index];
+        event->areanum = AAS_PointAreaNum(event->origin);
+        bool global = AAS_Sound_AudibleDistance(event->attenuation) > AAS_SOUND_GRID_CELL;
+        AAS_Sound_GridLink(grid, index, event->origin, global);
+    }
+
+    grid->dirty = false;
+}
+
+/*
+ * Point lights are not filed by cell: a flash is visible as far as the line
+ * of sight reaches, so the near query hands every light back and only the
+ * areas need looking up.
+ */
+static void AAS_Sound_LocatePointLights(void)
+{
+    aas_sound_grid_t *grid = &g_aas_sound_state.pointlight_grid;
+    for (size_t index = 0; index < g_aas_sound_state.pointlight_event_count; ++index)
+    {
+        aas_pointlight_event_t *event = &g_aas_sound_state.pointlight_events[index];
+        event->areanum = AAS_PointAreaNum(event->origin);
+    }
+
+    grid->dirty = false;
+}
+
+static bool AAS_Sound_SoundHeardAt(size_t index, const vec3_t origin)
+{
+    const aas_sound_event_t *event = &g_aas_sound_state.sound_events[index];
+    if (event->attenuation <= 0.0f)
+    {
+        return true;
+    }
+
+    float range = AAS_Sound_AudibleDistance(event->attenuation);
+    vec3_t delta;
+    VectorSubtract(event->origin, origin, delta);
+    return DotProduct(delta, delta) <= range * range;
+}
+
+static int AAS_Sound_CompareIndexes(const void *lhs, const void *rhs)
+{
+    size_t a = *(const size_t *)lhs;
+    size_t b = *(const size_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+static size_t AAS_Sound_GridCollectChain(aas_sound_grid_t *grid,
+                                         int head,
+                                         const vec3_t origin,
+                                         bool (*inrange)(size_t index, const vec3_t origin),
+                                         size_t count)
+{
+    for (int link = head; link != 0; link = grid->next[link - 1])
+    {
+        size_t index = (size_t)link - 1U;
+        if (inrange(index, origin))
+        {
+            grid->nearby[count++] = index;
+        }
+    }
+    return count;
+}
+
+static size_t AAS_Sound_GridCollect(aas_sound_grid_t *grid,
+                                    size_t event_count,
+                                    const vec3_t origin,
+                                    bool (*inrange)(size_t index, const vec3_t origin))
+{
+    if (origin == NULL)
+    {
+        for (size_t index = 0; index < event_count; ++index)
+        {
+            grid->nearby[index] = index;
+        }
+        return event_count;
+    }
+
+    size_t count = AAS_Sound_GridCollectChain(grid, grid->global, origin, inrange, 0U);
+
+    int x = AAS_Sound_GridCoord(origin[0]);
+    int y = AAS_Sound_GridCoord(origin[1]);
+    int visited[9];
+    int numvisited = 0;
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            int bucket = AAS_Sound_GridBucket(x + dx, y + dy);
+            bool seen = false;
+            for (int i = 0; i < numvisited; ++i)
+            {
+                if (visited[i] == bucket)
+                {
+                    seen = true;
+                    break;
+                }
+            }
+            if (seen)
+            {
+                continue;
+            }
+
+            visited[numvisited++] = bucket;
+            count = AAS_Sound_GridCollectChain(grid, grid->heads[bucket], origin, inrange, count);
+        }
+    }
+
+    /* hand the events back in recording order whatever cells they came from */
+    qsort(grid->nearby, count, sizeof(size_t), AAS_Sound_CompareIndexes);
+    return count;
+}
+
+size_t AAS_SoundSubsystem_SoundEventsNear(const vec3_t origin, const size_t **indexes)
+{
+    if (indexes == NULL)
+    {
+        return 0U;
+    }
+
+    aas_sound_grid_t *grid = &g_aas_sound_state.sound_grid;
+    *indexes = grid->nearby;
+    if (!g_aas_sound_state.initialised || grid->next == NULL)
+    {
+        return 0U;
+    }
+
+    if (grid->dirty)
+    {
+        AAS_Sound_RebuildSoundGrid();
+    }
+
+    return AAS_Sound_GridCollect(grid,
+                                 g_aas_sound_state.sound_event_count,
+                                 origin,
+                                 AAS_Sound_SoundHeardAt);
+}
+
+size_t AAS_SoundSubsystem_PointLightsNear(const vec3_t origin, const size_t **indexes)
+{
+    if (indexes == NULL)
+    {
+        return 0U;
+    }
+
+    aas_sound_grid_t *grid = &g_aas_sound_state.pointlight_grid;
+    *indexes = grid->nearby;
+    if (!g_aas_sound_state.initialised || grid->next == NULL)
+    {
+        return 0U;
+    }
+
+    if (grid->dirty)
+    {
+        AAS_Sound_LocatePointLights();
+    }
+
+    (void)origin;
+    return AAS_Sound_GridCollect(grid, g_aas_sound_state.pointlight_event_count, NULL, NULL);
+}
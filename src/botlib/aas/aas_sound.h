@@ -33,6 +33,7 @@ typedef struct aas_sound_event_s
     float attenuation;
     float timeofs;
     float timestamp;
+    int areanum; /* filled in by the near queries, 0 until then */
 } aas_sound_event_t;
 
 typedef struct aas_pointlight_event_s
@@ -44,6 +45,7 @@ typedef struct aas_pointlight_event_s
     float timestamp;
     float time;
     float decay;
+    int areanum; /* filled in by the near queries, 0 until then */
 } aas_pointlight_event_t;
 
 typedef struct aas_sound_event_summary_s
@@ -102,6 +104,17 @@ const aas_sound_event_t *AAS_SoundSubsystem_SoundEvent(size_t index);
 size_t AAS_SoundSubsystem_PointLightCount(void);
 const aas_pointlight_event_t *AAS_SoundSubsystem_PointLight(size_t index);
 
+/*
+ * Index lists of the events a listener at origin can hear or see, in
+ * recording order.  Events are bucketed by a coarse grid once per frame, which
+ * also fills in their areanum.  Point lights are seen from anywhere, so
+ * every light is returned whatever the origin.  A NULL origin returns every
+ * event.  The returned array is owned
+ * by the subsystem and is invalidated by the next call to the same query.
+ */
+size_t AAS_SoundSubsystem_SoundEventsNear(const vec3_t origin, const size_t **indexes);
+size_t AAS_SoundSubsystem_PointLightsNear(const vec3_t origin, const size_t **indexes);
+
 /*
  * Summaries provide a timestamp-sorted view of the current sensory queues. They
  * clamp to the configured max_aassounds/max_soundinfo values, expose the
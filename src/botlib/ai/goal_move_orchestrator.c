@@ -10,6 +10,8 @@
 #include "botlib/aas/aas_local.h"
 #include "botlib/aas/aas_sound.h"
 #include "botlib/ai_move/bot_move.h"
+#include "botlib/common/l_libvar.h"
+#include "botlib/common/l_memory.h"
 #include "botlib/ea/ea_local.h"
 #include "botlib/interface/botlib_interface.h"
 
@@ -44,34 +46,6 @@ static void ai_goal_copy_vec(vec3_t dest, const vec3_t src)
     dest[2] = src[2];
 }
 
-static int ai_goal_point_area_num(const vec3_t origin)
-{
-    if (origin == NULL || !aasworld.loaded || aasworld.areas == NULL || aasworld.numAreas <= 0)
-    {
-        return 0;
-    }
-
-    for (int areanum = 1; areanum <= aasworld.numAreas; ++areanum)
-    {
-        const aas_area_t *area = &aasworld.areas[areanum];
-        if (origin[0] < area->mins[0] || origin[0] > area->maxs[0])
-        {
-            continue;
-        }
-        if (origin[1] < area->mins[1] || origin[1] > area->maxs[1])
-        {
-            continue;
-        }
-        if (origin[2] < area->mins[2] || origin[2] > area->maxs[2])
-        {
-            continue;
-        }
-        return areanum;
-    }
-
-    return 0;
-}
-
 static int ai_goal_state_alloc_temp_index(ai_goal_state_t *state, unsigned int tag)
 {
     if (state == NULL)
@@ -219,7 +193,7 @@ static bool ai_goal_make_sound_candidate(ai_goal_state_t *state,
     candidate.item_index = ai_goal_state_alloc_temp_index(state, AI_GOAL_SOUND_TAG);
     candidate.travel_flags = TFL_DEFAULT;
     ai_goal_copy_vec(candidate.origin, event->origin);
-    candidate.area = ai_goal_point_area_num(candidate.origin);
+    candidate.area = event->areanum;
     if (candidate.area <= 0)
     {
         return false;
@@ -282,7 +256,7 @@ static bool ai_goal_make_pointlight_candidate(ai_goal_state_t *state,
     candidate.item_index = ai_goal_state_alloc_temp_index(state, AI_GOAL_LIGHT_TAG);
     candidate.travel_flags = TFL_DEFAULT;
     ai_goal_copy_vec(candidate.origin, event->origin);
-    candidate.area = ai_goal_point_area_num(candidate.origin);
+    candidate.area = event->areanum;
     if (candidate.area <= 0)
     {
         return false;
@@ -362,16 +336,18 @@ static void ai_goal_consider_sound_events(ai_goal_state_t *state,
         return;
     }
 
-    size_t total = AAS_SoundSubsystem_SoundEventCount();
+    const size_t *indexes = NULL;
+    size_t total = AAS_SoundSubsystem_SoundEventsNear(state->has_origin ? state->current_origin : NULL,
+                                                      &indexes);
     int considered = 0;
-    for (size_t index = 0; index < total; ++index)
+    for (size_t i = 0; i < total; ++i)
     {
         if (considered >= AI_GOAL_SOUND_LIMIT)
         {
             break;
         }
 
-        const aas_sound_event_t *event = AAS_SoundSubsystem_SoundEvent(index);
+        const aas_sound_event_t *event = AAS_SoundSubsystem_SoundEvent(indexes[i]);
         if (event == NULL)
         {
             continue;
@@ -397,16 +373,18 @@ static void ai_goal_consider_pointlight_events(ai_goal_state_t *state,
         return;
     }
 
-    size_t total = AAS_SoundSubsystem_PointLightCount();
+    const size_t *indexes = NULL;
+    size_t total = AAS_SoundSubsystem_PointLightsNear(state->has_origin ? state->current_origin : NULL,
+                                                      &indexes);
     int considered = 0;
-    for (size_t index = 0; index < total; ++index)
+    for (size_t i = 0; i < total; ++i)
     {
         if (considered >= AI_GOAL_POINTLIGHT_LIMIT)
         {
             break;
         }
 
-        const aas_pointlight_event_t *event = AAS_SoundSubsystem_PointLight(index);
+        const aas_pointlight_event_t *event = AAS_SoundSubsystem_PointLight(indexes[i]);
         if (event == NULL)
         {
             continue;
@@ -434,9 +412,11 @@ static void ai_goal_state_reset(ai_goal_state_t *state)
     state->active_goal.score = 0.0f;
     state->active_goal.travel_time = 0.0f;
     state->current_area = 0;
+    VectorClear(state->current_origin);
+    state->has_origin = false;
     state->temp_goal_serial = 0U;
     memset(state->candidates, 0, sizeof(state->candidates));
-    memset(&state->avoid_goals, 0, sizeof(state->avoid_goals));
+    AvoidTable_Clear(&state->avoid_goals);
 }
 
 static void ai_move_state_reset(ai_move_state_t *state)
@@ -507,11 +487,17 @@ static void ai_move_default_submit(void *ctx, int client, const bot_input_t *inp
 
 ai_goal_state_t *AI_GoalState_Create(void)
 {
-    ai_goal_state_t *state = (ai_goal_state_t *)calloc(1, sizeof(*state));
+    ai_goal_state_t *state = (ai_goal_state_t *)BotMemory_Calloc(1, sizeof(*state));
     if (state == NULL) {
         return NULL;
     }
 
+    int maxavoid = (int)LibVarValue("max_avoidlist", "32");
+    if (!AvoidTable_Init(&state->avoid_goals, (maxavoid > 0) ? maxavoid : 1)) {
+        free(state);
+        return NULL;
+    }
+
     state->services.weight_fn = ai_goal_default_weight;
     state->services.travel_time_fn = ai_goal_default_travel;
     state->services.notify_fn = NULL;
@@ -528,6 +514,7 @@ void AI_GoalState_Destroy(ai_goal_state_t *state)
         return;
     }
 
+    AvoidTable_Free(&state->avoid_goals);
     free(state);
 }
 
@@ -618,85 +605,19 @@ ai_avoid_list_t *AI_GoalState_GetAvoidList(ai_goal_state_t *state)
     return &state->avoid_goals;
 }
 
-static void ai_avoid_list_remove_index(ai_avoid_list_t *list, int index)
-{
-    if (list == NULL || index < 0 || index >= list->count) {
-        return;
-    }
-
-    for (int i = index; i < list->count - 1; ++i) {
-        list->entries[i] = list->entries[i + 1];
-    }
-
-    if (list->count > 0) {
-        --list->count;
-    }
-}
-
 void AI_AvoidList_Prune(ai_avoid_list_t *list, float now)
 {
-    if (list == NULL) {
-        return;
-    }
-
-    for (int i = 0; i < list->count; ++i) {
-        if (list->entries[i].expiry <= now) {
-            ai_avoid_list_remove_index(list, i);
-            --i;
-        }
-    }
+    AvoidTable_Expire(list, now);
 }
 
 bool AI_AvoidList_Contains(const ai_avoid_list_t *list, int id, float now)
 {
-    if (list == NULL) {
-        return false;
-    }
-
-    for (int i = 0; i < list->count; ++i) {
-        if (list->entries[i].id == id) {
-            if (list->entries[i].expiry > now) {
-                return true;
-            }
-            break;
-        }
-    }
-
-    return false;
+    return AvoidTable_Contains(list, id, now);
 }
 
 bool AI_AvoidList_Add(ai_avoid_list_t *list, int id, float expiry)
 {
-    if (list == NULL) {
-        return false;
-    }
-
-    for (int i = 0; i < list->count; ++i) {
-        if (list->entries[i].id == id) {
-            list->entries[i].expiry = expiry;
-            return true;
-        }
-    }
-
-    if (list->count < AI_GOAL_AVOID_LIST_CAPACITY) {
-        list->entries[list->count].id = id;
-        list->entries[list->count].expiry = expiry;
-        ++list->count;
-        return true;
-    }
-
-    int oldest_index = 0;
-    float oldest_expiry = list->entries[0].expiry;
-    for (int i = 1; i < list->count; ++i) {
-        if (list->entries[i].expiry < oldest_expiry) {
-            oldest_index = i;
-            oldest_expiry = list->entries[i].expiry;
-        }
-    }
-
-    list->entries[oldest_index].id = id;
-    list->entries[oldest_index].expiry = expiry;
-    return true;
+    return AvoidTable_Set(list, id, expiry);
 }
 
 int AI_GoalState_RecordClientUpdate(ai_goal_state_t *state, const struct bot_updateclient_s *update)
@@ -713,6 +634,9 @@ int AI_GoalState_RecordClientUpdate(ai_goal_state_t *state, const struct bot_upd
         state->current_area = area;
     }
 
+    ai_goal_copy_vec(state->current_origin, update->origin);
+    state->has_origin = true;
+
     return BLERR_NOERROR;
 }
 
@@ -768,7 +692,7 @@ int AI_GoalOrchestrator_Refresh(ai_goal_state_t *state, float now, ai_goal_selec
 
 ai_move_state_t *AI_MoveState_Create(void)
 {
-    ai_move_state_t *state = (ai_move_state_t *)calloc(1, sizeof(*state));
+    ai_move_state_t *state = (ai_move_state_t *)BotMemory_Calloc(1, sizeof(*state));
     if (state == NULL) {
         return NULL;
     }
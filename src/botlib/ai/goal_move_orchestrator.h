@@ -4,13 +4,13 @@
 #include "q2bridge/botlib.h"
 #include "shared/q_shared.h"
 #include "botlib/ai_move/bot_move.h"
+#include "botlib/common/l_avoid.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define AI_GOAL_MAX_CANDIDATES 32
-#define AI_GOAL_AVOID_LIST_CAPACITY 32
 
 struct bot_updateclient_s;
 
@@ -29,15 +29,9 @@ typedef struct ai_goal_selection_s {
     float travel_time;
 } ai_goal_selection_t;
 
-typedef struct ai_avoid_entry_s {
-    int id;
-    float expiry;
-} ai_avoid_entry_t;
-
-typedef struct ai_avoid_list_s {
-    ai_avoid_entry_t entries[AI_GOAL_AVOID_LIST_CAPACITY];
-    int count;
-} ai_avoid_list_t;
+/* avoided goal ids, sized by the max_avoidlist libvar */
+typedef bot_avoidentry_t ai_avoid_entry_t;
+typedef bot_avoidtable_t ai_avoid_list_t;
 
 typedef float (*ai_goal_weight_fn)(void *ctx, const ai_goal_candidate_t *candidate);
 typedef float (*ai_goal_travel_time_fn)(void *ctx, int start_area, const ai_goal_candidate_t *candidate);
@@ -72,6 +66,8 @@ typedef struct ai_goal_state_s {
     ai_goal_selection_t active_goal;
     ai_avoid_list_t avoid_goals;
     int current_area;
+    vec3_t current_origin; /* last client update, limits the events heard */
+    bool has_origin;
     unsigned int temp_goal_serial;
 } ai_goal_state_t;
 
@@ -212,6 +212,18 @@ int AI_GoalBotlib_ChooseLTG(int handle, vec3_t origin, int *inventory, int trave
     return BotChooseLTGItem(handle, origin, inventory, travelflags);
 }
 
+int AI_GoalBotlib_AssignLTGs(bot_goalassignment_t *bots, int numbots)
+{
+    for (int i = 0; i < numbots; ++i)
+    {
+        if (!AI_GoalBotlib_ValidateHandle(bots[i].handle))
+        {
+            return 0;
+        }
+    }
+    return BotAssignLTGItems(bots, numbots);
+}
+
 int AI_GoalBotlib_ChooseNBG(int handle, vec3_t origin, int *inventory, int travelflags, bot_goal_t *ltg, float maxtime)
 {
     if (!AI_GoalBotlib_ValidateHandle(handle))
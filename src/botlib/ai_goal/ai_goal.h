@@ -30,6 +30,7 @@ int AI_GoalBotlib_RegisterLevelItem(const bot_levelitem_setup_t *setup);
 void AI_GoalBotlib_UnregisterLevelItem(int number);
 void AI_GoalBotlib_MarkItemTaken(int number, float respawn_delay);
 int AI_GoalBotlib_ChooseLTG(int handle, vec3_t origin, int *inventory, int travelflags);
+int AI_GoalBotlib_AssignLTGs(bot_goalassignment_t *bots, int numbots);
 int AI_GoalBotlib_ChooseNBG(int handle, vec3_t origin, int *inventory, int travelflags, bot_goal_t *ltg, float maxtime);
 const bot_goalstate_t *AI_GoalBotlib_DebugPeek(int handle);
 
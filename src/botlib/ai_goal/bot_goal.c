@@ -15,6 +15,12 @@
 #define BOT_GOAL_MAX_LEVELITEMS 512
 #define BOT_GOAL_TRAVELTIME_SCALE 0.01f
 #define BOT_GOAL_ASSET_MAX_PATH 512
+#define BOT_GOAL_ITEMHASH_SIZE 1024 /* power of two, twice BOT_GOAL_MAX_LEVELITEMS */
+#define BOT_GOAL_MAX_RUNSPEED 320.0f /* fastest ground speed, units per second */
+#define BOT_GOAL_MAX_NEARBYAREAS 1024
+#define BOT_GOAL_ASSIGN_CHOICES 4 /* items each bot offers to the assignment pass */
+#define BOT_GOAL_TRAVELCLASSES 2
+#define BOT_GOAL_TRAVEL_UNREACHABLE 0xFFFFu
 
 static bot_goalstate_t *g_goalstates[MAX_CLIENTS + 1];
 
@@ -29,15 +35,104 @@ typedef struct bot_levelitem_s
     float next_respawn_time;
     int flags;
     bool valid;
+
+    /* chain links hold item index + 1, 0 ends a chain */
+    int hashnext;
+    int areanext;
+    int clusternext;
+    int bucketarea;    /* area bucket the item is filed in, 0 when unfiled */
+    int bucketcluster; /* cluster bucket the item is filed in, 0 when unfiled */
 } bot_levelitem_t;
 
 static bot_levelitem_t g_levelitems[BOT_GOAL_MAX_LEVELITEMS];
 static int g_levelitem_count = 0;
+static int g_levelitem_hash[BOT_GOAL_ITEMHASH_SIZE];
 
 static char g_iteminfo_names[BOT_GOAL_MAX_LEVELITEMS][64];
 static int g_iteminfo_count = 0;
+static int g_iteminfo_hash[BOT_GOAL_ITEMHASH_SIZE];
+static int g_iteminfo_hashnext[BOT_GOAL_MAX_LEVELITEMS];
+
+/*
+ * Per-frame view of the level items that is the same for every bot: where
+ * each item is and whether it can be picked up.  Built once per frame and
+ * rebuilt whenever an item is registered, removed or taken.
+ */
+typedef struct bot_itemsnapshot_s
+{
+    int number;
+    int areanum;
+    vec3_t origin;
+    int iteminfo;
+    float base_weight;
+    float respawn_eta; /* seconds until the item is back, 0 when available */
+    bool available;
+    const bot_levelitem_t *item;
+} bot_itemsnapshot_t;
+
+/* a long-term goal candidate ordered by its best possible score */
+typedef struct bot_goalcandidate_s
+{
+    float bound;
+    float weight;
+    int index;
+} bot_goalcandidate_t;
+
+/* an item a bot could take as its long-term goal */
+typedef struct bot_goalchoice_s
+{
+    float score;
+    int entry; /* snapshot index */
+} bot_goalchoice_t;
+
+typedef struct bot_goalassignpair_s
+{
+    bot_goalchoice_t choice;
+    int bot;
+} bot_goalassignpair_t;
+
+static bot_itemsnapshot_t g_itemsnapshot[BOT_GOAL_MAX_LEVELITEMS];
+static int g_itemsnapshot_slot[BOT_GOAL_MAX_LEVELITEMS]; /* snapshot index per level item, -1 if none */
+static int g_itemsnapshot_count = 0;
+static float g_itemsnapshot_time = 0.0f;
+static bool g_itemsnapshot_dirty = true;
+static int g_goal_route_queries = 0;
+
+/*
+ * Items filed by the area and cluster they sit in, sized for the loaded
+ * AAS world and rebuilt when a different world is loaded.
+ */
+static int *g_item_areabuckets = NULL;
+static int g_item_numareabuckets = 0;
+static int *g_item_clusterbuckets = NULL;
+static int g_item_numclusterbuckets = 0;
+
+/*
+ * Travel times between every pair of level items for each canonical set of
+ * travel flags, indexed [class][from slot][to slot].  Items never move and
+ * route times do not depend on where movers are, so the table only goes
+ * stale when the item list changes or the reachabilities are rebuilt for a
+ * new map.  Nothing is filled until the table is first read; after that it
+ * is filled a few rows per frame and rows not filled yet read as unavailable.
+ */
+typedef struct bot_itemtravelmatrix_s
+{
+    unsigned short *times;
+    int numitems; /* level item slots the table covers */
+    int capacity; /* item slots allocated for */
+    int rowsdone; /* rows filled so far, class by class */
+    unsigned int reachepoch;
+    bool valid;
+    bool requested; /* read at least once, so worth filling */
+} bot_itemtravelmatrix_t;
+
+static const int g_goal_travelclasses[BOT_GOAL_TRAVELCLASSES] = {
+    TFL_DEFAULT,
+    TFL_DEFAULT | TFL_ROCKETJUMP,
+};
+
+static bot_itemtravelmatrix_t g_itemtravel;
 
-static int BotGoal_PointAreaNum(const vec3_t origin);
 static bot_goalstate_t *BotGoalStateFromHandle(int handle);
 static bool BotGoal_EnsureWeightCapacity(bot_goalstate_t *gs);
 static float BotGoal_EvaluateItemWeight(const bot_goalstate_t *gs,
@@ -59,6 +154,11 @@ float BotGoal_CurrentTime(void)
     return g_goal_current_time;
 }
 
+int BotGoal_LastRouteQueries(void)
+{
+    return g_goal_route_queries;
+}
+
 static bot_goalstate_t *BotGoalStateFromHandle(int handle)
 {
     if (handle <= 0 || handle > MAX_CLIENTS)
@@ -89,6 +189,18 @@ int BotAllocGoalState(int client)
             return 0;
         }
 
+        int maxavoidgoals = (int)LibVarValue("max_avoidgoals", "256");
+        int maxavoidreach = (int)LibVarValue("max_avoidreach", "32");
+        if (!AvoidTable_Init(&gs->avoidgoals, (maxavoidgoals > 0) ? maxavoidgoals : 1)
+            || !AvoidTable_Init(&gs->avoidreach, (maxavoidreach > 0) ? maxavoidreach : 1))
+        {
+            BotLib_Print(PRT_FATAL, "BotAllocGoalState: avoid table allocation failed\n");
+            AvoidTable_Free(&gs->avoidgoals);
+            AvoidTable_Free(&gs->avoidreach);
+            FreeMemory(gs);
+            return 0;
+        }
+
         gs->client = client;
         gs->goalstacktop = -1;
         gs->itemweightcount = 0;
@@ -122,6 +234,8 @@ void BotFreeGoalState(int handle)
 
     gs->itemweightcount = 0;
 
+    AvoidTable_Free(&gs->avoidgoals);
+    AvoidTable_Free(&gs->avoidreach);
     FreeMemory(gs);
     g_goalstates[handle] = NULL;
 }
@@ -135,13 +249,10 @@ void BotResetGoalState(int handle)
     }
 
     gs->goalstacktop = -1;
-    gs->numavoidgoals = 0;
-    gs->numavoidreach = 0;
     gs->lastreachabilityarea = 0;
 
-    memset(gs->avoidgoals, 0, sizeof(gs->avoidgoals));
-    memset(gs->avoidreach, 0, sizeof(gs->avoidreach));
-    memset(gs->avoidreachtimes, 0, sizeof(gs->avoidreachtimes));
+    AvoidTable_Clear(&gs->avoidgoals);
+    AvoidTable_Clear(&gs->avoidreach);
 }
 
 static bool BotGoal_BuildWeightPath(const char *filename, char *buffer, size_t size)
@@ -317,8 +428,7 @@ void BotResetAvoidGoals(int handle)
         return;
     }
 
-    gs->numavoidgoals = 0;
-    memset(gs->avoidgoals, 0, sizeof(gs->avoidgoals));
+    AvoidTable_Clear(&gs->avoidgoals);
 }
 
 void BotAddToAvoidGoals(int handle, int number, float avoidtime)
@@ -330,35 +440,7 @@ void BotAddToAvoidGoals(int handle, int number, float avoidtime)
     }
 
     float expiry = BotGoal_CurrentTime() + ((avoidtime > 0.0f) ? avoidtime : 0.0f);
-
-    for (int i = 0; i < gs->numavoidgoals; ++i)
-    {
-        if (gs->avoidgoals[i].number == number)
-        {
-            gs->avoidgoals[i].timeout = expiry;
-            return;
-        }
-    }
-
-    if (gs->numavoidgoals < BOT_GOAL_MAX_AVOID)
-    {
-        gs->avoidgoals[gs->numavoidgoals].number = number;
-        gs->avoidgoals[gs->numavoidgoals].timeout = expiry;
-        gs->numavoidgoals++;
-        return;
-    }
-
-    int oldest = 0;
-    for (int i = 1; i < BOT_GOAL_MAX_AVOID; ++i)
-    {
-        if (gs->avoidgoals[i].timeout < gs->avoidgoals[oldest].timeout)
-        {
-            oldest = i;
-        }
-    }
-
-    gs->avoidgoals[oldest].number = number;
-    gs->avoidgoals[oldest].timeout = expiry;
+    AvoidTable_Set(&gs->avoidgoals, number, expiry);
 }
 
 void BotRemoveFromAvoidGoals(int handle, int number)
@@ -369,18 +451,7 @@ void BotRemoveFromAvoidGoals(int handle, int number)
         return;
     }
 
-    for (int i = 0; i < gs->numavoidgoals; ++i)
-    {
-        if (gs->avoidgoals[i].number == number)
-        {
-            for (int j = i; j < gs->numavoidgoals - 1; ++j)
-            {
-                gs->avoidgoals[j] = gs->avoidgoals[j + 1];
-            }
-            gs->numavoidgoals--;
-            return;
-        }
-    }
+    AvoidTable_Remove(&gs->avoidgoals, number);
 }
 
 float BotAvoidGoalTime(int handle, int number)
@@ -391,16 +462,7 @@ float BotAvoidGoalTime(int handle, int number)
         return 0.0f;
     }
 
-    float now = BotGoal_CurrentTime();
-    for (int i = 0; i < gs->numavoidgoals; ++i)
-    {
-        if (gs->avoidgoals[i].number == number)
-        {
-            float remaining = gs->avoidgoals[i].timeout - now;
-            return (remaining > 0.0f) ? remaining : 0.0f;
-        }
-    }
-    return 0.0f;
+    return AvoidTable_Remaining(&gs->avoidgoals, number, BotGoal_CurrentTime());
 }
 
 void BotSetAvoidGoalTime(int handle, int number, float avoidtime)
@@ -422,9 +484,7 @@ void BotResetAvoidReach(int handle)
         return;
     }
 
-    gs->numavoidreach = 0;
-    memset(gs->avoidreach, 0, sizeof(gs->avoidreach));
-    memset(gs->avoidreachtimes, 0, sizeof(gs->avoidreachtimes));
+    AvoidTable_Clear(&gs->avoidreach);
 }
 
 void BotAddToAvoidReach(int handle, int number, float avoidtime)
@@ -436,33 +496,7 @@ void BotAddToAvoidReach(int handle, int number, float avoidtime)
     }
 
     float expiry = BotGoal_CurrentTime() + ((avoidtime > 0.0f) ? avoidtime : 0.0f);
-    for (int i = 0; i < gs->numavoidreach; ++i)
-    {
-        if (gs->avoidreach[i] == number)
-        {
-            gs->avoidreachtimes[i] = expiry;
-            return;
-        }
-    }
-
-    if (gs->numavoidreach < BOT_GOAL_MAX_AVOIDREACH)
-    {
-        gs->avoidreach[gs->numavoidreach] = number;
-        gs->avoidreachtimes[gs->numavoidreach] = expiry;
-        gs->numavoidreach++;
-        return;
-    }
-
-    int oldest = 0;
-    for (int i = 1; i < BOT_GOAL_MAX_AVOIDREACH; ++i)
-    {
-        if (gs->avoidreachtimes[i] < gs->avoidreachtimes[oldest])
-        {
-            oldest = i;
-        }
-    }
-    gs->avoidreach[oldest] = number;
-    gs->avoidreachtimes[oldest] = expiry;
+    AvoidTable_Set(&gs->avoidreach, number, expiry);
 }
 
 int BotPushGoal(int handle, const bot_goal_t *goal)
@@ -569,72 +603,261 @@ static bool BotGoal_IsAvoided(const bot_goalstate_t *gs, int number)
         return false;
     }
 
-    float now = BotGoal_CurrentTime();
-    for (int i = 0; i < gs->numavoidgoals; ++i)
+    return AvoidTable_Contains(&gs->avoidgoals, number, BotGoal_CurrentTime());
+}
+
+static int BotGoal_NumberHash(int number)
+{
+    unsigned int hash = (unsigned int)number * 2654435761u;
+    return (int)((hash >> 16) & (BOT_GOAL_ITEMHASH_SIZE - 1));
+}
+
+static int BotGoal_ClassnameHash(const char *classname)
+{
+    unsigned int hash = 0;
+    for (int i = 0; classname[i] != '\0'; ++i)
+    {
+        hash += (unsigned char)classname[i] * (119u + (unsigned int)i);
+    }
+    hash = hash ^ (hash >> 10) ^ (hash >> 20);
+    return (int)(hash & (BOT_GOAL_ITEMHASH_SIZE - 1));
+}
+
+static bot_levelitem_t *BotGoal_FindLevelItem(int number)
+{
+    for (int link = g_levelitem_hash[BotGoal_NumberHash(number)]; link != 0;
+         link = g_levelitems[link - 1].hashnext)
+    {
+        bot_levelitem_t *item = &g_levelitems[link - 1];
+        if (item->valid && item->goal.number == number)
+        {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void BotGoal_HashLevelItem(bot_levelitem_t *item)
+{
+    int hash = BotGoal_NumberHash(item->goal.number);
+    item->hashnext = g_levelitem_hash[hash];
+    g_levelitem_hash[hash] = (int)(item - g_levelitems) + 1;
+}
+
+static void BotGoal_UnhashLevelItem(bot_levelitem_t *item)
+{
+    int self = (int)(item - g_levelitems) + 1;
+    int *link = &g_levelitem_hash[BotGoal_NumberHash(item->goal.number)];
+    while (*link != 0)
+    {
+        if (*link == self)
+        {
+            *link = item->hashnext;
+            break;
+        }
+        link = &g_levelitems[*link - 1].hashnext;
+    }
+    item->hashnext = 0;
+}
+
+static int BotGoal_FindItemInfoIndex(const char *classname)
+{
+    if (classname == NULL)
+    {
+        return -1;
+    }
+
+    for (int link = g_iteminfo_hash[BotGoal_ClassnameHash(classname)]; link != 0;
+         link = g_iteminfo_hashnext[link - 1])
     {
-        if (gs->avoidgoals[i].number == number && gs->avoidgoals[i].timeout > now)
+        if (strcmp(g_iteminfo_names[link - 1], classname) == 0)
         {
-            return true;
+            return link - 1;
         }
     }
-    return false;
+    return -1;
 }
 
-static int BotGoal_PointAreaNum(const vec3_t origin)
+static int BotGoal_AreaCluster(int areanum)
 {
-    if (!aasworld.loaded || aasworld.areas == NULL || aasworld.numAreas <= 0)
+    if (aasworld.areasettings == NULL || areanum <= 0 || areanum >= aasworld.numAreaSettings)
     {
         return 0;
     }
 
-    for (int areanum = 1; areanum <= aasworld.numAreas; ++areanum)
+    int cluster = aasworld.areasettings[areanum].cluster;
+    return (cluster > 0 && cluster < g_item_numclusterbuckets) ? cluster : 0;
+}
+
+/* pushes an item on the bucket for its area and cluster */
+static void BotGoal_FileLevelItem(bot_levelitem_t *item)
+{
+    int self = (int)(item - g_levelitems) + 1;
+    int area = item->goal.areanum;
+    if (area > 0 && area < g_item_numareabuckets)
+    {
+        item->areanext = g_item_areabuckets[area];
+        g_item_areabuckets[area] = self;
+        item->bucketarea = area;
+    }
+
+    int cluster = BotGoal_AreaCluster(area);
+    if (cluster > 0)
+    {
+        item->clusternext = g_item_clusterbuckets[cluster];
+        g_item_clusterbuckets[cluster] = self;
+        item->bucketcluster = cluster;
+    }
+}
+
+static void BotGoal_UnfileLevelItem(bot_levelitem_t *item)
+{
+    int self = (int)(item - g_levelitems) + 1;
+    if (item->bucketarea > 0 && item->bucketarea < g_item_numareabuckets)
     {
-        const aas_area_t *area = &aasworld.areas[areanum];
-        if (origin[0] < area->mins[0] || origin[0] > area->maxs[0])
+        int *link = &g_item_areabuckets[item->bucketarea];
+        while (*link != 0 && *link != self)
         {
-            continue;
+            link = &g_levelitems[*link - 1].areanext;
         }
-        if (origin[1] < area->mins[1] || origin[1] > area->maxs[1])
+        if (*link == self)
         {
-            continue;
+            *link = item->areanext;
         }
-        if (origin[2] < area->mins[2] || origin[2] > area->maxs[2])
+    }
+
+    if (item->bucketcluster > 0 && item->bucketcluster < g_item_numclusterbuckets)
+    {
+        int *link = &g_item_clusterbuckets[item->bucketcluster];
+        while (*link != 0 && *link != self)
         {
-            continue;
+            link = &g_levelitems[*link - 1].clusternext;
+        }
+        if (*link == self)
+        {
+            *link = item->clusternext;
         }
-        return areanum;
     }
 
-    return 0;
+    item->areanext = 0;
+    item->clusternext = 0;
+    item->bucketarea = 0;
+    item->bucketcluster = 0;
 }
 
-static bot_levelitem_t *BotGoal_FindLevelItem(int number)
+static void BotGoal_FreeItemBuckets(void)
+{
+    if (g_item_areabuckets != NULL)
+    {
+        FreeMemory(g_item_areabuckets);
+        g_item_areabuckets = NULL;
+    }
+    if (g_item_clusterbuckets != NULL)
+    {
+        FreeMemory(g_item_clusterbuckets);
+        g_item_clusterbuckets = NULL;
+    }
+    g_item_numareabuckets = 0;
+    g_item_numclusterbuckets = 0;
+}
+
+/*
+ * Keeps the buckets sized for the loaded world.  A world with a different
+ * area or cluster count gets fresh buckets and every item is filed again.
+ */
+static bool BotGoal_EnsureItemBuckets(void)
 {
+    int numareas = (aasworld.loaded && aasworld.numAreas > 0) ? aasworld.numAreas + 1 : 0;
+    int numclusters = (numareas > 0 && aasworld.numClusters > 0) ? aasworld.numClusters + 1 : 0;
+    if (numareas == g_item_numareabuckets && numclusters == g_item_numclusterbuckets)
+    {
+        return numareas > 0;
+    }
+
+    BotGoal_FreeItemBuckets();
     for (int i = 0; i < g_levelitem_count; ++i)
     {
-        if (g_levelitems[i].valid && g_levelitems[i].goal.number == number)
+        g_levelitems[i].areanext = 0;
+        g_levelitems[i].clusternext = 0;
+        g_levelitems[i].bucketarea = 0;
+        g_levelitems[i].bucketcluster = 0;
+    }
+
+    if (numareas <= 0)
+    {
+        return false;
+    }
+
+    g_item_areabuckets = (int *)GetClearedMemory((size_t)numareas * sizeof(int));
+    if (g_item_areabuckets == NULL)
+    {
+        return false;
+    }
+    g_item_numareabuckets = numareas;
+
+    if (numclusters > 0)
+    {
+        g_item_clusterbuckets = (int *)GetClearedMemory((size_t)numclusters * sizeof(int));
+        if (g_item_clusterbuckets != NULL)
         {
-            return &g_levelitems[i];
+            g_item_numclusterbuckets = numclusters;
         }
     }
-    return NULL;
-}
 
-static int BotGoal_FindItemInfoIndex(const char *classname)
-{
-    if (classname == NULL)
+    /* file in reverse so each bucket lists items in registration order */
+    for (int i = g_levelitem_count - 1; i >= 0; --i)
     {
-        return -1;
+        if (g_levelitems[i].valid)
+        {
+            BotGoal_FileLevelItem(&g_levelitems[i]);
+        }
     }
+    return true;
+}
 
-    for (int i = 0; i < g_iteminfo_count; ++i)
+static int BotGoal_CollectBucket(int link, bool byarea, int *numbers, int maxnumbers)
+{
+    int count = 0;
+    while (link != 0 && count < maxnumbers)
     {
-        if (strcmp(g_iteminfo_names[i], classname) == 0)
+        const bot_levelitem_t *item = &g_levelitems[link - 1];
+        if (item->valid)
         {
-            return i;
+            numbers[count++] = item->goal.number;
         }
+        link = byarea ? item->areanext : item->clusternext;
     }
-    return -1;
+    return count;
+}
+
+int BotGoal_ItemsInArea(int areanum, int *numbers, int maxnumbers)
+{
+    if (numbers == NULL || maxnumbers <= 0 || !BotGoal_EnsureItemBuckets())
+    {
+        return 0;
+    }
+
+    if (areanum <= 0 || areanum >= g_item_numareabuckets)
+    {
+        return 0;
+    }
+
+    return BotGoal_CollectBucket(g_item_areabuckets[areanum], true, numbers, maxnumbers);
+}
+
+int BotGoal_ItemsInCluster(int cluster, int *numbers, int maxnumbers)
+{
+    if (numbers == NULL || maxnumbers <= 0 || !BotGoal_EnsureItemBuckets())
+    {
+        return 0;
+    }
+
+    if (cluster <= 0 || cluster >= g_item_numclusterbuckets)
+    {
+        return 0;
+    }
+
+    return BotGoal_CollectBucket(g_item_clusterbuckets[cluster], false, numbers, maxnumbers);
 }
 
 static int BotGoal_RegisterItemInfo(const char *classname)
@@ -661,6 +884,10 @@ static int BotGoal_RegisterItemInfo(const char *classname)
     int index = g_iteminfo_count;
     g_iteminfo_count++;
 
+    int hash = BotGoal_ClassnameHash(g_iteminfo_names[index]);
+    g_iteminfo_hashnext[index] = g_iteminfo_hash[hash];
+    g_iteminfo_hash[hash] = index + 1;
+
     for (int handle = 1; handle <= MAX_CLIENTS; ++handle)
     {
         bot_goalstate_t *gs = g_goalstates[handle];
@@ -715,6 +942,17 @@ int BotGoal_RegisterLevelItem(const bot_levelitem_setup_t *setup)
         }
     }
 
+    BotGoal_EnsureItemBuckets();
+    if (existing != NULL)
+    {
+        BotGoal_UnfileLevelItem(existing);
+    }
+    else
+    {
+        slot->goal.number = setup->goal.number;
+        BotGoal_HashLevelItem(slot);
+    }
+
     slot->goal = setup->goal;
     slot->goal.iteminfo = iteminfo;
     slot->goal.flags = setup->flags;
@@ -725,7 +963,7 @@ int BotGoal_RegisterLevelItem(const bot_levelitem_setup_t *setup)
 
     if (slot->goal.areanum <= 0)
     {
-        slot->goal.areanum = BotGoal_PointAreaNum(slot->goal.origin);
+        slot->goal.areanum = AAS_PointAreaNum(slot->goal.origin);
     }
 
     strncpy(slot->classname, setup->classname, sizeof(slot->classname) - 1);
@@ -735,6 +973,9 @@ int BotGoal_RegisterLevelItem(const bot_levelitem_setup_t *setup)
     slot->next_respawn_time = BotGoal_CurrentTime();
     slot->flags = setup->flags;
     slot->valid = true;
+    BotGoal_FileLevelItem(slot);
+    g_itemsnapshot_dirty = true;
+    g_itemtravel.valid = false;
     return slot->goal.number;
 }
 
@@ -743,8 +984,159 @@ void BotGoal_UnregisterLevelItem(int number)
     bot_levelitem_t *item = BotGoal_FindLevelItem(number);
     if (item != NULL)
     {
+        BotGoal_EnsureItemBuckets();
+        BotGoal_UnfileLevelItem(item);
+        BotGoal_UnhashLevelItem(item);
         item->valid = false;
+        g_itemsnapshot_dirty = true;
+        g_itemtravel.valid = false;
+    }
+}
+
+static void BotGoal_FreeItemTravelMatrix(void)
+{
+    if (g_itemtravel.times != NULL)
+    {
+        FreeMemory(g_itemtravel.times);
+    }
+    memset(&g_itemtravel, 0, sizeof(g_itemtravel));
+}
+
+static int BotGoal_TravelClass(int travelflags)
+{
+    for (int i = 0; i < BOT_GOAL_TRAVELCLASSES; ++i)
+    {
+        if (g_goal_travelclasses[i] == travelflags)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool BotGoal_ItemTravelMatrixCurrent(void)
+{
+    return g_itemtravel.valid && g_itemtravel.reachepoch == aasworld.reachabilityEpoch
+           && g_itemtravel.numitems == g_levelitem_count;
+}
+
+static void BotGoal_FillItemTravelRow(int row)
+{
+    int numitems = g_itemtravel.numitems;
+    int travelflags = g_goal_travelclasses[row / numitems];
+    const bot_levelitem_t *from = &g_levelitems[row % numitems];
+    unsigned short *times = &g_itemtravel.times[(size_t)row * (size_t)numitems];
+
+    for (int to = 0; to < numitems; ++to)
+    {
+        const bot_levelitem_t *item = &g_levelitems[to];
+        times[to] = BOT_GOAL_TRAVEL_UNREACHABLE;
+        if (!from->valid || !item->valid || from->goal.areanum <= 0 || item->goal.areanum <= 0)
+        {
+            continue;
+        }
+
+        if (from == item)
+        {
+            times[to] = 0;
+            continue;
+        }
+
+        vec3_t start;
+        VectorCopy(from->goal.origin, start);
+        int time = AAS_AreaTravelTimeToGoalArea(from->goal.areanum, start, item->goal.areanum, travelflags);
+        if (time <= 0 && from->goal.areanum != item->goal.areanum)
+        {
+            continue;
+        }
+        times[to] = (unsigned short)((time < (int)BOT_GOAL_TRAVEL_UNREACHABLE) ? time
+                                                                               : (int)BOT_GOAL_TRAVEL_UNREACHABLE - 1);
+    }
+}
+
+/*
+ * Fills up to maxrows rows of the item travel matrix once something has read
+ * it, starting over when the items or the reachabilities have changed since
+ * it was begun.
+ */
+void BotGoal_UpdateItemTravelMatrix(int maxrows)
+{
+    if (!aasworld.loaded || aasworld.numAreas <= 0)
+    {
+        BotGoal_FreeItemTravelMatrix();
+        return;
+    }
+
+    if (!g_itemtravel.requested)
+    {
+        return;
+    }
+
+    if (!BotGoal_ItemTravelMatrixCurrent())
+    {
+        int numitems = g_levelitem_count;
+        if (numitems > g_itemtravel.capacity)
+        {
+            BotGoal_FreeItemTravelMatrix();
+            g_itemtravel.requested = true;
+            size_t size = (size_t)BOT_GOAL_TRAVELCLASSES * (size_t)numitems * (size_t)numitems;
+            g_itemtravel.times = (unsigned short *)GetMemory(size * sizeof(unsigned short));
+            if (g_itemtravel.times == NULL)
+            {
+                BotLib_Print(PRT_ERROR, "BotGoal_UpdateItemTravelMatrix: out of memory for %d items\n", numitems);
+                return;
+            }
+            g_itemtravel.capacity = numitems;
+        }
+
+        g_itemtravel.numitems = numitems;
+        g_itemtravel.rowsdone = 0;
+        g_itemtravel.reachepoch = aasworld.reachabilityEpoch;
+        g_itemtravel.valid = true;
+    }
+
+    int totalrows = BOT_GOAL_TRAVELCLASSES * g_itemtravel.numitems;
+    for (int i = 0; i < maxrows && g_itemtravel.rowsdone < totalrows; ++i)
+    {
+        BotGoal_FillItemTravelRow(g_itemtravel.rowsdone++);
+    }
+}
+
+bool BotGoal_ItemTravelMatrixComplete(int travelflags)
+{
+    g_itemtravel.requested = true;
+    int travelclass = BotGoal_TravelClass(travelflags);
+    if (travelclass < 0 || !BotGoal_ItemTravelMatrixCurrent())
+    {
+        return false;
     }
+    return g_itemtravel.rowsdone >= (travelclass + 1) * g_itemtravel.numitems;
+}
+
+int BotGoal_ItemTravelTime(int from_number, int to_number, int travelflags)
+{
+    g_itemtravel.requested = true;
+    int travelclass = BotGoal_TravelClass(travelflags);
+    if (travelclass < 0 || !BotGoal_ItemTravelMatrixCurrent())
+    {
+        return -1;
+    }
+
+    const bot_levelitem_t *from = BotGoal_FindLevelItem(from_number);
+    const bot_levelitem_t *to = BotGoal_FindLevelItem(to_number);
+    if (from == NULL || to == NULL)
+    {
+        return -1;
+    }
+
+    int row = travelclass * g_itemtravel.numitems + (int)(from - g_levelitems);
+    if (row >= g_itemtravel.rowsdone)
+    {
+        return -1;
+    }
+
+    unsigned short time = g_itemtravel.times[(size_t)row * (size_t)g_itemtravel.numitems + (size_t)(to - g_levelitems)];
+    return (time == BOT_GOAL_TRAVEL_UNREACHABLE) ? 0 : (int)time;
 }
 
 void BotGoal_MarkItemTaken(int number, float respawn_delay)
@@ -766,32 +1158,93 @@ void BotGoal_MarkItemTaken(int number, float respawn_delay)
     }
 
     item->next_respawn_time = BotGoal_CurrentTime() + delay;
+    g_itemsnapshot_dirty = true;
 }
 
-static float BotGoal_LevelItemScore(bot_goalstate_t *gs,
-                                    const bot_levelitem_t *item,
-                                    const vec3_t origin,
-                                    int start_area,
+void BotGoal_UpdateItemSnapshot(float now)
+{
+    BotGoal_SetCurrentTime(now);
+
+    int count = 0;
+    for (int i = 0; i < g_levelitem_count; ++i)
+    {
+        const bot_levelitem_t *item = &g_levelitems[i];
+        g_itemsnapshot_slot[i] = -1;
+        if (!item->valid)
+        {
+            continue;
+        }
+
+        g_itemsnapshot_slot[i] = count;
+        bot_itemsnapshot_t *entry = &g_itemsnapshot[count++];
+        entry->number = item->goal.number;
+        entry->areanum = item->goal.areanum;
+        VectorCopy(item->goal.origin, entry->origin);
+        entry->iteminfo = item->goal.iteminfo;
+        entry->base_weight = item->base_weight;
+        entry->respawn_eta = (item->next_respawn_time > now) ? item->next_respawn_time - now : 0.0f;
+        entry->available = (entry->respawn_eta <= 0.0f && entry->areanum > 0);
+        entry->item = item;
+    }
+
+    g_itemsnapshot_count = count;
+    g_itemsnapshot_time = now;
+    g_itemsnapshot_dirty = false;
+}
+
+/* the snapshot for the current goal time, rebuilt if anything changed */
+static int BotGoal_ItemSnapshot(const bot_itemsnapshot_t **entries)
+{
+    float now = BotGoal_CurrentTime();
+    if (g_itemsnapshot_dirty || g_itemsnapshot_time != now)
+    {
+        BotGoal_UpdateItemSnapshot(now);
+    }
+
+    *entries = g_itemsnapshot;
+    return g_itemsnapshot_count;
+}
+
+/* an item's score once its travel time is known */
+static float BotGoal_TimedItemScore(bot_goalstate_t *gs,
+                                    int iteminfo,
+                                    float base_weight,
                                     const int *inventory,
-                                    int travelflags,
-                                    int *travel_time)
+                                    int travel_time)
 {
-    if (item == NULL || !item->valid)
+    float weight = BotGoal_EvaluateItemWeight(gs, inventory, iteminfo);
+    weight += base_weight;
+    if (weight <= 0.0f)
     {
         return -FLT_MAX;
     }
 
-    if (item->goal.areanum <= 0)
+    float score = weight - (float)travel_time * BOT_GOAL_TRAVELTIME_SCALE;
+    return score;
+}
+
+/* the bot-specific part of an item's score: its weight and travel time */
+static float BotGoal_ItemScore(bot_goalstate_t *gs,
+                               int iteminfo,
+                               float base_weight,
+                               int areanum,
+                               const vec3_t origin,
+                               int start_area,
+                               const int *inventory,
+                               int travelflags,
+                               int *travel_time)
+{
+    if (areanum <= 0)
     {
         return -FLT_MAX;
     }
 
     int time = 0;
-    if (start_area > 0 && item->goal.areanum > 0)
+    if (start_area > 0)
     {
         vec3_t start;
         VectorCopy(origin, start);
-        time = AAS_AreaTravelTimeToGoalArea(start_area, start, item->goal.areanum, travelflags);
+        time = AAS_AreaTravelTimeToGoalArea(start_area, start, areanum, travelflags);
     }
 
     if (travel_time != NULL)
@@ -799,73 +1252,478 @@ static float BotGoal_LevelItemScore(bot_goalstate_t *gs,
         *travel_time = time;
     }
 
-    float weight = BotGoal_EvaluateItemWeight(gs, inventory, item->goal.iteminfo);
-    weight += item->base_weight;
-    if (weight <= 0.0f)
+    return BotGoal_TimedItemScore(gs, iteminfo, base_weight, inventory, time);
+}
+
+/*
+ * Fastest speed, in units per second, at which any reachability usable with
+ * travelflags covers ground: the straight distance between its start and end
+ * over its travel time, but never below the run speed.  Teleporters, jump
+ * pads and falls can move far faster than a bot runs, and a reachability
+ * that moves the bot for no travel time at all returns FLT_MAX so nothing is
+ * pruned.  The result is cached until the flags or the reachabilities change;
+ * mover updates only bump the route epoch, which leaves these speeds alone.
+ */
+static float BotGoal_MaxTravelSpeed(int travelflags)
+{
+    static const aas_reachability_t *cached_reach = NULL;
+    static int cached_numreach = -1;
+    static unsigned int cached_epoch = 0;
+    static int cached_flags = 0;
+    static float cached_speed = BOT_GOAL_MAX_RUNSPEED;
+
+    if (cached_reach == aasworld.reachability && cached_numreach == aasworld.numReachability
+        && cached_epoch == aasworld.reachabilityEpoch && cached_flags == travelflags)
     {
-        return -FLT_MAX;
+        return cached_speed;
     }
 
-    float score = weight - (float)time * BOT_GOAL_TRAVELTIME_SCALE;
-    return score;
+    float speed = BOT_GOAL_MAX_RUNSPEED;
+    for (int i = 1; aasworld.reachability != NULL && i < aasworld.numReachability; ++i)
+    {
+        const aas_reachability_t *reach = &aasworld.reachability[i];
+        int required = AAS_TravelFlagForType(reach->traveltype);
+        if ((required & travelflags) != required)
+        {
+            continue;
+        }
+
+        vec3_t delta;
+        VectorSubtract(reach->end, reach->start, delta);
+        float dist = sqrtf(DotProduct(delta, delta));
+        if (dist <= 0.0f)
+        {
+            continue;
+        }
+        if (reach->traveltime == 0)
+        {
+            speed = FLT_MAX;
+            break;
+        }
+
+        float reachspeed = dist * 100.0f / (float)reach->traveltime;
+        if (reachspeed > speed)
+        {
+            speed = reachspeed;
+        }
+    }
+
+    cached_reach = aasworld.reachability;
+    cached_numreach = aasworld.numReachability;
+    cached_epoch = aasworld.reachabilityEpoch;
+    cached_flags = travelflags;
+    cached_speed = speed;
+    return speed;
 }
 
-int BotChooseLTGItem(int handle, const vec3_t origin, const int *inventory, int travelflags)
+/*
+ * Estimated lower bound on the travel time, in hundredths of a second, from
+ * origin to an area: the straight-line distance to the area's bounds covered
+ * at the fastest speed any allowed reachability moves.  This is a heuristic,
+ * not a strict bound: the router charges only for the start area and the
+ * reachabilities, so walking across intermediate areas is free to it and a
+ * route can come in under the estimate.  Returns 0 when no area data is
+ * loaded.
+ */
+static float BotGoal_TravelTimeLowerBound(const vec3_t origin, int areanum, int travelflags)
 {
-    bot_goalstate_t *gs = BotGoalStateFromHandle(handle);
-    if (gs == NULL)
+    if (aasworld.areas == NULL || areanum <= 0 || areanum > aasworld.numAreas)
+    {
+        return 0.0f;
+    }
+
+    float speed = BotGoal_MaxTravelSpeed(travelflags);
+    if (speed >= FLT_MAX)
+    {
+        return 0.0f;
+    }
+
+    const aas_area_t *area = &aasworld.areas[areanum];
+    float distsq = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float delta = 0.0f;
+        if (origin[axis] < area->mins[axis])
+        {
+            delta = area->mins[axis] - origin[axis];
+        }
+        else if (origin[axis] > area->maxs[axis])
+        {
+            delta = origin[axis] - area->maxs[axis];
+        }
+        distsq += delta * delta;
+    }
+
+    return sqrtf(distsq) * 100.0f / speed;
+}
+
+static int BotGoal_CompareCandidates(const void *a, const void *b)
+{
+    const bot_goalcandidate_t *ca = (const bot_goalcandidate_t *)a;
+    const bot_goalcandidate_t *cb = (const bot_goalcandidate_t *)b;
+    if (ca->bound != cb->bound)
+    {
+        return (ca->bound > cb->bound) ? -1 : 1;
+    }
+    return ca->index - cb->index;
+}
+
+/*
+ * Gathers the snapshot entries of the items that can be reached from
+ * start_area within maxtime, together with their travel times.  Only the
+ * areas inside that radius are expanded, nearest first, and their items are
+ * read from the area buckets.  The snapshot must be current.
+ */
+static int BotGoal_NearbyItems(const vec3_t origin,
+                               int start_area,
+                               int travelflags,
+                               int maxtime,
+                               int *entries,
+                               int *travel_times,
+                               int maxentries)
+{
+    if (!BotGoal_EnsureItemBuckets())
     {
         return 0;
     }
 
-    int start_area = BotGoal_PointAreaNum(origin);
+    int areas[BOT_GOAL_MAX_NEARBYAREAS];
+    int areatimes[BOT_GOAL_MAX_NEARBYAREAS];
+    int numareas = AAS_AreasWithinTravelTime(start_area,
+                                             origin,
+                                             travelflags,
+                                             maxtime,
+                                             areas,
+                                             areatimes,
+                                             BOT_GOAL_MAX_NEARBYAREAS);
+
+    int count = 0;
+    for (int i = 0; i < numareas && count < maxentries; ++i)
+    {
+        if (areas[i] <= 0 || areas[i] >= g_item_numareabuckets)
+        {
+            continue;
+        }
+
+        int link = g_item_areabuckets[areas[i]];
+        while (link != 0 && count < maxentries)
+        {
+            int slot = link - 1;
+            if (g_itemsnapshot_slot[slot] >= 0)
+            {
+                entries[count] = g_itemsnapshot_slot[slot];
+                travel_times[count] = areatimes[i];
+                ++count;
+            }
+            link = g_levelitems[slot].areanext;
+        }
+    }
+
+    return count;
+}
+
+static float BotGoal_LevelItemScore(bot_goalstate_t *gs,
+                                    const bot_levelitem_t *item,
+                                    const vec3_t origin,
+                                    int start_area,
+                                    const int *inventory,
+                                    int travelflags,
+                                    int *travel_time)
+{
+    if (item == NULL || !item->valid)
+    {
+        return -FLT_MAX;
+    }
+
+    return BotGoal_ItemScore(gs,
+                             item->goal.iteminfo,
+                             item->base_weight,
+                             item->goal.areanum,
+                             origin,
+                             start_area,
+                             inventory,
+                             travelflags,
+                             travel_time);
+}
+
+static int BotGoal_StartArea(bot_goalstate_t *gs, const vec3_t origin)
+{
+    int start_area = AAS_PointAreaNumHinted(origin, gs->lastreachabilityarea);
     if (start_area <= 0)
     {
         start_area = gs->lastreachabilityarea;
     }
+    return start_area;
+}
 
-    float now = BotGoal_CurrentTime();
-    float best_score = -FLT_MAX;
-    const bot_levelitem_t *best_item = NULL;
-    bot_goal_t best_goal = {0};
+/*
+ * Finds the bot's best long-term goals, best first, skipping snapshot entries
+ * marked in claimed.  Every candidate is scored optimistically first: the
+ * travel time is taken to be no shorter than a straight line to the item's
+ * area at the fastest allowed reachability speed.
+ * Candidates are then visited best bound first and the route is only queried
+ * while a bound can still beat the worst choice kept.  A bot standing in an
+ * item's area, typically just after picking it up, reads the travel times
+ * from that item's row of the item travel matrix instead, and only falls
+ * back to the router while the row is not filled yet.
+ */
+static int BotGoal_RankLTGItems(bot_goalstate_t *gs,
+                                const vec3_t origin,
+                                int start_area,
+                                const int *inventory,
+                                int travelflags,
+                                const bool *claimed,
+                                bot_goalchoice_t *choices,
+                                int maxchoices)
+{
+    AvoidTable_Expire(&gs->avoidgoals, BotGoal_CurrentTime());
+    AvoidTable_Expire(&gs->avoidreach, BotGoal_CurrentTime());
 
-    for (int i = 0; i < g_levelitem_count; ++i)
+    const bot_itemsnapshot_t *snapshot = NULL;
+    int count = BotGoal_ItemSnapshot(&snapshot);
+
+    bot_goalcandidate_t candidates[BOT_GOAL_MAX_LEVELITEMS];
+    int numcandidates = 0;
+    for (int i = 0; i < count; ++i)
     {
-        const bot_levelitem_t *item = &g_levelitems[i];
-        if (!item->valid)
+        const bot_itemsnapshot_t *entry = &snapshot[i];
+        if (!entry->available || (claimed != NULL && claimed[i]))
         {
             continue;
         }
 
-        if (BotGoal_IsAvoided(gs, item->goal.number))
+        if (BotGoal_IsAvoided(gs, entry->number))
         {
             continue;
         }
 
-        if (item->next_respawn_time > now)
+        float weight = BotGoal_EvaluateItemWeight(gs, inventory, entry->iteminfo) + entry->base_weight;
+        if (weight <= 0.0f)
         {
             continue;
         }
 
+        float lower = (start_area > 0) ? BotGoal_TravelTimeLowerBound(origin, entry->areanum, travelflags) : 0.0f;
+        bot_goalcandidate_t *candidate = &candidates[numcandidates++];
+        candidate->bound = weight - lower * BOT_GOAL_TRAVELTIME_SCALE;
+        candidate->weight = weight;
+        candidate->index = i;
+    }
+
+    qsort(candidates, (size_t)numcandidates, sizeof(candidates[0]), BotGoal_CompareCandidates);
+
+    int from_item = 0;
+    if (start_area > 0 && BotGoal_ItemsInArea(start_area, &from_item, 1) == 0)
+    {
+        from_item = 0;
+    }
+
+    int numchoices = 0;
+    for (int i = 0; i < numcandidates; ++i)
+    {
+        const bot_goalcandidate_t *candidate = &candidates[i];
+        float cutoff = (numchoices < maxchoices) ? -FLT_MAX : choices[maxchoices - 1].score;
+        if (candidate->bound <= cutoff)
+        {
+            break;
+        }
+
+        const bot_itemsnapshot_t *entry = &snapshot[candidate->index];
         int travel_time = 0;
-        float score = BotGoal_LevelItemScore(gs, item, origin, start_area, inventory, travelflags, &travel_time);
-        if (score <= best_score)
+        if (start_area > 0)
+        {
+            travel_time = (from_item > 0) ? BotGoal_ItemTravelTime(from_item, entry->number, travelflags) : -1;
+            if (travel_time < 0)
+            {
+                vec3_t start;
+                VectorCopy(origin, start);
+                travel_time = AAS_AreaTravelTimeToGoalArea(start_area, start, entry->areanum, travelflags);
+                g_goal_route_queries += 1;
+            }
+
+            /* the router reports unreachable areas as zero travel time */
+            if (travel_time <= 0 && entry->areanum != start_area)
+            {
+                continue;
+            }
+        }
+
+        float score = candidate->weight - (float)travel_time * BOT_GOAL_TRAVELTIME_SCALE;
+        if (score <= cutoff)
         {
             continue;
         }
 
-        best_score = score;
-        best_item = item;
-        best_goal = item->goal;
+        /* insert after equal scores so earlier candidates win ties */
+        int slot = (numchoices < maxchoices) ? numchoices++ : maxchoices - 1;
+        while (slot > 0 && choices[slot - 1].score < score)
+        {
+            choices[slot] = choices[slot - 1];
+            --slot;
+        }
+        choices[slot].score = score;
+        choices[slot].entry = candidate->index;
     }
 
-    if (best_item == NULL)
+    return numchoices;
+}
+
+int BotChooseLTGItem(int handle, const vec3_t origin, const int *inventory, int travelflags)
+{
+    bot_goalstate_t *gs = BotGoalStateFromHandle(handle);
+    if (gs == NULL)
+    {
+        return 0;
+    }
+
+    int start_area = BotGoal_StartArea(gs, origin);
+    g_goal_route_queries = 0;
+
+    bot_goalchoice_t choice;
+    if (BotGoal_RankLTGItems(gs, origin, start_area, inventory, travelflags, NULL, &choice, 1) == 0)
     {
         return 0;
     }
 
     gs->lastreachabilityarea = start_area;
-    return BotPushGoal(handle, &best_goal);
+    bot_goal_t goal = g_itemsnapshot[choice.entry].item->goal;
+    return BotPushGoal(handle, &goal);
+}
+
+static int BotGoal_CompareAssignPairs(const void *a, const void *b)
+{
+    const bot_goalassignpair_t *pa = (const bot_goalassignpair_t *)a;
+    const bot_goalassignpair_t *pb = (const bot_goalassignpair_t *)b;
+    if (pa->choice.score != pb->choice.score)
+    {
+        return (pa->choice.score > pb->choice.score) ? -1 : 1;
+    }
+    if (pa->bot != pb->bot)
+    {
+        return pa->bot - pb->bot;
+    }
+    return pa->choice.entry - pb->choice.entry;
+}
+
+/*
+ * Hands out long-term goals to several bots at once.  Each bot ranks its
+ * few best items, then the highest scoring (bot, item) pairs are granted
+ * greedily so no two bots in the pass head for the same item.  A bot whose
+ * favourites all went to others takes the best item still free, and only
+ * shares its favourite when nothing is left.  The chosen goals are pushed
+ * like BotChooseLTGItem does.  Returns the number of bots given a goal.
+ */
+int BotAssignLTGItems(bot_goalassignment_t *bots, int numbots)
+{
+    static bot_goalassignpair_t pairs[MAX_CLIENTS * BOT_GOAL_ASSIGN_CHOICES];
+    static int start_areas[MAX_CLIENTS];
+    static int entries[MAX_CLIENTS];
+    static int favourites[MAX_CLIENTS];
+    static bool claimed[BOT_GOAL_MAX_LEVELITEMS];
+
+    if (bots == NULL || numbots <= 0)
+    {
+        return 0;
+    }
+
+    if (numbots > MAX_CLIENTS)
+    {
+        BotLib_Print(PRT_WARNING, "BotAssignLTGItems: %d bots, only the first %d assigned\n", numbots, MAX_CLIENTS);
+        numbots = MAX_CLIENTS;
+    }
+
+    const bot_itemsnapshot_t *snapshot = NULL;
+    int count = BotGoal_ItemSnapshot(&snapshot);
+    memset(claimed, 0, (size_t)count * sizeof(claimed[0]));
+    g_goal_route_queries = 0;
+
+    int numpairs = 0;
+    for (int i = 0; i < numbots; ++i)
+    {
+        bots[i].number = 0;
+        entries[i] = -1;
+        favourites[i] = -1;
+
+        bot_goalstate_t *gs = BotGoalStateFromHandle(bots[i].handle);
+        if (gs == NULL)
+        {
+            continue;
+        }
+
+        start_areas[i] = BotGoal_StartArea(gs, bots[i].origin);
+        bot_goalchoice_t choices[BOT_GOAL_ASSIGN_CHOICES];
+        int numchoices = BotGoal_RankLTGItems(gs,
+                                              bots[i].origin,
+                                              start_areas[i],
+                                              bots[i].inventory,
+                                              bots[i].travelflags,
+                                              NULL,
+                                              choices,
+                                              BOT_GOAL_ASSIGN_CHOICES);
+        for (int c = 0; c < numchoices; ++c)
+        {
+            pairs[numpairs].choice = choices[c];
+            pairs[numpairs].bot = i;
+            ++numpairs;
+        }
+        if (numchoices > 0)
+        {
+            favourites[i] = choices[0].entry;
+        }
+    }
+
+    qsort(pairs, (size_t)numpairs, sizeof(pairs[0]), BotGoal_CompareAssignPairs);
+    for (int p = 0; p < numpairs; ++p)
+    {
+        const bot_goalassignpair_t *pair = &pairs[p];
+        if (entries[pair->bot] >= 0 || claimed[pair->choice.entry])
+        {
+            continue;
+        }
+        entries[pair->bot] = pair->choice.entry;
+        claimed[pair->choice.entry] = true;
+    }
+
+    int assigned = 0;
+    for (int i = 0; i < numbots; ++i)
+    {
+        if (favourites[i] < 0)
+        {
+            continue;
+        }
+
+        bot_goalstate_t *gs = BotGoalStateFromHandle(bots[i].handle);
+        if (entries[i] < 0)
+        {
+            bot_goalchoice_t choice;
+            if (BotGoal_RankLTGItems(gs,
+                                     bots[i].origin,
+                                     start_areas[i],
+                                     bots[i].inventory,
+                                     bots[i].travelflags,
+                                     claimed,
+                                     &choice,
+                                     1) > 0)
+            {
+                entries[i] = choice.entry;
+                claimed[choice.entry] = true;
+            }
+            else
+            {
+                entries[i] = favourites[i];
+            }
+        }
+
+        gs->lastreachabilityarea = start_areas[i];
+        bot_goal_t goal = snapshot[entries[i]].item->goal;
+        if (BotPushGoal(bots[i].handle, &goal))
+        {
+            bots[i].number = goal.number;
+            ++assigned;
+        }
+    }
+
+    return assigned;
 }
 
 int BotChooseNBGItem(int handle,
@@ -881,43 +1739,75 @@ int BotChooseNBGItem(int handle,
         return 0;
     }
 
-    int start_area = BotGoal_PointAreaNum(origin);
+    int start_area = AAS_PointAreaNumHinted(origin, gs->lastreachabilityarea);
     if (start_area <= 0)
     {
         start_area = gs->lastreachabilityarea;
     }
 
-    float now = BotGoal_CurrentTime();
+    AvoidTable_Expire(&gs->avoidgoals, BotGoal_CurrentTime());
+    AvoidTable_Expire(&gs->avoidreach, BotGoal_CurrentTime());
+
+    const bot_itemsnapshot_t *snapshot = NULL;
+    int count = BotGoal_ItemSnapshot(&snapshot);
     float best_score = -FLT_MAX;
     const bot_levelitem_t *best_item = NULL;
     bot_goal_t best_goal = {0};
     float max_travel_time = (maxtime > 0.0f) ? (maxtime / BOT_GOAL_TRAVELTIME_SCALE) : 0.0f;
 
-    for (int i = 0; i < g_levelitem_count; ++i)
+    /* with a radius to search, only the bot's neighbourhood is considered */
+    int candidates[BOT_GOAL_MAX_LEVELITEMS];
+    int candidate_times[BOT_GOAL_MAX_LEVELITEMS];
+    bool nearby = (max_travel_time > 0.0f && start_area > 0 && aasworld.areas != NULL);
+    int numcandidates = count;
+    if (nearby)
     {
-        const bot_levelitem_t *item = &g_levelitems[i];
-        if (!item->valid)
-        {
-            continue;
-        }
+        numcandidates = BotGoal_NearbyItems(origin,
+                                            start_area,
+                                            travelflags,
+                                            (int)max_travel_time,
+                                            candidates,
+                                            candidate_times,
+                                            BOT_GOAL_MAX_LEVELITEMS);
+    }
 
-        if (ltg != NULL && item->goal.number == ltg->number)
+    for (int i = 0; i < numcandidates; ++i)
+    {
+        const bot_itemsnapshot_t *entry = &snapshot[nearby ? candidates[i] : i];
+        if (!entry->available)
         {
             continue;
         }
 
-        if (BotGoal_IsAvoided(gs, item->goal.number))
+        if (ltg != NULL && entry->number == ltg->number)
         {
             continue;
         }
 
-        if (item->next_respawn_time > now)
+        if (BotGoal_IsAvoided(gs, entry->number))
         {
             continue;
         }
 
         int travel_time = 0;
-        float score = BotGoal_LevelItemScore(gs, item, origin, start_area, inventory, travelflags, &travel_time);
+        float score;
+        if (nearby)
+        {
+            travel_time = candidate_times[i];
+            score = BotGoal_TimedItemScore(gs, entry->iteminfo, entry->base_weight, inventory, travel_time);
+        }
+        else
+        {
+            score = BotGoal_ItemScore(gs,
+                                      entry->iteminfo,
+                                      entry->base_weight,
+                                      entry->areanum,
+                                      origin,
+                                      start_area,
+                                      inventory,
+                                      travelflags,
+                                      &travel_time);
+        }
         if (score <= best_score)
         {
             continue;
@@ -929,8 +1819,8 @@ int BotChooseNBGItem(int handle,
         }
 
         best_score = score;
-        best_item = item;
-        best_goal = item->goal;
+        best_item = entry->item;
+        best_goal = entry->item->goal;
     }
 
     if (best_item == NULL)
@@ -963,7 +1853,7 @@ float BotGoal_EvaluateStackGoal(int handle,
     int start = start_area;
     if (start <= 0)
     {
-        start = BotGoal_PointAreaNum(origin);
+        start = AAS_PointAreaNumHinted(origin, gs->lastreachabilityarea);
     }
 
     int computed_travel = 0;
@@ -1049,13 +1939,13 @@ void BotDumpAvoidGoals(int handle)
     }
 
     float now = BotGoal_CurrentTime();
-    BotLib_Print(PRT_MESSAGE, "BotDumpAvoidGoals: state %d has %d entries\n", handle, gs->numavoidgoals);
-    for (int i = 0; i < gs->numavoidgoals; ++i)
+    BotLib_Print(PRT_MESSAGE, "BotDumpAvoidGoals: state %d has %d entries\n", handle, gs->avoidgoals.count);
+    for (int i = 0; i < gs->avoidgoals.count; ++i)
     {
-        float remaining = gs->avoidgoals[i].timeout - now;
+        float remaining = gs->avoidgoals.entries[i].expiry - now;
         BotLib_Print(PRT_MESSAGE,
                      "  goal %d remaining %.2f\n",
-                     gs->avoidgoals[i].number,
+                     gs->avoidgoals.entries[i].id,
                      remaining > 0.0f ? remaining : 0.0f);
     }
 }
@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 
+#include "botlib/common/l_avoid.h"
 #include "botlib/common/l_precomp.h"
 #include "botlib/common/l_log.h"
 #include "botlib/common/l_memory.h"
@@ -12,9 +13,7 @@
 extern "C" {
 #endif
 
-#define BOT_GOAL_MAX_AVOID       256
 #define BOT_GOAL_MAX_STACK       8
-#define BOT_GOAL_MAX_AVOIDREACH  32
 
 #define GFL_NONE    0
 #define GFL_ITEM    1
@@ -38,12 +37,6 @@ typedef struct bot_goal_s
 } bot_goal_t;
 #endif
 
-typedef struct bot_avoidgoal_s
-{
-    int number;
-    float timeout;
-} bot_avoidgoal_t;
-
 typedef struct bot_goalstate_s
 {
     bot_weight_config_t *itemweightconfig;
@@ -56,12 +49,9 @@ typedef struct bot_goalstate_s
     bot_goal_t goalstack[BOT_GOAL_MAX_STACK];
     int goalstacktop;
 
-    bot_avoidgoal_t avoidgoals[BOT_GOAL_MAX_AVOID];
-    int numavoidgoals;
-
-    int avoidreach[BOT_GOAL_MAX_AVOIDREACH];
-    float avoidreachtimes[BOT_GOAL_MAX_AVOIDREACH];
-    int numavoidreach;
+    /* sized by the max_avoidgoals and max_avoidreach libvars */
+    bot_avoidtable_t avoidgoals;
+    bot_avoidtable_t avoidreach;
 } bot_goalstate_t;
 
 typedef struct bot_levelitem_setup_s
@@ -73,6 +63,16 @@ typedef struct bot_levelitem_setup_s
     int flags;
 } bot_levelitem_setup_t;
 
+/* one bot taking part in a BotAssignLTGItems pass */
+typedef struct bot_goalassignment_s
+{
+    int handle;
+    vec3_t origin;
+    const int *inventory;
+    int travelflags;
+    int number; /* out: number of the item assigned, 0 when none */
+} bot_goalassignment_t;
+
 int BotAllocGoalState(int client);
 void BotFreeGoalState(int handle);
 void BotResetGoalState(int handle);
@@ -96,6 +96,7 @@ int BotGetTopGoal(int handle, bot_goal_t *goal);
 int BotGetSecondGoal(int handle, bot_goal_t *goal);
 
 int BotChooseLTGItem(int handle, const vec3_t origin, const int *inventory, int travelflags);
+int BotAssignLTGItems(bot_goalassignment_t *bots, int numbots);
 int BotChooseNBGItem(int handle,
                      const vec3_t origin,
                      const int *inventory,
@@ -119,9 +120,26 @@ void BotDumpGoalStack(int handle);
 int BotGoal_RegisterLevelItem(const bot_levelitem_setup_t *setup);
 void BotGoal_UnregisterLevelItem(int number);
 void BotGoal_MarkItemTaken(int number, float respawn_delay);
+int BotGoal_ItemsInArea(int areanum, int *numbers, int maxnumbers);
+int BotGoal_ItemsInCluster(int cluster, int *numbers, int maxnumbers);
+
+/*
+ * Item to item travel times, precomputed a few rows per frame for the
+ * canonical travel flag sets (TFL_DEFAULT, with and without
+ * TFL_ROCKETJUMP).  The table is only filled once one of the queries below
+ * has been called, which long-term goal selection does for bots standing in
+ * an item's area.  BotGoal_ItemTravelTime returns -1 while the pair is not
+ * available yet or for other flags, and 0 when the item cannot be reached,
+ * like AAS_AreaTravelTimeToGoalArea.
+ */
+void BotGoal_UpdateItemTravelMatrix(int maxrows);
+bool BotGoal_ItemTravelMatrixComplete(int travelflags);
+int BotGoal_ItemTravelTime(int from_number, int to_number, int travelflags);
 
 void BotGoal_SetCurrentTime(float now);
+void BotGoal_UpdateItemSnapshot(float now);
 float BotGoal_CurrentTime(void);
+int BotGoal_LastRouteQueries(void);
 
 const bot_goalstate_t *BotGoalStatePeek(int handle);
 
@@ -14,11 +14,21 @@
 #include "q2bridge/bridge.h"
 #include "q2bridge/bridge_config.h"
 
+#define BOT_MOVE_PREDICT_SPEED     300.0f
+#define BOT_MOVE_PREDICT_FRAMES    60
+#define BOT_MOVE_PREDICT_FRAMETIME 0.05f
+#define BOT_MOVE_HAZARD_AVOIDTIME  10.0f
+#define BOT_MOVE_HAZARD_REPLANS    (MAX_AVOIDREACH - 1)
+#define BOT_MOVE_STUCK_TIME        1.0f
+#define BOT_MOVE_STUCK_AVOIDTIME   5.0f
+#define BOT_MOVE_PROGRESS_DIST     16.0f
+#define BOT_MOVE_SIDESTEP_TIME     0.5f
+#define BOT_MOVE_STRAIGHT_AREAS    16
+
 static bot_movestate_t *g_botMoveStates[MAX_CLIENTS + 1];
 
 static float VectorNormalizeInline(vec3_t v);
 static float VectorNormalizeTo(const vec3_t src, vec3_t dst);
-static int BotMove_FindAreaForPoint(const vec3_t origin);
 static float BotMove_TravelTimeout(int traveltype);
 
 static const char *BotMove_DefaultGrappleModel(void)
@@ -228,6 +238,12 @@ static bool BotMove_DeveloperWarningsEnabled(void)
     return LibVarValue("developer", "0") != 0.0f;
 }
 
+/* predicting landings is off unless the server asks for it */
+static bool BotMove_HazardAvoidanceEnabled(void)
+{
+    return LibVarValue("bot_avoidhazards", "0") != 0.0f;
+}
+
 static const char *BotMove_MoverKindName(bot_mover_kind_t kind)
 {
     switch (kind)
@@ -336,7 +352,7 @@ static bool BotMove_FindSupportingMover(bot_movestate_t *ms, bot_move_mover_supp
     int area = ms->areanum;
     if (area <= 0)
     {
-        area = BotMove_FindAreaForPoint(ms->origin);
+        area = AAS_PointAreaNumHinted(ms->origin, ms->lastareanum);
         if (area <= 0)
         {
             return false;
@@ -368,28 +384,14 @@ static bool BotMove_FindSupportingMover(bot_movestate_t *ms, bot_move_mover_supp
             continue;
         }
 
-        const aas_entity_t *entity = &aasworld.entities[entnum];
-        if (!entity->inuse || entity->solid != SOLID_BSP || entity->modelindex <= 0)
-        {
-            continue;
-        }
-
-        int modelnum = entity->modelindex - 1;
-        if (modelnum < 0)
+        const bot_mover_state_t *mover = BotMove_MoverSnapshotForEntity(entnum);
+        if (mover == NULL || mover->catalogue == NULL)
         {
             continue;
         }
 
-        const bot_mover_catalogue_entry_t *catalogue = BotMove_MoverCatalogueFindByModel(modelnum);
-        if (catalogue == NULL)
-        {
-            continue;
-        }
-
-        vec3_t absmins;
-        vec3_t absmaxs;
-        VectorAdd(entity->origin, entity->mins, absmins);
-        VectorAdd(entity->origin, entity->maxs, absmaxs);
+        const float *absmins = mover->absmins;
+        const float *absmaxs = mover->absmaxs;
 
         if (ms->origin[0] + lateralTolerance < absmins[0] ||
             ms->origin[0] - lateralTolerance > absmaxs[0] ||
@@ -409,10 +411,10 @@ static bool BotMove_FindSupportingMover(bot_movestate_t *ms, bot_move_mover_supp
             continue;
         }
 
-        support->entity = entity;
+        support->entity = &aasworld.entities[entnum];
         support->entnum = entnum;
-        support->modelnum = modelnum;
-        support->catalogue = catalogue;
+        support->modelnum = mover->modelindex - 1;
+        support->catalogue = mover->catalogue;
         return true;
     }
 
@@ -519,34 +521,6 @@ static float VectorNormalizeTo(const vec3_t src, vec3_t dst)
     return VectorNormalizeInline(dst);
 }
 
-static int BotMove_FindAreaForPoint(const vec3_t origin)
-{
-    if (!aasworld.loaded || aasworld.areas == NULL || aasworld.numAreas <= 0)
-    {
-        return 0;
-    }
-
-    for (int areanum = 1; areanum <= aasworld.numAreas; ++areanum)
-    {
-        const aas_area_t *area = &aasworld.areas[areanum];
-        if (origin[0] < area->mins[0] || origin[0] > area->maxs[0])
-        {
-            continue;
-        }
-        if (origin[1] < area->mins[1] || origin[1] > area->maxs[1])
-        {
-            continue;
-        }
-        if (origin[2] < area->mins[2] || origin[2] > area->maxs[2])
-        {
-            continue;
-        }
-        return areanum;
-    }
-
-    return 0;
-}
-
 static int BotMove_TravelFlagsForType(int traveltype)
 {
     if (traveltype < 0 || traveltype >= MAX_TRAVELTYPES)
@@ -696,26 +670,402 @@ static bool BotMove_ShouldAvoidReach(const bot_movestate_t *ms, int reachnum)
     return false;
 }
 
-static int BotMove_ReconstructFirstReach(const int *parent_area,
-                                         const int *parent_reach,
-                                         int start_area,
-                                         int goal_area)
+/* the walk reachability from areanum into nextarea, 0 if they are not walk-connected */
+static int BotMove_WalkReachBetween(int areanum, int nextarea)
 {
-    if (parent_area == NULL || parent_reach == NULL)
+    if (aasworld.areasettings == NULL || areanum <= 0 || areanum >= aasworld.numAreaSettings)
     {
         return 0;
     }
 
-    int area = goal_area;
-    int reachnum = 0;
+    const aas_areasettings_t *settings = &aasworld.areasettings[areanum];
+    for (int i = 0; i < settings->numreachableareas; ++i)
+    {
+        int reachnum = settings->firstreachablearea + i;
+        if (reachnum <= 0)
+        {
+            continue;
+        }
+        if (reachnum >= aasworld.numReachability)
+        {
+            break;
+        }
+
+        const aas_reachability_t *reach = &aasworld.reachability[reachnum];
+        if (reach->areanum == nextarea && (reach->traveltype & TRAVELTYPE_MASK) == TRAVEL_WALK)
+        {
+            return reachnum;
+        }
+    }
 
-    while (area != 0 && area != start_area)
+    return 0;
+}
+
+/*
+ * Walks the AAS tree from the bot to the goal.  The goal can be walked to
+ * directly when every area on the way is entered through a walk
+ * reachability the bot is not avoiding, and each area is entered where the
+ * previous one ends, i.e. the segment never crosses solid space.
+ */
+static bool BotMove_GoalInStraightWalk(const bot_movestate_t *ms, const bot_goal_t *goal)
+{
+    if (goal->areanum <= 0 || aasworld.areas == NULL)
     {
-        reachnum = parent_reach[area];
-        area = parent_area[area];
+        return false;
     }
 
-    return reachnum;
+    int areas[BOT_MOVE_STRAIGHT_AREAS];
+    vec3_t points[BOT_MOVE_STRAIGHT_AREAS];
+    int numareas = AAS_TraceAreas(ms->origin, goal->origin, areas, points, BOT_MOVE_STRAIGHT_AREAS);
+    if (numareas <= 1 || numareas >= BOT_MOVE_STRAIGHT_AREAS || areas[0] != ms->areanum ||
+        areas[numareas - 1] != goal->areanum)
+    {
+        return false;
+    }
+
+    for (int i = 1; i < numareas; ++i)
+    {
+        int reachnum = BotMove_WalkReachBetween(areas[i - 1], areas[i]);
+        if (reachnum <= 0 || BotMove_ShouldAvoidReach(ms, reachnum))
+        {
+            return false;
+        }
+
+        const aas_area_t *previous = &aasworld.areas[areas[i - 1]];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (points[i][axis] < previous->mins[axis] - 1.0f || points[i][axis] > previous->maxs[axis] + 1.0f)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void BotMove_AvoidReach(bot_movestate_t *ms, int reachnum, float duration)
+{
+    int slot = 0;
+    for (int i = 0; i < MAX_AVOIDREACH; ++i)
+    {
+        if (ms->avoidreach[i] == reachnum || ms->avoidreach[i] <= 0)
+        {
+            slot = i;
+            break;
+        }
+        if (ms->avoidreachtimes[i] < ms->avoidreachtimes[slot])
+        {
+            slot = i;
+        }
+    }
+
+    if (ms->avoidreach[slot] != reachnum)
+    {
+        ms->avoidreachtries[slot] = 0;
+    }
+    ms->avoidreach[slot] = reachnum;
+    ms->avoidreachtimes[slot] = aasworld.time + duration;
+    ms->avoidreachtries[slot] += 1;
+}
+
+/*
+ * Soft penalties steer bots away from reachabilities or areas that are
+ * temporarily unattractive, such as a crowded teleporter, without touching
+ * the shared routing caches.  They add travel time when ranking the ways
+ * out of an area and expire on their own.
+ */
+static bot_move_penalty_t g_botMovePenalties[MAX_MOVEPENALTIES];
+static int g_botMoveNumPenalties;
+
+static void BotMove_AddPenalty(int reachnum, int areanum, int cost, float duration)
+{
+    if (cost <= 0 || duration <= 0.0f)
+    {
+        return;
+    }
+
+    float now = aasworld.time;
+    int slot = -1;
+    for (int i = 0; i < g_botMoveNumPenalties; ++i)
+    {
+        bot_move_penalty_t *penalty = &g_botMovePenalties[i];
+        if (penalty->reachnum == reachnum && penalty->areanum == areanum)
+        {
+            slot = i;
+            break;
+        }
+        if (penalty->endtime <= now)
+        {
+            slot = i;
+        }
+    }
+
+    if (slot < 0)
+    {
+        if (g_botMoveNumPenalties < MAX_MOVEPENALTIES)
+        {
+            slot = g_botMoveNumPenalties++;
+        }
+        else
+        {
+            /* full: replace the penalty that would expire first */
+            slot = 0;
+            for (int i = 1; i < MAX_MOVEPENALTIES; ++i)
+            {
+                if (g_botMovePenalties[i].endtime < g_botMovePenalties[slot].endtime)
+                {
+                    slot = i;
+                }
+            }
+        }
+    }
+
+    bot_move_penalty_t *penalty = &g_botMovePenalties[slot];
+    penalty->reachnum = reachnum;
+    penalty->areanum = areanum;
+    penalty->cost = cost;
+    penalty->endtime = now + duration;
+}
+
+void BotMove_AddReachPenalty(int reachnum, int cost, float duration)
+{
+    if (reachnum <= 0 || reachnum >= aasworld.numReachability)
+    {
+        return;
+    }
+
+    BotMove_AddPenalty(reachnum, 0, cost, duration);
+}
+
+void BotMove_AddAreaPenalty(int areanum, int cost, float duration)
+{
+    if (areanum <= 0 || areanum > aasworld.numAreas)
+    {
+        return;
+    }
+
+    BotMove_AddPenalty(0, areanum, cost, duration);
+}
+
+void BotMove_ClearPenalties(void)
+{
+    memset(g_botMovePenalties, 0, sizeof(g_botMovePenalties));
+    g_botMoveNumPenalties = 0;
+}
+
+/* extra travel time for taking reachnum into areanum */
+static int BotMove_ReachPenalty(int reachnum, int areanum)
+{
+    float now = aasworld.time;
+    int cost = 0;
+    for (int i = 0; i < g_botMoveNumPenalties; ++i)
+    {
+        const bot_move_penalty_t *penalty = &g_botMovePenalties[i];
+        if (penalty->endtime <= now)
+        {
+            continue;
+        }
+        if ((penalty->reachnum > 0 && penalty->reachnum == reachnum) ||
+            (penalty->areanum > 0 && penalty->areanum == areanum))
+        {
+            cost += penalty->cost;
+        }
+    }
+
+    return cost;
+}
+
+/*
+ * Runs jumps and drops through the local movement predictor from the
+ * reachability start, at full running speed towards its end.  Reports
+ * whether the bot would come down in lava or slime.
+ */
+static bool BotMove_ReachEndsInHazard(const bot_movestate_t *ms, const aas_reachability_t *reach)
+{
+    int traveltype = reach->traveltype & TRAVELTYPE_MASK;
+    if (traveltype != TRAVEL_JUMP && traveltype != TRAVEL_BARRIERJUMP && traveltype != TRAVEL_WALKOFFLEDGE)
+    {
+        return false;
+    }
+
+    if (!AAS_BSPCollisionLoaded())
+    {
+        return false;
+    }
+
+    vec3_t mins = {-16.0f, -16.0f, -24.0f};
+    vec3_t maxs = {16.0f, 16.0f, 32.0f};
+    vec3_t start;
+    VectorCopy(reach->start, start);
+    bsp_trace_t trace = AAS_BSPTrace(start, mins, maxs, start, ms->entitynum, MASK_PLAYERSOLID);
+    if (trace.startsolid)
+    {
+        /* the start lies on the floor rather than at the player origin */
+        start[2] -= mins[2];
+    }
+
+    vec3_t dir;
+    VectorSubtract(reach->end, start, dir);
+    dir[2] = 0.0f;
+    if (VectorNormalizeInline(dir) <= 0.0f)
+    {
+        return false;
+    }
+
+    vec3_t velocity;
+    vec3_t cmdmove;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        velocity[axis] = dir[axis] * BOT_MOVE_PREDICT_SPEED;
+    }
+    VectorCopy(velocity, cmdmove);
+    if (traveltype != TRAVEL_WALKOFFLEDGE)
+    {
+        cmdmove[2] = BOT_MOVE_PREDICT_SPEED;
+    }
+
+    aas_clientmove_t move;
+    AAS_PredictClientMovement(&move,
+                              ms->entitynum,
+                              start,
+                              mins,
+                              maxs,
+                              true,
+                              velocity,
+                              cmdmove,
+                              BOT_MOVE_PREDICT_FRAMES,
+                              BOT_MOVE_PREDICT_FRAMES,
+                              BOT_MOVE_PREDICT_FRAMETIME,
+                              SE_HITGROUND | SE_ENTERLAVA | SE_ENTERSLIME,
+                              0);
+
+    return (move.events & (SE_ENTERLAVA | SE_ENTERSLIME)) != 0;
+}
+
+static void BotMove_ClearCorridor(bot_movestate_t *ms)
+{
+    ms->corridorlength = 0;
+    ms->corridorindex = 0;
+    ms->corridorgoalarea = 0;
+    ms->corridortravelflags = 0;
+}
+
+/*
+ * Stores the route found by the breadth-first search as the move state's
+ * corridor.  Routes longer than MAX_CORRIDOR keep their first legs; the
+ * remainder is planned again once the bot runs off the end.
+ */
+static int BotMove_StoreCorridor(bot_movestate_t *ms,
+                                 const int *parent_area,
+                                 const int *parent_reach,
+                                 int goal_area,
+                                 int travelflags)
+{
+    int length = 0;
+    for (int area = goal_area; parent_area[area] != 0; area = parent_area[area])
+    {
+        ++length;
+    }
+
+    int stored = (length < MAX_CORRIDOR) ? length : MAX_CORRIDOR;
+    int position = length;
+    for (int area = goal_area; parent_area[area] != 0; area = parent_area[area])
+    {
+        --position;
+        if (position < stored)
+        {
+            ms->corridor[position] = parent_reach[area];
+            ms->corridorareas[position] = parent_area[area];
+        }
+    }
+
+    ms->corridorlength = stored;
+    ms->corridorindex = 0;
+    ms->corridorgoalarea = goal_area;
+    ms->corridortravelflags = travelflags;
+    ms->corridorepoch = aasworld.reachabilityEpoch;
+
+    return (stored > 0) ? ms->corridor[0] : 0;
+}
+
+/*
+ * While the goal, travel flags and reachability epoch are unchanged and the
+ * bot is still on the leg it was following, or has just reached the start of
+ * the next one, the next reachability is read straight off the corridor.
+ * Mover updates only bump the route epoch: the corridor holds reachability
+ * numbers, which stay valid until the links are rebuilt.
+ * Returns 0 when a full re-plan is required.
+ */
+static int BotMove_FollowCorridor(bot_movestate_t *ms, int goal_area, int travelflags)
+{
+    if (ms->corridorlength <= 0 ||
+        ms->corridorgoalarea != goal_area ||
+        ms->corridortravelflags != travelflags ||
+        ms->corridorepoch != aasworld.reachabilityEpoch)
+    {
+        return 0;
+    }
+
+    int last = ms->corridorindex + 1;
+    if (last >= ms->corridorlength)
+    {
+        last = ms->corridorlength - 1;
+    }
+
+    for (int index = ms->corridorindex; index <= last; ++index)
+    {
+        if (ms->corridorareas[index] != ms->areanum)
+        {
+            continue;
+        }
+
+        int reachnum = ms->corridor[index];
+        if (BotMove_ShouldAvoidReach(ms, reachnum))
+        {
+            return 0;
+        }
+
+        ms->corridorindex = index;
+        return reachnum;
+    }
+
+    return 0;
+}
+
+/*
+ * The route search works in per-move-state buffers sized to the loaded map,
+ * so planning never allocates once a bot is set up.  The buffers are only
+ * rebuilt when the number of areas changes, which happens on map load.
+ */
+static bool BotMove_ResizeScratch(bot_movestate_t *ms)
+{
+    int areaCount = aasworld.numAreaSettings;
+    if (ms->scratch != NULL && ms->scratchareas == areaCount)
+    {
+        return true;
+    }
+
+    if (ms->scratch != NULL)
+    {
+        FreeMemory(ms->scratch);
+        ms->scratch = NULL;
+        ms->scratchareas = 0;
+    }
+
+    if (areaCount <= 0)
+    {
+        return false;
+    }
+
+    ms->scratch = (int *)GetMemory((size_t)areaCount * 4U * sizeof(int));
+    if (ms->scratch == NULL)
+    {
+        return false;
+    }
+
+    ms->scratchareas = areaCount;
+    return true;
 }
 
 static int BotGetReachabilityToGoal(bot_movestate_t *ms,
@@ -753,20 +1103,25 @@ static int BotGetReachabilityToGoal(bot_movestate_t *ms,
         return 0;
     }
 
-    int areaCount = aasworld.numAreaSettings;
-    int *queue = (int *)malloc((size_t)areaCount * sizeof(int));
-    int *visited = (int *)calloc((size_t)areaCount, sizeof(int));
-    int *parent_area = (int *)calloc((size_t)areaCount, sizeof(int));
-    int *parent_reach = (int *)calloc((size_t)areaCount, sizeof(int));
-    if (queue == NULL || visited == NULL || parent_area == NULL || parent_reach == NULL)
-    {
-        free(queue);
-        free(visited);
-        free(parent_area);
-        free(parent_reach);
+    int reachnum = BotMove_FollowCorridor(ms, goalArea, travelflags);
+    if (reachnum > 0)
+    {
+        return BotMove_LoadReachability(reachnum, out) ? reachnum : 0;
+    }
+
+    if (!BotMove_ResizeScratch(ms))
+    {
         return 0;
     }
 
+    /* only visited is read before being written, the parents follow it */
+    int areaCount = ms->scratchareas;
+    int *queue = ms->scratch;
+    int *visited = queue + areaCount;
+    int *parent_area = visited + areaCount;
+    int *parent_reach = parent_area + areaCount;
+    memset(visited, 0, (size_t)areaCount * sizeof(int));
+
     int head = 0;
     int tail = 0;
 
@@ -829,16 +1184,14 @@ static int BotGetReachabilityToGoal(bot_movestate_t *ms,
         }
     }
 
-    int reachnum = 0;
     if (visited[goalArea])
     {
-        reachnum = BotMove_ReconstructFirstReach(parent_area, parent_reach, ms->areanum, goalArea);
+        reachnum = BotMove_StoreCorridor(ms, parent_area, parent_reach, goalArea, travelflags);
+    }
+    else
+    {
+        BotMove_ClearCorridor(ms);
     }
-
-    free(queue);
-    free(visited);
-    free(parent_area);
-    free(parent_reach);
 
     if (reachnum <= 0)
     {
@@ -1039,30 +1392,19 @@ static const bot_mover_catalogue_entry_t *BotMove_FindMoverEntry(int entnum, int
         return NULL;
     }
 
-    const aas_entity_t *entity = &aasworld.entities[entnum];
-    if (entity == NULL || !entity->inuse || entity->solid != SOLID_BSP)
-    {
-        return NULL;
-    }
-
-    int modelnum = AAS_ModelNumForEntity(entnum);
-    if (modelnum <= 0)
-    {
-        return NULL;
-    }
-
-    const bot_mover_catalogue_entry_t *entry = BotMove_MoverCatalogueFindByModel(modelnum);
-    if (entry == NULL)
+    /* the snapshot already resolved the catalogue through modelindex - 1 */
+    const bot_mover_state_t *mover = BotMove_MoverSnapshotForEntity(entnum);
+    if (mover == NULL || mover->catalogue == NULL)
     {
         return NULL;
     }
 
     if (outModelnum != NULL)
     {
-        *outModelnum = modelnum;
+        *outModelnum = mover->modelindex - 1;
     }
 
-    return entry;
+    return mover->catalogue;
 }
 
 static void BotMove_HandleMoverLanding(bot_movestate_t *ms,
@@ -1257,6 +1599,325 @@ static void BotMove_DispatchTravel(bot_movestate_t *ms,
     BotMove_CopyMoveResult(result, &temp);
 }
 
+/*
+ * Local stuck recovery.  A bot that stops making progress on a reachability
+ * first tries another reachability out of the same area, then a short
+ * sidestep, and only then avoids the reachability and re-plans the whole
+ * route.  A tier is counted as having resolved the stuck state once the bot
+ * leaves the area it got stuck in.
+ */
+static bot_move_recovery_stats_t g_botMoveRecoveryStats;
+
+static void BotMove_ClearRecovery(bot_movestate_t *ms)
+{
+    ms->recoverytier = BOT_MOVE_RECOVERY_NONE;
+    ms->recoveryarea = 0;
+    ms->recoveryreach = 0;
+    ms->sidesteptime = 0.0f;
+    VectorClear(ms->sidestepdir);
+    VectorCopy(ms->origin, ms->progressorigin);
+    ms->progresstime = aasworld.time;
+}
+
+static void BotMove_UpdateRecovery(bot_movestate_t *ms)
+{
+    if (ms->recoverytier != BOT_MOVE_RECOVERY_NONE && ms->areanum != ms->recoveryarea)
+    {
+        g_botMoveRecoveryStats.resolved[ms->recoverytier] += 1;
+        BotMove_ClearRecovery(ms);
+        return;
+    }
+
+    vec3_t delta;
+    VectorSubtract(ms->origin, ms->progressorigin, delta);
+    if (ms->progresstime <= 0.0f ||
+        DotProduct(delta, delta) > BOT_MOVE_PROGRESS_DIST * BOT_MOVE_PROGRESS_DIST)
+    {
+        VectorCopy(ms->origin, ms->progressorigin);
+        ms->progresstime = aasworld.time;
+    }
+}
+
+static bool BotMove_IsStuck(bot_movestate_t *ms, int reachnum, const aas_reachability_t *reach)
+{
+    if (reachnum != ms->lastreachnum)
+    {
+        VectorCopy(ms->origin, ms->progressorigin);
+        ms->progresstime = aasworld.time;
+        return false;
+    }
+
+    if (aasworld.time > ms->reachability_time)
+    {
+        return true;
+    }
+
+    /* bots wait in place for movers, only the timeout applies there */
+    int traveltype = reach->traveltype & TRAVELTYPE_MASK;
+    if (traveltype == TRAVEL_ELEVATOR || traveltype == TRAVEL_FUNCBOB)
+    {
+        return false;
+    }
+
+    return aasworld.time - ms->progresstime > BOT_MOVE_STUCK_TIME;
+}
+
+/*
+ * Penalties on the rest of the stored corridor once a route rejoins it at
+ * area.  Zero when the corridor leads elsewhere or area is not on it.
+ */
+static int BotMove_CorridorPenalty(const bot_movestate_t *ms, int goalarea, int travelflags, int area)
+{
+    if (ms->corridorlength <= 0 || ms->corridorgoalarea != goalarea || ms->corridortravelflags != travelflags)
+    {
+        return 0;
+    }
+
+    int index = ms->corridorindex;
+    while (index < ms->corridorlength && ms->corridorareas[index] != area)
+    {
+        ++index;
+    }
+
+    int cost = 0;
+    for (; index < ms->corridorlength; ++index)
+    {
+        int reachnum = ms->corridor[index];
+        if (reachnum > 0 && reachnum < aasworld.numReachability)
+        {
+            cost += BotMove_ReachPenalty(reachnum, aasworld.reachability[reachnum].areanum);
+        }
+    }
+
+    return cost;
+}
+
+/*
+ * Cost of leaving the current area through a reachability: its own travel
+ * time, the cached route time from where it lands to the goal area, and any
+ * soft penalty on the reachability, its landing area and the part of the
+ * stored corridor the route rejoins.  Fails when the landing area has no
+ * known route to the goal.
+ */
+static bool BotMove_ReachCostToGoal(const bot_movestate_t *ms,
+                                    int reachnum,
+                                    const bot_goal_t *goal,
+                                    int travelflags,
+                                    int *cost)
+{
+    if (reachnum <= 0 || reachnum >= aasworld.numReachability)
+    {
+        return false;
+    }
+
+    aas_reachability_t *reach = &aasworld.reachability[reachnum];
+    if (!BotMove_TravelAllowed(reach->traveltype & TRAVELTYPE_MASK, travelflags))
+    {
+        return false;
+    }
+
+    int area = reach->areanum;
+    if (area <= 0 || area > aasworld.numAreas || area == ms->areanum)
+    {
+        return false;
+    }
+
+    int time = AAS_AreaTravelTimeToGoalArea(area, reach->end, goal->areanum, travelflags);
+    if (time <= 0 && area != goal->areanum)
+    {
+        return false;
+    }
+
+    *cost = time + reach->traveltime + BotMove_ReachPenalty(reachnum, area) +
+            BotMove_CorridorPenalty(ms, goal->areanum, travelflags, area);
+    return true;
+}
+
+/*
+ * Picks the cheapest reachability out of the current area other than
+ * excludereach.
+ */
+static int BotMove_AlternativeReach(const bot_movestate_t *ms,
+                                    const bot_goal_t *goal,
+                                    int travelflags,
+                                    int excludereach,
+                                    int *bestCost)
+{
+    if (aasworld.areasettings == NULL || ms->areanum <= 0 || ms->areanum >= aasworld.numAreaSettings)
+    {
+        return 0;
+    }
+
+    const aas_areasettings_t *settings = &aasworld.areasettings[ms->areanum];
+    int best = 0;
+    int bestTime = 0;
+    for (int offset = 0; offset < settings->numreachableareas; ++offset)
+    {
+        int reachnum = settings->firstreachablearea + offset;
+        if (reachnum == excludereach || BotMove_ShouldAvoidReach(ms, reachnum))
+        {
+            continue;
+        }
+
+        int time = 0;
+        if (!BotMove_ReachCostToGoal(ms, reachnum, goal, travelflags, &time))
+        {
+            continue;
+        }
+
+        if (best == 0 || time < bestTime)
+        {
+            best = reachnum;
+            bestTime = time;
+        }
+    }
+
+    if (bestCost != NULL)
+    {
+        *bestCost = bestTime;
+    }
+    return best;
+}
+
+/*
+ * Route searches and corridors ignore penalties, so when the planned
+ * reachability or anything further along the corridor is penalised compare
+ * it against the other ways out of the area and take a cheaper one if there
+ * is one.
+ */
+static int BotMove_RerankPenalisedReach(const bot_movestate_t *ms,
+                                        const bot_goal_t *goal,
+                                        int travelflags,
+                                        int reachnum,
+                                        aas_reachability_t *reach)
+{
+    int penalty = BotMove_ReachPenalty(reachnum, reach->areanum) +
+                  BotMove_CorridorPenalty(ms, goal->areanum, travelflags, reach->areanum);
+    if (penalty <= 0)
+    {
+        return reachnum;
+    }
+
+    int plannedCost = 0;
+    if (!BotMove_ReachCostToGoal(ms, reachnum, goal, travelflags, &plannedCost))
+    {
+        return reachnum;
+    }
+
+    int alternativeCost = 0;
+    int alternative = BotMove_AlternativeReach(ms, goal, travelflags, reachnum, &alternativeCost);
+    if (alternative <= 0 || alternativeCost >= plannedCost)
+    {
+        return reachnum;
+    }
+
+    if (!BotMove_LoadReachability(alternative, reach))
+    {
+        return reachnum;
+    }
+    return alternative;
+}
+
+static void BotMove_StartSidestep(bot_movestate_t *ms, const aas_reachability_t *reach)
+{
+    vec3_t forward;
+    VectorSubtract(reach->start, ms->origin, forward);
+    forward[2] = 0.0f;
+    if (VectorNormalizeInline(forward) <= 0.0f)
+    {
+        VectorSubtract(reach->end, reach->start, forward);
+        forward[2] = 0.0f;
+        VectorNormalizeInline(forward);
+    }
+
+    /* alternate sides so repeated attempts do not push into the same wall */
+    float side = (ms->sidesteps & 1) ? -1.0f : 1.0f;
+    ms->sidesteps += 1;
+    VectorSet(ms->sidestepdir, -forward[1] * side, forward[0] * side, 0.0f);
+    ms->sidesteptime = aasworld.time + BOT_MOVE_SIDESTEP_TIME;
+}
+
+/*
+ * Escalates to the next recovery tier.  Returns the reachability to follow,
+ * or 0 when the result has already been filled in.
+ */
+static int BotMove_RecoverFromStuck(bot_movestate_t *ms,
+                                    const bot_goal_t *goal,
+                                    int travelflags,
+                                    int stuckreach,
+                                    aas_reachability_t *reach,
+                                    bot_moveresult_t *result)
+{
+    int tier = BOT_MOVE_RECOVERY_ALTREACH;
+    if (ms->recoverytier != BOT_MOVE_RECOVERY_NONE && ms->recoveryarea == ms->areanum)
+    {
+        tier = ms->recoverytier + 1;
+        if (tier > BOT_MOVE_RECOVERY_REROUTE)
+        {
+            tier = BOT_MOVE_RECOVERY_REROUTE;
+        }
+    }
+
+    ms->recoveryarea = ms->areanum;
+    ms->recoveryreach = 0;
+    VectorCopy(ms->origin, ms->progressorigin);
+    ms->progresstime = aasworld.time;
+    ms->reachability_time = aasworld.time + BotMove_TravelTimeout(reach->traveltype & TRAVELTYPE_MASK);
+
+    if (tier == BOT_MOVE_RECOVERY_ALTREACH)
+    {
+        int alternative = BotMove_AlternativeReach(ms, goal, travelflags, stuckreach, NULL);
+        if (alternative > 0 && BotMove_LoadReachability(alternative, reach))
+        {
+            g_botMoveRecoveryStats.attempts[tier] += 1;
+            ms->recoverytier = tier;
+            ms->recoveryreach = alternative;
+            return alternative;
+        }
+        tier = BOT_MOVE_RECOVERY_SIDESTEP;
+    }
+
+    if (tier == BOT_MOVE_RECOVERY_SIDESTEP)
+    {
+        BotMove_StartSidestep(ms, reach);
+        g_botMoveRecoveryStats.attempts[tier] += 1;
+        ms->recoverytier = tier;
+        BotMove_PrepareResult(result, ms->sidestepdir, TRAVEL_WALK, false);
+        return 0;
+    }
+
+    g_botMoveRecoveryStats.attempts[tier] += 1;
+    ms->recoverytier = tier;
+    BotMove_AvoidReach(ms, stuckreach, BOT_MOVE_STUCK_AVOIDTIME);
+    BotMove_ClearCorridor(ms);
+
+    int resultFlags = 0;
+    int reachnum = BotGetReachabilityToGoal(ms, goal, travelflags, reach, &resultFlags);
+    if (reachnum <= 0)
+    {
+        BotMove_DirectToGoal(ms, goal, result);
+        return 0;
+    }
+
+    result->flags |= resultFlags;
+    return reachnum;
+}
+
+void BotMove_GetRecoveryStats(bot_move_recovery_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+
+    *stats = g_botMoveRecoveryStats;
+}
+
+void BotMove_ResetRecoveryStats(void)
+{
+    memset(&g_botMoveRecoveryStats, 0, sizeof(g_botMoveRecoveryStats));
+}
+
 int BotAllocMoveState(void)
 {
     for (int handle = 1; handle <= MAX_CLIENTS; ++handle)
@@ -1264,6 +1925,10 @@ int BotAllocMoveState(void)
         if (g_botMoveStates[handle] == NULL)
         {
             g_botMoveStates[handle] = GetClearedMemory(sizeof(bot_movestate_t));
+            if (g_botMoveStates[handle] != NULL && aasworld.loaded)
+            {
+                BotMove_ResizeScratch(g_botMoveStates[handle]);
+            }
             return handle;
         }
     }
@@ -1290,6 +1955,10 @@ void BotFreeMoveState(int handle)
         return;
     }
 
+    if (ms->scratch != NULL)
+    {
+        FreeMemory(ms->scratch);
+    }
     FreeMemory(ms);
     g_botMoveStates[handle] = NULL;
 }
@@ -1312,7 +1981,23 @@ void BotResetMoveState(int movestate)
         return;
     }
 
+    int *scratch = ms->scratch;
+    int scratchareas = ms->scratchareas;
     memset(ms, 0, sizeof(*ms));
+    ms->scratch = scratch;
+    ms->scratchareas = scratchareas;
+}
+
+/* sizes the route search buffers of every move state for the loaded map */
+void BotMove_SetupScratch(void)
+{
+    for (int handle = 1; handle <= MAX_CLIENTS; ++handle)
+    {
+        if (g_botMoveStates[handle] != NULL)
+        {
+            BotMove_ResizeScratch(g_botMoveStates[handle]);
+        }
+    }
 }
 
 void BotInitMoveState(int handle, const bot_initmove_t *initmove)
@@ -1361,7 +2046,7 @@ void BotMoveClassifyEnvironment(bot_movestate_t *ms)
     }
 
     ms->lastareanum = ms->areanum;
-    int areanum = BotMove_FindAreaForPoint(ms->origin);
+    int areanum = AAS_PointAreaNumHinted(ms->origin, ms->areanum);
     if (areanum > 0)
     {
         ms->areanum = areanum;
@@ -1385,23 +2070,11 @@ void BotMoveClassifyEnvironment(bot_movestate_t *ms)
     }
 }
 
-void BotMoveToGoal(bot_moveresult_t *result,
-                   int movestate,
-                   const bot_goal_t *goal,
-                   int travelflags)
+static void BotMove_MoveToGoal(bot_moveresult_t *result,
+                               bot_movestate_t *ms,
+                               const bot_goal_t *goal,
+                               int travelflags)
 {
-    if (result == NULL)
-    {
-        return;
-    }
-
-    bot_movestate_t *ms = BotMoveStateFromHandle(movestate);
-    if (ms == NULL)
-    {
-        result->failure = 1;
-        return;
-    }
-
     if (goal == NULL || goal->areanum <= 0)
     {
         result->failure = 1;
@@ -1410,6 +2083,12 @@ void BotMoveToGoal(bot_moveresult_t *result,
     }
 
     BotMove_RefreshAvoidReach(ms);
+    BotMove_UpdateRecovery(ms);
+    if (goal->areanum != ms->lastgoalareanum)
+    {
+        /* a sidestep or alternative reach was chosen for the old route */
+        BotMove_ClearRecovery(ms);
+    }
 
     ms->moveflags &= ~(MFL_SWIMMING | MFL_AGAINSTLADDER);
 
@@ -1421,15 +2100,37 @@ void BotMoveToGoal(bot_moveresult_t *result,
         return;
     }
 
-    if (ms->areanum == goal->areanum)
+    if (ms->areanum == goal->areanum || BotMove_GoalInStraightWalk(ms, goal))
     {
         BotMove_DirectToGoal(ms, goal, result);
         return;
     }
 
+    if (ms->sidesteptime > aasworld.time)
+    {
+        BotMove_PrepareResult(result, ms->sidestepdir, TRAVEL_WALK, false);
+        ms->lastgoalareanum = goal->areanum;
+        VectorCopy(ms->origin, ms->lastorigin);
+        return;
+    }
+
     aas_reachability_t reach;
     int resultFlags = 0;
-    int reachIndex = BotGetReachabilityToGoal(ms, goal, travelflags, &reach, &resultFlags);
+    int reachIndex = 0;
+    if (ms->recoveryreach > 0 && ms->recoveryarea == ms->areanum &&
+        !BotMove_ShouldAvoidReach(ms, ms->recoveryreach) &&
+        BotMove_LoadReachability(ms->recoveryreach, &reach))
+    {
+        reachIndex = ms->recoveryreach;
+    }
+    else
+    {
+        reachIndex = BotGetReachabilityToGoal(ms, goal, travelflags, &reach, &resultFlags);
+        if (reachIndex > 0)
+        {
+            reachIndex = BotMove_RerankPenalisedReach(ms, goal, travelflags, reachIndex, &reach);
+        }
+    }
     if (reachIndex <= 0)
     {
         BotMove_DirectToGoal(ms, goal, result);
@@ -1439,6 +2140,38 @@ void BotMoveToGoal(bot_moveresult_t *result,
         return;
     }
 
+    if (reachIndex != ms->lastreachnum && BotMove_HazardAvoidanceEnabled())
+    {
+        /* the replacement may come down in lava as well; every rejected reach keeps its avoid slot */
+        int replans = 0;
+        while (reachIndex > 0 && BotMove_ReachEndsInHazard(ms, &reach))
+        {
+            BotMove_AvoidReach(ms, reachIndex, BOT_MOVE_HAZARD_AVOIDTIME);
+            reachIndex = (++replans <= BOT_MOVE_HAZARD_REPLANS)
+                             ? BotGetReachabilityToGoal(ms, goal, travelflags, &reach, &resultFlags)
+                             : 0;
+        }
+        if (reachIndex <= 0)
+        {
+            BotMove_DirectToGoal(ms, goal, result);
+            ms->lastreachnum = 0;
+            ms->lastgoalareanum = goal->areanum;
+            VectorCopy(ms->origin, ms->lastorigin);
+            return;
+        }
+    }
+
+    if (BotMove_IsStuck(ms, reachIndex, &reach))
+    {
+        reachIndex = BotMove_RecoverFromStuck(ms, goal, travelflags, reachIndex, &reach, result);
+        if (reachIndex <= 0)
+        {
+            ms->lastgoalareanum = goal->areanum;
+            VectorCopy(ms->origin, ms->lastorigin);
+            return;
+        }
+    }
+
     BotMove_DispatchTravel(ms, &reach, result);
 
     int traveltype = reach.traveltype & TRAVELTYPE_MASK;
@@ -1461,7 +2194,12 @@ void BotMoveToGoal(bot_moveresult_t *result,
         return;
     }
 
-    ms->reachability_time = finalReachabilityTime;
+    /* the timeout runs from when the bot started on the reachability */
+    if (finalReachIndex != ms->lastreachnum ||
+        (result->flags & (MOVERESULT_ONTOPOF_ELEVATOR | MOVERESULT_ONTOPOF_FUNCBOB)))
+    {
+        ms->reachability_time = finalReachabilityTime;
+    }
     ms->lastreachnum = finalReachIndex;
     ms->reachareanum = finalReachArea;
     ms->lastgoalareanum = goal->areanum;
@@ -1469,6 +2207,96 @@ void BotMoveToGoal(bot_moveresult_t *result,
     VectorCopy(ms->origin, ms->lastorigin);
 }
 
+void BotMoveToGoal(bot_moveresult_t *result,
+                   int movestate,
+                   const bot_goal_t *goal,
+                   int travelflags)
+{
+    if (result == NULL)
+    {
+        return;
+    }
+
+    bot_movestate_t *ms = BotMoveStateFromHandle(movestate);
+    if (ms == NULL)
+    {
+        result->failure = 1;
+        return;
+    }
+
+    BotMove_MoveToGoal(result, ms, goal, travelflags);
+}
+
+/*
+ * Moves several bots in one call.  Handles are resolved up front and the
+ * bots are processed grouped by area so neighbouring bots share the AAS
+ * data they touch.  Each bot only changes its own move state and result,
+ * and the sort is stable, so the results match individual BotMoveToGoal
+ * calls made in the same frame.
+ */
+void BotMoveToGoalBatch(bot_moveresult_t *results,
+                        const int *movestates,
+                        const bot_goal_t *goals,
+                        const int *travelflags,
+                        int count)
+{
+    if (results == NULL || movestates == NULL || goals == NULL || travelflags == NULL || count <= 0)
+    {
+        return;
+    }
+
+    bot_movestate_t *states[MAX_CLIENTS];
+    int order[MAX_CLIENTS];
+
+    for (int first = 0; first < count; first += MAX_CLIENTS)
+    {
+        int chunk = count - first;
+        if (chunk > MAX_CLIENTS)
+        {
+            chunk = MAX_CLIENTS;
+        }
+
+        for (int i = 0; i < chunk; ++i)
+        {
+            states[i] = BotMoveStateFromHandle(movestates[first + i]);
+            if (states[i] == NULL)
+            {
+                results[first + i].failure = 1;
+            }
+        }
+
+        /* stable insertion sort keeps repeated handles in call order */
+        int sorted = 0;
+        for (int i = 0; i < chunk; ++i)
+        {
+            if (states[i] == NULL)
+            {
+                continue;
+            }
+
+            int area = states[i]->areanum;
+            int slot = sorted;
+            while (slot > 0 && states[order[slot - 1]]->areanum > area)
+            {
+                order[slot] = order[slot - 1];
+                --slot;
+            }
+            order[slot] = i;
+            ++sorted;
+        }
+
+        BotMove_MoverSnapshotUpdate();
+        for (int i = 0; i < sorted; ++i)
+        {
+            int index = order[i];
+            BotMove_MoveToGoal(&results[first + index],
+                               states[index],
+                               &goals[first + index],
+                               travelflags[first + index]);
+        }
+    }
+}
+
 int BotMoveInDirection(int movestate, const vec3_t dir, float speed, int type)
 {
     (void)speed;
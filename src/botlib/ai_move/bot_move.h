@@ -49,8 +49,10 @@ struct aas_reachability_s;
 #define BOT_MOVE_DIAG_FUNCBOB_RELINKED    (1u << 2)
 #define BOT_MOVE_DIAG_FUNCBOB_FAILED      (1u << 3)
 
-#define MAX_AVOIDREACH  1
+#define MAX_AVOIDREACH  4
 #define MAX_AVOIDSPOTS  32
+#define MAX_CORRIDOR    64
+#define MAX_MOVEPENALTIES 64
 
 /* avoid spot types */
 #define AVOID_CLEAR     0
@@ -68,6 +70,13 @@ struct aas_reachability_s;
 #define RESULTTYPE_BADGRAPPLEPATH     4
 #define RESULTTYPE_INSOLIDAREA        8
 
+/* stuck recovery tiers, tried in this order */
+#define BOT_MOVE_RECOVERY_NONE     0
+#define BOT_MOVE_RECOVERY_ALTREACH 1
+#define BOT_MOVE_RECOVERY_SIDESTEP 2
+#define BOT_MOVE_RECOVERY_REROUTE  3
+#define BOT_MOVE_RECOVERY_TIERS    4
+
 #ifndef BOT_GOAL_STRUCT_DEFINED
 #define BOT_GOAL_STRUCT_DEFINED
 typedef struct bot_goal_s
@@ -110,6 +119,20 @@ typedef struct bot_moveresult_s
     unsigned int diagnostics;
 } bot_moveresult_t;
 
+typedef struct bot_move_recovery_stats_s
+{
+    unsigned int attempts[BOT_MOVE_RECOVERY_TIERS];
+    unsigned int resolved[BOT_MOVE_RECOVERY_TIERS];
+} bot_move_recovery_stats_t;
+
+typedef struct bot_move_penalty_s
+{
+    int reachnum;  /* penalised reachability, 0 for an area penalty */
+    int areanum;   /* penalised area, 0 for a reachability penalty */
+    int cost;      /* extra travel time in hundredths of a second */
+    float endtime;
+} bot_move_penalty_t;
+
 typedef struct bot_avoidspot_s
 {
     vec3_t origin;
@@ -146,6 +169,29 @@ typedef struct bot_movestate_s
 
     bot_avoidspot_t avoidspots[MAX_AVOIDSPOTS];
     int numavoidspots;
+
+    /* reachabilities from the planning area towards corridorgoalarea */
+    int corridor[MAX_CORRIDOR];
+    int corridorareas[MAX_CORRIDOR]; /* area each corridor reachability leaves from */
+    int corridorlength;
+    int corridorindex;
+    int corridorgoalarea;
+    int corridortravelflags;
+    unsigned int corridorepoch; /* aasworld.reachabilityEpoch the corridor was planned in */
+
+    /* local stuck recovery */
+    vec3_t progressorigin;
+    float progresstime;
+    int recoverytier;
+    int recoveryarea;  /* area the bot got stuck in */
+    int recoveryreach; /* alternative reachability tried out of recoveryarea */
+    float sidesteptime;
+    vec3_t sidestepdir;
+    int sidesteps; /* sidesteps started by this bot, alternates their side */
+
+    /* route search buffers: queue, visited, parent area, parent reach */
+    int *scratch;
+    int scratchareas;
 } bot_movestate_t;
 
 int BotAllocMoveState(void);
@@ -153,6 +199,7 @@ void BotFreeMoveState(int handle);
 bot_movestate_t *BotMoveStateFromHandle(int handle);
 void BotResetMoveState(int movestate);
 void BotInitMoveState(int handle, const bot_initmove_t *initmove);
+void BotMove_SetupScratch(void);
 
 void BotClearMoveResult(bot_moveresult_t *moveresult);
 void BotMoveClassifyEnvironment(bot_movestate_t *ms);
@@ -162,10 +209,23 @@ void BotMoveToGoal(bot_moveresult_t *result,
                    const bot_goal_t *goal,
                    int travelflags);
 
+void BotMoveToGoalBatch(bot_moveresult_t *results,
+                        const int *movestates,
+                        const bot_goal_t *goals,
+                        const int *travelflags,
+                        int count);
+
 int BotMoveInDirection(int movestate, const vec3_t dir, float speed, int type);
 
 void BotMove_ResetAvoidReach(int movestate);
 
+void BotMove_AddReachPenalty(int reachnum, int cost, float duration);
+void BotMove_AddAreaPenalty(int areanum, int cost, float duration);
+void BotMove_ClearPenalties(void);
+
+void BotMove_GetRecoveryStats(bot_move_recovery_stats_t *stats);
+void BotMove_ResetRecoveryStats(void);
+
 void AI_MoveFrame(bot_moveresult_t *result,
                   int movestate,
                   const bot_goal_t *goal,
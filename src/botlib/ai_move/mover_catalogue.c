@@ -1,9 +1,11 @@
 #include "mover_catalogue.h"
 
+#include <math.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "botlib/aas/aas_local.h"
 #include "botlib/common/l_memory.h"
 
 static bot_mover_catalogue_entry_t *s_entries = NULL;
@@ -11,6 +13,17 @@ static size_t s_entry_count = 0U;
 static size_t s_entry_capacity = 0U;
 static bool s_catalogue_initialised = false;
 
+/* model number -> entry index + 1, 0 when the model is not catalogued */
+static int *s_model_index = NULL;
+static size_t s_model_index_size = 0U;
+
+/* brush-model entities seen this frame, and entnum -> state index + 1 */
+static bot_mover_state_t *s_movers = NULL;
+static int s_mover_count = 0;
+static int *s_mover_slots = NULL;
+static int s_mover_slot_count = 0;
+static int s_mover_frame = -1;
+
 static void BotMove_MoverCatalogueEnsureInit(void)
 {
     if (!s_catalogue_initialised)
@@ -21,20 +34,43 @@ static void BotMove_MoverCatalogueEnsureInit(void)
 
 static bot_mover_catalogue_entry_t *BotMove_MoverCatalogueFindMutable(int modelnum)
 {
-    if (s_entries == NULL)
+    if (s_entries == NULL || modelnum < 0 || (size_t)modelnum >= s_model_index_size)
     {
         return NULL;
     }
 
-    for (size_t i = 0U; i < s_entry_count; ++i)
+    int slot = s_model_index[modelnum];
+    return (slot > 0) ? &s_entries[slot - 1] : NULL;
+}
+
+static bool BotMove_MoverCatalogueIndexModel(int modelnum, size_t entry_index)
+{
+    if ((size_t)modelnum >= s_model_index_size)
     {
-        if (s_entries[i].modelnum == modelnum)
+        size_t new_size = (s_model_index_size == 0U) ? 64U : s_model_index_size;
+        while (new_size <= (size_t)modelnum)
+        {
+            new_size *= 2U;
+        }
+
+        int *new_index = (int *)GetClearedMemory(new_size * sizeof(*new_index));
+        if (new_index == NULL)
+        {
+            return false;
+        }
+
+        if (s_model_index != NULL)
         {
-            return &s_entries[i];
+            memcpy(new_index, s_model_index, s_model_index_size * sizeof(*new_index));
+            FreeMemory(s_model_index);
         }
+
+        s_model_index = new_index;
+        s_model_index_size = new_size;
     }
 
-    return NULL;
+    s_model_index[modelnum] = (int)entry_index + 1;
+    return true;
 }
 
 static bool BotMove_MoverCatalogueGrow(size_t required_capacity)
@@ -91,15 +127,23 @@ void BotMove_MoverCatalogueReset(void)
         s_entries = NULL;
     }
 
+    if (s_model_index != NULL)
+    {
+        FreeMemory(s_model_index);
+        s_model_index = NULL;
+    }
+
     s_entry_count = 0U;
     s_entry_capacity = 0U;
+    s_model_index_size = 0U;
+    BotMove_MoverSnapshotReset();
 }
 
 bool BotMove_MoverCatalogueInsert(const bot_mover_catalogue_entry_t *entry)
 {
     BotMove_MoverCatalogueEnsureInit();
 
-    if (entry == NULL)
+    if (entry == NULL || entry->modelnum < 0)
     {
         return false;
     }
@@ -114,7 +158,8 @@ bool BotMove_MoverCatalogueInsert(const bot_mover_catalogue_entry_t *entry)
         return true;
     }
 
-    if (!BotMove_MoverCatalogueGrow(s_entry_count + 1U))
+    if (!BotMove_MoverCatalogueGrow(s_entry_count + 1U)
+        || !BotMove_MoverCatalogueIndexModel(entry->modelnum, s_entry_count))
     {
         return false;
     }
@@ -209,3 +254,159 @@ bool BotMove_MoverCatalogueIsModelMover(int modelnum)
     return BotMove_MoverCatalogueFindByModel(modelnum) != NULL;
 }
 
+
+void BotMove_MoverSnapshotReset(void)
+{
+    if (s_movers != NULL)
+    {
+        FreeMemory(s_movers);
+        s_movers = NULL;
+    }
+
+    if (s_mover_slots != NULL)
+    {
+        FreeMemory(s_mover_slots);
+        s_mover_slots = NULL;
+    }
+
+    s_mover_count = 0;
+    s_mover_slot_count = 0;
+    s_mover_frame = -1;
+}
+
+static void BotMove_MoverSnapshotRestState(const bot_mover_catalogue_entry_t *catalogue,
+                                           const aas_entity_t *entity,
+                                           bot_mover_state_t *state)
+{
+    state->atrest = DotProduct(state->velocity, state->velocity) < 0.25f;
+    state->attop = false;
+    state->atbottom = false;
+
+    if (!state->atrest || catalogue == NULL || catalogue->kind != BOT_MOVER_KIND_FUNC_PLAT)
+    {
+        return;
+    }
+
+    /* plats spawn at the top (origin zero) and travel down by height or size - lip */
+    float travel = catalogue->height;
+    if (travel <= 0.0f)
+    {
+        travel = (entity->maxs[2] - entity->mins[2]) - catalogue->lip;
+    }
+
+    state->attop = fabsf(entity->origin[2]) < 1.0f;
+    state->atbottom = fabsf(entity->origin[2] + travel) < 1.0f;
+}
+
+static bool BotMove_MoverSnapshotEnsureCapacity(int maxEntities)
+{
+    if (maxEntities <= s_mover_slot_count)
+    {
+        return true;
+    }
+
+    BotMove_MoverSnapshotReset();
+
+    s_movers = (bot_mover_state_t *)GetClearedMemory((size_t)maxEntities * sizeof(*s_movers));
+    s_mover_slots = (int *)GetClearedMemory((size_t)maxEntities * sizeof(*s_mover_slots));
+    if (s_movers == NULL || s_mover_slots == NULL)
+    {
+        BotMove_MoverSnapshotReset();
+        return false;
+    }
+
+    s_mover_slot_count = maxEntities;
+    return true;
+}
+
+/*
+ * Captures every in-use brush-model entity once per AAS frame.  Entity
+ * updates arrive after BotStartFrame, so the first bot that asks in a frame
+ * builds the snapshot and the others read it.
+ */
+void BotMove_MoverSnapshotUpdate(void)
+{
+    if (s_mover_frame == aasworld.numFrames && s_movers != NULL)
+    {
+        return;
+    }
+
+    if (aasworld.entities == NULL || aasworld.maxEntities <= 0)
+    {
+        s_mover_count = 0;
+        s_mover_frame = aasworld.numFrames;
+        return;
+    }
+
+    if (!BotMove_MoverSnapshotEnsureCapacity(aasworld.maxEntities))
+    {
+        return;
+    }
+
+    for (int i = 0; i < s_mover_count; ++i)
+    {
+        s_mover_slots[s_movers[i].entnum] = 0;
+    }
+    s_mover_count = 0;
+
+    for (int entnum = 0; entnum < aasworld.maxEntities; ++entnum)
+    {
+        const aas_entity_t *entity = &aasworld.entities[entnum];
+        if (!entity->inuse || entity->solid != SOLID_BSP || entity->modelindex <= 0)
+        {
+            continue;
+        }
+
+        bot_mover_state_t *state = &s_movers[s_mover_count];
+        memset(state, 0, sizeof(*state));
+        state->entnum = entnum;
+        state->modelindex = entity->modelindex;
+        state->catalogue = BotMove_MoverCatalogueFindByModel(entity->modelindex - 1);
+        VectorCopy(entity->origin, state->origin);
+        VectorAdd(entity->origin, entity->mins, state->absmins);
+        VectorAdd(entity->origin, entity->maxs, state->absmaxs);
+        if (entity->deltaTime > 0.0f)
+        {
+            float scale = 1.0f / entity->deltaTime;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                state->velocity[axis] = (entity->origin[axis] - entity->previousOrigin[axis]) * scale;
+            }
+        }
+        BotMove_MoverSnapshotRestState(state->catalogue, entity, state);
+
+        ++s_mover_count;
+        s_mover_slots[entnum] = s_mover_count;
+    }
+
+    s_mover_frame = aasworld.numFrames;
+}
+
+int BotMove_MoverSnapshotCount(void)
+{
+    BotMove_MoverSnapshotUpdate();
+    return s_mover_count;
+}
+
+const bot_mover_state_t *BotMove_MoverSnapshotGet(int index)
+{
+    BotMove_MoverSnapshotUpdate();
+    if (index < 0 || index >= s_mover_count)
+    {
+        return NULL;
+    }
+
+    return &s_movers[index];
+}
+
+const bot_mover_state_t *BotMove_MoverSnapshotForEntity(int entnum)
+{
+    BotMove_MoverSnapshotUpdate();
+    if (entnum < 0 || entnum >= s_mover_slot_count || s_mover_slots == NULL)
+    {
+        return NULL;
+    }
+
+    int slot = s_mover_slots[entnum];
+    return (slot > 0) ? &s_movers[slot - 1] : NULL;
+}
@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 
+#include "shared/q_shared.h"
 #include "botlib/interface/bot_interface_assets.h"
 
 #ifdef __cplusplus
@@ -31,6 +32,25 @@ typedef struct bot_mover_catalogue_entry_s
     bool ready;
 } bot_mover_catalogue_entry_t;
 
+/*
+ * Per-frame view of every brush-model entity, shared by all bots.  The
+ * catalogue entry is looked up with the bot-side model number
+ * (modelindex - 1) and is NULL for brush models that are not movers.
+ */
+typedef struct bot_mover_state_s
+{
+    int entnum;
+    int modelindex;
+    const bot_mover_catalogue_entry_t *catalogue;
+    vec3_t origin;
+    vec3_t velocity;
+    vec3_t absmins;
+    vec3_t absmaxs;
+    bool atrest;
+    bool attop;
+    bool atbottom;
+} bot_mover_state_t;
+
 void BotMove_MoverCatalogueInit(void);
 void BotMove_MoverCatalogueReset(void);
 bool BotMove_MoverCatalogueInsert(const bot_mover_catalogue_entry_t *entry);
@@ -38,6 +58,12 @@ bool BotMove_MoverCatalogueFinalize(const botinterface_asset_list_t *models);
 const bot_mover_catalogue_entry_t *BotMove_MoverCatalogueFindByModel(int modelnum);
 bool BotMove_MoverCatalogueIsModelMover(int modelnum);
 
+void BotMove_MoverSnapshotReset(void);
+void BotMove_MoverSnapshotUpdate(void);
+int BotMove_MoverSnapshotCount(void);
+const bot_mover_state_t *BotMove_MoverSnapshotGet(int index);
+const bot_mover_state_t *BotMove_MoverSnapshotForEntity(int entnum);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,246 @@
+#include "l_avoid.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "l_memory.h"
+
+static unsigned int AvoidTable_Hash(int id) {
+    return (unsigned int)id * 2654435761u;
+}
+
+static int AvoidTable_FindSlot(const bot_avoidtable_t *table, int id) {
+    int slot = (int)(AvoidTable_Hash(id) & (unsigned int)table->slotmask);
+    while (table->slots[slot] != 0) {
+        if (table->entries[table->slots[slot] - 1].id == id) {
+            return slot;
+        }
+        slot = (slot + 1) & table->slotmask;
+    }
+    return -1;
+}
+
+static void AvoidTable_HeapSwap(bot_avoidtable_t *table, int a, int b) {
+    int entry = table->heap[a];
+    table->heap[a] = table->heap[b];
+    table->heap[b] = entry;
+    table->entries[table->heap[a]].heapindex = a;
+    table->entries[table->heap[b]].heapindex = b;
+}
+
+static float AvoidTable_HeapExpiry(const bot_avoidtable_t *table, int index) {
+    return table->entries[table->heap[index]].expiry;
+}
+
+static void AvoidTable_SiftUp(bot_avoidtable_t *table, int index) {
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (AvoidTable_HeapExpiry(table, parent) <= AvoidTable_HeapExpiry(table, index)) {
+            break;
+        }
+        AvoidTable_HeapSwap(table, parent, index);
+        index = parent;
+    }
+}
+
+static void AvoidTable_SiftDown(bot_avoidtable_t *table, int index, int size) {
+    for (;;) {
+        int smallest = index;
+        int left = index * 2 + 1;
+        int right = left + 1;
+        if (left < size && AvoidTable_HeapExpiry(table, left) < AvoidTable_HeapExpiry(table, smallest)) {
+            smallest = left;
+        }
+        if (right < size && AvoidTable_HeapExpiry(table, right) < AvoidTable_HeapExpiry(table, smallest)) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            return;
+        }
+        AvoidTable_HeapSwap(table, smallest, index);
+        index = smallest;
+    }
+}
+
+/* empties a hash slot, shifting back later members of its probe run */
+static void AvoidTable_ClearSlot(bot_avoidtable_t *table, int slot) {
+    int hole = slot;
+    int next = slot;
+    for (;;) {
+        next = (next + 1) & table->slotmask;
+        if (table->slots[next] == 0) {
+            break;
+        }
+
+        int home = (int)(AvoidTable_Hash(table->entries[table->slots[next] - 1].id) & (unsigned int)table->slotmask);
+        bool movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            table->slots[hole] = table->slots[next];
+            hole = next;
+        }
+    }
+    table->slots[hole] = 0;
+}
+
+static void AvoidTable_RemoveEntry(bot_avoidtable_t *table, int slot) {
+    int index = table->slots[slot] - 1;
+    int last = table->count - 1;
+
+    /* take the entry out of the heap */
+    int heapindex = table->entries[index].heapindex;
+    if (heapindex != last) {
+        AvoidTable_HeapSwap(table, heapindex, last);
+        AvoidTable_SiftDown(table, heapindex, last);
+        AvoidTable_SiftUp(table, heapindex);
+    }
+
+    AvoidTable_ClearSlot(table, slot);
+
+    /* keep the entries packed by moving the last one into the gap */
+    if (index != last) {
+        int lastslot = AvoidTable_FindSlot(table, table->entries[last].id);
+        table->entries[index] = table->entries[last];
+        table->slots[lastslot] = index + 1;
+        table->heap[table->entries[index].heapindex] = index;
+    }
+
+    table->count = last;
+}
+
+bool AvoidTable_Init(bot_avoidtable_t *table, int capacity) {
+    if (table == NULL) {
+        return false;
+    }
+
+    memset(table, 0, sizeof(*table));
+    if (capacity <= 0) {
+        return false;
+    }
+
+    /* keep the hash at most half full so probe runs stay short */
+    int numslots = 1;
+    while (numslots < capacity * 2) {
+        numslots <<= 1;
+    }
+
+    table->entries = (bot_avoidentry_t *)GetClearedMemory((size_t)capacity * sizeof(bot_avoidentry_t));
+    table->heap = (int *)GetClearedMemory((size_t)capacity * sizeof(int));
+    table->slots = (int *)GetClearedMemory((size_t)numslots * sizeof(int));
+    if (table->entries == NULL || table->heap == NULL || table->slots == NULL) {
+        AvoidTable_Free(table);
+        return false;
+    }
+
+    table->capacity = capacity;
+    table->slotmask = numslots - 1;
+    return true;
+}
+
+void AvoidTable_Free(bot_avoidtable_t *table) {
+    if (table == NULL) {
+        return;
+    }
+
+    if (table->entries != NULL) {
+        FreeMemory(table->entries);
+    }
+    if (table->heap != NULL) {
+        FreeMemory(table->heap);
+    }
+    if (table->slots != NULL) {
+        FreeMemory(table->slots);
+    }
+    memset(table, 0, sizeof(*table));
+}
+
+void AvoidTable_Clear(bot_avoidtable_t *table) {
+    if (table == NULL || table->slots == NULL) {
+        return;
+    }
+
+    memset(table->slots, 0, (size_t)(table->slotmask + 1) * sizeof(int));
+    table->count = 0;
+}
+
+bool AvoidTable_Set(bot_avoidtable_t *table, int id, float expiry) {
+    if (table == NULL || table->capacity <= 0) {
+        return false;
+    }
+
+    int slot = AvoidTable_FindSlot(table, id);
+    if (slot >= 0) {
+        bot_avoidentry_t *entry = &table->entries[table->slots[slot] - 1];
+        entry->expiry = expiry;
+        AvoidTable_SiftDown(table, entry->heapindex, table->count);
+        AvoidTable_SiftUp(table, entry->heapindex);
+        return true;
+    }
+
+    if (table->count >= table->capacity) {
+        AvoidTable_RemoveEntry(table, AvoidTable_FindSlot(table, table->entries[table->heap[0]].id));
+    }
+
+    int index = table->count++;
+    bot_avoidentry_t *entry = &table->entries[index];
+    entry->id = id;
+    entry->expiry = expiry;
+    entry->heapindex = index;
+    table->heap[index] = index;
+    AvoidTable_SiftUp(table, index);
+
+    slot = (int)(AvoidTable_Hash(id) & (unsigned int)table->slotmask);
+    while (table->slots[slot] != 0) {
+        slot = (slot + 1) & table->slotmask;
+    }
+    table->slots[slot] = index + 1;
+    return true;
+}
+
+bool AvoidTable_Remove(bot_avoidtable_t *table, int id) {
+    if (table == NULL || table->count <= 0) {
+        return false;
+    }
+
+    int slot = AvoidTable_FindSlot(table, id);
+    if (slot < 0) {
+        return false;
+    }
+
+    AvoidTable_RemoveEntry(table, slot);
+    return true;
+}
+
+const bot_avoidentry_t *AvoidTable_Find(const bot_avoidtable_t *table, int id) {
+    if (table == NULL || table->count <= 0) {
+        return NULL;
+    }
+
+    int slot = AvoidTable_FindSlot(table, id);
+    if (slot < 0) {
+        return NULL;
+    }
+    return &table->entries[table->slots[slot] - 1];
+}
+
+bool AvoidTable_Contains(const bot_avoidtable_t *table, int id, float now) {
+    const bot_avoidentry_t *entry = AvoidTable_Find(table, id);
+    return entry != NULL && entry->expiry > now;
+}
+
+float AvoidTable_Remaining(const bot_avoidtable_t *table, int id, float now) {
+    const bot_avoidentry_t *entry = AvoidTable_Find(table, id);
+    if (entry == NULL || entry->expiry <= now) {
+        return 0.0f;
+    }
+    return entry->expiry - now;
+}
+
+void AvoidTable_Expire(bot_avoidtable_t *table, float now) {
+    if (table == NULL) {
+        return;
+    }
+
+    while (table->count > 0 && table->entries[table->heap[0]].expiry <= now) {
+        AvoidTable_RemoveEntry(table, AvoidTable_FindSlot(table, table->entries[table->heap[0]].id));
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef BOTLIB_COMMON_L_AVOID_H
+#define BOTLIB_COMMON_L_AVOID_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Set of ids that expire at a given time, used for avoided goals and
+ * reachabilities.  Lookups go through an open-addressing hash keyed by id and
+ * a min-heap ordered by expiry drops stale entries without scanning.  The
+ * live entries are kept packed in entries[0..count) for iteration; their
+ * order changes as entries are removed.
+ */
+typedef struct bot_avoidentry_s {
+    int id;
+    float expiry;
+    int heapindex;
+} bot_avoidentry_t;
+
+typedef struct bot_avoidtable_s {
+    bot_avoidentry_t *entries;
+    int count;
+    int capacity;
+    int *heap;  /* entry indexes, earliest expiry first */
+    int *slots; /* entry index + 1 per hash slot, 0 when empty */
+    int slotmask;
+} bot_avoidtable_t;
+
+bool AvoidTable_Init(bot_avoidtable_t *table, int capacity);
+void AvoidTable_Free(bot_avoidtable_t *table);
+void AvoidTable_Clear(bot_avoidtable_t *table);
+
+/* adds id or moves its expiry, evicting the earliest expiry when full */
+bool AvoidTable_Set(bot_avoidtable_t *table, int id, float expiry);
+bool AvoidTable_Remove(bot_avoidtable_t *table, int id);
+const bot_avoidentry_t *AvoidTable_Find(const bot_avoidtable_t *table, int id);
+bool AvoidTable_Contains(const bot_avoidtable_t *table, int id, float now);
+float AvoidTable_Remaining(const bot_avoidtable_t *table, int id, float now);
+
+/* drops every entry whose expiry is at or before now */
+void AvoidTable_Expire(bot_avoidtable_t *table, float now);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // BOTLIB_COMMON_L_AVOID_H
@@ -27,6 +27,7 @@ typedef struct bot_memory_state_s {
     bool initialised;
     size_t heap_capacity;
     size_t allocated_bytes;
+    size_t allocation_count;
     int block_count;
     bot_memory_block_t *head;
     bot_memory_log_fn log_callback;
@@ -36,6 +37,7 @@ static bot_memory_state_t g_memory_state = {
     .initialised = false,
     .heap_capacity = BOT_MEMORY_DEFAULT_HEAP_SIZE,
     .allocated_bytes = 0,
+    .allocation_count = 0,
     .block_count = 0,
     .head = NULL,
     .log_callback = NULL,
@@ -106,6 +108,7 @@ static bot_memory_block_t *BotMemory_BlockFromPointer(const void *ptr, const cha
 
 static void BotMemory_TrackAllocation(bot_memory_block_t *block) {
     g_memory_state.allocated_bytes += block->total_size;
+    g_memory_state.allocation_count += 1;
     g_memory_state.block_count += 1;
     BotMemory_LinkBlock(block);
 }
@@ -273,6 +276,33 @@ size_t BotMemory_TotalAllocated(void) {
     return g_memory_state.allocated_bytes;
 }
 
+/*
+ * Running total of successful GetMemory, GetClearedMemory and
+ * BotMemory_Malloc/Calloc/Realloc calls, never decremented by a free.
+ */
+size_t BotMemory_AllocationCount(void) {
+    return g_memory_state.allocation_count;
+}
+
+static void *BotMemory_CountSystemAllocation(void *ptr) {
+    if (ptr != NULL) {
+        g_memory_state.allocation_count += 1;
+    }
+    return ptr;
+}
+
+void *BotMemory_Malloc(size_t size) {
+    return BotMemory_CountSystemAllocation(malloc(size));
+}
+
+void *BotMemory_Calloc(size_t count, size_t size) {
+    return BotMemory_CountSystemAllocation(calloc(count, size));
+}
+
+void *BotMemory_Realloc(void *ptr, size_t size) {
+    return BotMemory_CountSystemAllocation(realloc(ptr, size));
+}
+
 size_t BotMemory_HeapCapacity(void) {
     return g_memory_state.heap_capacity;
 }
@@ -29,8 +29,14 @@ size_t MemoryByteSize(const void *ptr);
 int AvailableMemory(void);
 
 size_t BotMemory_TotalAllocated(void);
+size_t BotMemory_AllocationCount(void);
 size_t BotMemory_HeapCapacity(void);
 
+/* C library allocations that count towards BotMemory_AllocationCount; release with free() */
+void *BotMemory_Malloc(size_t size);
+void *BotMemory_Calloc(size_t count, size_t size);
+void *BotMemory_Realloc(void *ptr, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,7 @@
 #include "q2bridge/update_translator.h"
 #include "botlib/common/l_libvar.h"
 #include "botlib/common/l_log.h"
+#include "botlib/common/l_memory.h"
 #include "botlib/aas/aas_map.h"
 #include "botlib/aas/aas_local.h"
 #include "botlib/aas/aas_sound.h"
@@ -40,6 +41,7 @@
 #include "botlib/precomp/l_precomp.h"
 #include "botlib_interface.h"
 #include "bot_interface.h"
+#include "bot_perception.h"
 #include "bot_state.h"
 
 static void BotInterface_Printf(int priority, const char *fmt, ...);
@@ -70,7 +72,16 @@ static botinterface_entity_snapshot_t g_botInterfaceEntityCache[BOT_INTERFACE_MA
 static float g_botInterfaceFrameTime = 0.0f;
 static unsigned int g_botInterfaceFrameNumber = 0;
 static bool g_botInterfaceDebugDrawEnabled = false;
+static bool g_botInterfaceLocalTrace = false;
+static bool g_botInterfaceAssignGoals = false;
+static unsigned int g_botInterfaceGoalsAssignedFrame = 0;
+static int g_botInterfacePerceptionBudget = 0;
 
+#define BOT_INTERFACE_ITEMTRAVEL_ROWS 8 /* item travel matrix rows filled per frame */
+
+#define BOT_INTERFACE_DEFAULT_VIEWHEIGHT 22.0f
+
+#define CHARACTERISTIC_REACTIONTIME 11
 #define CHARACTERISTIC_EASY_FRAGGER 42
 #define CHARACTERISTIC_ALERTNESS 43
 
@@ -193,16 +204,11 @@ static void BotInterface_ClientEyePosition(const bot_client_state_t *state, vec3
     out[2] += state->last_client_update.viewoffset[2];
 }
 
-static bool BotInterface_HasLineOfSight(const vec3_t from,
-                                        const vec3_t to,
-                                        int viewer,
-                                        int target)
+static bool BotInterface_TraceLineOfSight(const vec3_t from,
+                                          const vec3_t to,
+                                          int viewer,
+                                          int target)
 {
-    if (from == NULL || to == NULL)
-    {
-        return false;
-    }
-
     vec3_t start;
     vec3_t end;
     VectorCopy(from, start);
@@ -210,10 +216,26 @@ static bool BotInterface_HasLineOfSight(const vec3_t from,
 
     vec3_t mins = {0.0f, 0.0f, 0.0f};
     vec3_t maxs = {0.0f, 0.0f, 0.0f};
-    bsp_trace_t trace = Q2_Trace(start, mins, maxs, end, viewer, MASK_SHOT);
+    bsp_trace_t trace = g_botInterfaceLocalTrace
+                            ? AAS_BSPTrace(start, mins, maxs, end, viewer, MASK_SHOT)
+                            : Q2_Trace(start, mins, maxs, end, viewer, MASK_SHOT);
     return trace.fraction >= 1.0f || trace.ent == target;
 }
 
+/* bots know their own view offset; other clients are assumed to stand */
+static void BotInterface_EntityEyePosition(int ent, const bot_updateentity_t *snapshot, vec3_t out)
+{
+    const bot_client_state_t *client = BotState_Get(ent);
+    if (client != NULL && client->client_update_valid)
+    {
+        BotInterface_ClientEyePosition(client, out);
+        return;
+    }
+
+    VectorCopy(snapshot->origin, out);
+    out[2] += BOT_INTERFACE_DEFAULT_VIEWHEIGHT;
+}
+
 static bool BotInterface_SameTeam(const bot_client_state_t *lhs, const bot_client_state_t *rhs)
 {
     if (lhs == NULL || rhs == NULL)
@@ -261,6 +283,16 @@ static bool BotInterface_IsShooting(const bot_updateentity_t *snapshot)
     return (snapshot->effects & weapon_fx) != 0;
 }
 
+/* origin of a client with a snapshot this frame, NULL otherwise */
+static const float *BotInterface_ClientOrigin(int ent)
+{
+    if (ent < 0 || ent >= BOT_INTERFACE_MAX_ENTITIES || !g_botInterfaceEntityCache[ent].valid)
+    {
+        return NULL;
+    }
+    return g_botInterfaceEntityCache[ent].state.origin;
+}
+
 static float BotInterface_VectorLengthSquared(const vec3_t v)
 {
     if (v == NULL)
@@ -291,22 +323,7 @@ static void BotAI_FindEnemy(bot_client_state_t *state, ai_dm_enemy_info_t *enemy
     }
 
     bot_combat_state_t *combat = &state->combat;
-
-    int current_health = state->last_client_update.stats[STAT_HEALTH];
-    bool health_drop = false;
-    if (combat->last_health_valid && current_health < combat->last_known_health)
-    {
-        combat->took_damage = true;
-        combat->last_damage_amount = combat->last_known_health - current_health;
-        combat->last_damage_time = g_botInterfaceFrameTime;
-        health_drop = true;
-    }
-    else
-    {
-        combat->took_damage = false;
-    }
-    combat->last_known_health = current_health;
-    combat->last_health_valid = true;
+    bool health_drop = combat->took_damage;
 
     float alertness = 0.5f;
     float easyfragger = 1.0f;
@@ -321,6 +338,9 @@ static void BotAI_FindEnemy(bot_client_state_t *state, ai_dm_enemy_info_t *enemy
     vec3_t eye_position;
     BotInterface_ClientEyePosition(state, eye_position);
 
+    /* targets whose eye is outside the PVS of ours can never be seen, skip them before any trace */
+    int eye_cluster = AAS_BSPPointCluster(eye_position);
+
     int curenemy = combat->current_enemy;
     const bot_updateentity_t *current_snapshot = NULL;
     float current_enemy_dist_sq = FLT_MAX;
@@ -345,7 +365,9 @@ static void BotAI_FindEnemy(bot_client_state_t *state, ai_dm_enemy_info_t *enemy
         bot_client_state_t *current_state = BotState_Get(curenemy);
         bool chatting = BotInterface_IsChatting(current_state);
 
-        if (!(invisible && !shooting))
+        vec3_t target_eye;
+        BotInterface_EntityEyePosition(curenemy, current_snapshot, target_eye);
+        if (!(invisible && !shooting) && AAS_BSPClustersInPVS(eye_cluster, AAS_BSPPointCluster(target_eye)))
         {
             vec3_t to_enemy;
             VectorSubtract(current_snapshot->origin, eye_position, to_enemy);
@@ -357,7 +379,11 @@ static void BotAI_FindEnemy(bot_client_state_t *state, ai_dm_enemy_info_t *enemy
                                 : current_enemy_dist_sq;
             float fov = 90.0f + (limited / (810.0f * 9.0f));
             bool in_fov = BotInterface_InFieldOfVision(state->last_client_update.viewangles, fov, target_angles);
-            bool has_los = BotInterface_HasLineOfSight(eye_position, current_snapshot->origin, state->client_number, curenemy);
+            bool has_los = BotPerception_HasLineOfSight(eye_position,
+                                                        target_eye,
+                                                        state->client_number,
+                                                        curenemy,
+                                                        BotInterface_TraceLineOfSight);
 
             if (in_fov && has_los)
             {
@@ -401,8 +427,36 @@ static void BotAI_FindEnemy(bot_client_state_t *state, ai_dm_enemy_info_t *enemy
     float max_range = 900.0f + alertness * 4000.0f;
     float max_range_sq = max_range * max_range;
 
-    for (int ent = 0; ent < max_clients; ++ent)
-    {
+    /*
+     * While an enemy is held only closer clients can replace it and the
+     * field of view stays within 180 degrees, so the grid query can shrink
+     * to that distance and drop everything behind the bot.
+     */
+    float search_range = max_range;
+    const float *search_forward = NULL;
+    vec3_t forward = {0.0f, 0.0f, 0.0f};
+    if (curenemy >= 0)
+    {
+        search_range = fminf(max_range, sqrtf(current_enemy_dist_sq));
+        float yaw = state->last_client_update.viewangles[YAW] * ((float)M_PI / 180.0f);
+        forward[0] = cosf(yaw);
+        forward[1] = sinf(yaw);
+        search_forward = forward;
+    }
+
+    static int candidates[BOT_INTERFACE_MAX_ENTITIES];
+    int num_candidates = BotPerception_ClientGridQuery(self_origin,
+                                                       search_range,
+                                                       eye_position,
+                                                       search_forward,
+                                                       g_botInterfaceFrameNumber,
+                                                       max_clients,
+                                                       BotInterface_ClientOrigin,
+                                                       candidates);
+
+    for (int index = 0; index < num_candidates; ++index)
+    {
+        int ent = candidates[index];
         if (ent == state->client_number || ent == curenemy)
         {
             continue;
@@ -452,6 +506,13 @@ static void BotAI_FindEnemy(bot_client_state_t *state, ai_dm_enemy_info_t *enemy
             continue;
         }
 
+        vec3_t target_eye;
+        BotInterface_EntityEyePosition(ent, snapshot, target_eye);
+        if (!AAS_BSPClustersInPVS(eye_cluster, AAS_BSPPointCluster(target_eye)))
+        {
+            continue;
+        }
+
         float limited = (distance_sq > 810.0f * 810.0f) ? 810.0f * 810.0f : distance_sq;
         float fov = (curenemy < 0 && (health_drop || shooting)) ? 360.0f : 90.0f + (limited / (810.0f * 9.0f));
 
@@ -465,7 +526,11 @@ static void BotAI_FindEnemy(bot_client_state_t *state, ai_dm_enemy_info_t *enemy
             continue;
         }
 
-        bool has_los = BotInterface_HasLineOfSight(eye_position, snapshot->origin, state->client_number, ent);
+        bool has_los = BotPerception_HasLineOfSight(eye_position,
+                                                    target_eye,
+                                                    state->client_number,
+                                                    ent,
+                                                    BotInterface_TraceLineOfSight);
         if (!has_los)
         {
             continue;
@@ -527,6 +592,103 @@ static void BotAI_FindEnemy(bot_client_state_t *state, ai_dm_enemy_info_t *enemy
     }
 }
 
+#define BOT_AI_PERCEPTION_DEFAULT_REACTION 0.3f /* reaction time of bots without a character */
+
+static float BotAI_PerceptionInterval(const bot_client_state_t *state)
+{
+    float reaction = BOT_AI_PERCEPTION_DEFAULT_REACTION;
+    if (state->character_handle > 0)
+    {
+        reaction = Characteristic_BFloat(state->character_handle, CHARACTERISTIC_REACTIONTIME, 0.0f, 5.0f);
+    }
+
+    ai_dm_metrics_t metrics = {0};
+    if (state->dm_state != NULL)
+    {
+        AI_DMState_GetMetrics(state->dm_state, &metrics);
+    }
+
+    bool in_combat = state->combat.current_enemy >= 0 && state->combat.enemy_visible;
+    return BotPerception_SearchInterval(reaction, metrics.reaction_delay, in_combat);
+}
+
+/*
+ * Health is tracked every think, whether or not a search runs, so damage
+ * taken between searches is noticed on the frame it lands.
+ */
+static void BotAI_TrackHealth(bot_client_state_t *state)
+{
+    bot_combat_state_t *combat = &state->combat;
+    int current_health = state->last_client_update.stats[STAT_HEALTH];
+    if (combat->last_health_valid && current_health < combat->last_known_health)
+    {
+        combat->took_damage = true;
+        combat->last_damage_amount = combat->last_known_health - current_health;
+        combat->last_damage_time = g_botInterfaceFrameTime;
+    }
+    else
+    {
+        combat->took_damage = false;
+    }
+    combat->last_known_health = current_health;
+    combat->last_health_valid = true;
+}
+
+static void BotAI_ReusePerception(bot_client_state_t *state, ai_dm_enemy_info_t *enemy)
+{
+    BotAI_InitEnemyInfo(enemy);
+
+    const bot_combat_state_t *combat = &state->combat;
+    const ai_dm_enemy_info_t *perceived = &combat->perceived;
+
+    /* the deathmatch state may have dropped the enemy since the search */
+    int ent = perceived->entity;
+    if (!perceived->valid || ent != combat->current_enemy || ent < 0 || ent >= BOT_INTERFACE_MAX_ENTITIES ||
+        !g_botInterfaceEntityCache[ent].valid)
+    {
+        return;
+    }
+
+    *enemy = *perceived;
+    enemy->triggered_by_damage = false;
+
+    if (combat->enemy_last_seen_time > -FLT_MAX * 0.5f)
+    {
+        float elapsed = g_botInterfaceFrameTime - combat->enemy_last_seen_time;
+        elapsed = (elapsed < 0.0f) ? 0.0f : elapsed;
+        elapsed = (elapsed > BOT_PERCEPTION_MAX_INTERVAL) ? BOT_PERCEPTION_MAX_INTERVAL : elapsed;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            enemy->origin[axis] = combat->last_enemy_origin[axis] + combat->last_enemy_velocity[axis] * elapsed;
+        }
+    }
+
+    vec3_t delta;
+    VectorSubtract(enemy->origin, state->last_client_update.origin, delta);
+    enemy->distance = sqrtf(BotInterface_VectorLengthSquared(delta));
+}
+
+static void BotAI_Perceive(bot_client_state_t *state, ai_dm_enemy_info_t *enemy)
+{
+    BotAI_TrackHealth(state);
+
+    bot_combat_state_t *combat = &state->combat;
+    float now = g_botInterfaceFrameTime;
+    float interval = BotAI_PerceptionInterval(state);
+    bool budget_spent = g_botInterfacePerceptionBudget > 0 &&
+                        BotPerception_FrameTraces() >= g_botInterfacePerceptionBudget;
+
+    if (!BotPerception_SearchDue(&combat->perception, now, interval, combat->took_damage, budget_spent))
+    {
+        BotAI_ReusePerception(state, enemy);
+        return;
+    }
+
+    BotAI_FindEnemy(state, enemy);
+    combat->perceived = *enemy;
+    BotPerception_ScheduleSearch(&combat->perception, state->client_number, now, interval);
+}
+
 static void BotInterface_SynchroniseCombatState(bot_client_state_t *state)
 {
     if (state == NULL || state->dm_state == NULL)
@@ -656,6 +818,7 @@ static void BotInterface_ResetEntityCache(void)
 static void BotInterface_ResetMapCache(void)
 {
     BotMove_MoverCatalogueReset();
+    BotMove_ClearPenalties();
     BotInterface_FreeAssetList(&g_botInterfaceMapCache.models);
     BotInterface_FreeAssetList(&g_botInterfaceMapCache.sounds);
     BotInterface_FreeAssetList(&g_botInterfaceMapCache.images);
@@ -1109,6 +1272,15 @@ static void BotInterface_BeginFrame(float time)
     AAS_ReachabilityFrameUpdate();
     BotInterface_ResetFrameQueues();
 
+    /* bot_localtrace answers visibility traces from the botlib's own BSP copy. */
+    g_botInterfaceLocalTrace = LibVarValue("bot_localtrace", "0") != 0.0f && AAS_BSPCollisionLoaded();
+
+    /* bot_assigngoals shares the long-term goals out between the bots each frame. */
+    g_botInterfaceAssignGoals = LibVarValue("bot_assigngoals", "0") != 0.0f;
+
+    /* bot_perceptiontraces caps the sight traces per frame before due searches are deferred, 0 for no cap. */
+    g_botInterfacePerceptionBudget = (int)LibVarValue("bot_perceptiontraces", "64");
+
     for (int client = 0; client < MAX_CLIENTS; ++client)
     {
         bot_client_state_t *state = BotState_Get(client);
@@ -1829,6 +2001,8 @@ static int BotLoadMap(char *mapname,
         return status;
     }
 
+    BotMove_SetupScratch();
+
     if (!BotInterface_RecordMapAssets(mapname,
                                       modelindexes,
                                       modelindex,
@@ -2168,12 +2342,15 @@ static int BotStartFrame(float time)
     }
 
     BotInterface_BeginFrame(time);
+    BotPerception_BeginFrame();
     AAS_FrameSynchronise(time);
     AAS_UnlinkInvalidEntities();
     AAS_InvalidateEntities();
     AAS_ContinueInit(time);
     AAS_RouteFrameUpdate();
     AAS_ReachabilityFrameUpdate();
+    BotGoal_UpdateItemSnapshot(g_botInterfaceFrameTime);
+    BotGoal_UpdateItemTravelMatrix(BOT_INTERFACE_ITEMTRAVEL_ROWS);
 
     aasworld.numFrames += 1;
 
@@ -2356,6 +2533,62 @@ static int BotAddPointLight(vec3_t origin,
     return BLERR_NOERROR;
 }
 
+/*
+ * Run by the first bot to think in a frame: every bot that needs a new
+ * long-term goal gets one from a single assignment pass, so they spread over
+ * the items instead of racing for the same one.  Bots that still have a goal
+ * are left out and choose on their own as before.
+ */
+static void BotInterface_AssignTeamGoals(void)
+{
+    static bot_goalassignment_t bots[MAX_CLIENTS];
+
+    if (!g_botInterfaceAssignGoals || g_botInterfaceGoalsAssignedFrame == g_botInterfaceFrameNumber)
+    {
+        return;
+    }
+    g_botInterfaceGoalsAssignedFrame = g_botInterfaceFrameNumber;
+
+    int numbots = 0;
+    for (int client = 0; client < MAX_CLIENTS; ++client)
+    {
+        bot_client_state_t *state = BotState_Get(client);
+        if (state == NULL || !state->active || !state->client_update_valid || state->goal_handle <= 0
+            || state->goal_state == NULL)
+        {
+            continue;
+        }
+
+        AI_GoalBotlib_SynchroniseAvoid(state->goal_handle, state->goal_state, g_botInterfaceFrameTime);
+
+        bot_goal_t goal;
+        if (AI_GoalBotlib_GetTopGoal(state->goal_handle, &goal))
+        {
+            if (!BotTouchingGoal(state->last_client_update.origin, &goal))
+            {
+                continue;
+            }
+            AI_GoalBotlib_PopGoal(state->goal_handle);
+            if (AI_GoalBotlib_GetTopGoal(state->goal_handle, &goal))
+            {
+                continue;
+            }
+        }
+
+        bot_goalassignment_t *bot = &bots[numbots++];
+        bot->handle = state->goal_handle;
+        VectorCopy(state->last_client_update.origin, bot->origin);
+        bot->inventory = state->last_client_update.inventory;
+        bot->travelflags = TFL_DEFAULT;
+        bot->number = 0;
+    }
+
+    if (numbots > 1)
+    {
+        AI_GoalBotlib_AssignLTGs(bots, numbots);
+    }
+}
+
 static int BotAI_Think(bot_client_state_t *state, float thinktime)
 {
     if (state == NULL)
@@ -2388,13 +2621,15 @@ static int BotAI_Think(bot_client_state_t *state, float thinktime)
         return status;
     }
 
+    BotInterface_AssignTeamGoals();
+
     if (state->goal_handle > 0)
     {
         AI_GoalBotlib_SynchroniseAvoid(state->goal_handle, state->goal_state, g_botInterfaceFrameTime);
         AI_GoalBotlib_Update(state->goal_handle,
                              state->last_client_update.origin,
                              state->last_client_update.inventory,
-                             0,
+                             TFL_DEFAULT,
                              g_botInterfaceFrameTime,
                              3.0f);
     }
@@ -2424,7 +2659,7 @@ static int BotAI_Think(bot_client_state_t *state, float thinktime)
     BotAI_InitEnemyInfo(&enemy_info);
     if (state->dm_state != NULL)
     {
-        BotAI_FindEnemy(state, &enemy_info);
+        BotAI_Perceive(state, &enemy_info);
     }
 
     input.thinktime = thinktime;
@@ -2460,6 +2695,49 @@ static int BotAI_Think(bot_client_state_t *state, float thinktime)
     return BLERR_NOERROR;
 }
 
+/*
+ * Once a bot has warmed up its think pass should run entirely out of
+ * buffers sized at map load.  Botlib heap allocations made during a think
+ * after that are counted and reported when bot_developer is set.  Builds
+ * without NDEBUG, which include the tests, always report them and abort.
+ */
+#define BOT_AI_WARMUP_FRAMES 10
+
+static size_t g_botInterfaceThinkAllocations = 0;
+
+size_t BotInterface_ThinkAllocations(void)
+{
+    return g_botInterfaceThinkAllocations;
+}
+
+static void BotAI_CheckAllocations(bot_client_state_t *state, size_t allocationsBefore)
+{
+    if (state->think_frames < BOT_AI_WARMUP_FRAMES)
+    {
+        state->think_frames += 1;
+        return;
+    }
+
+    size_t allocations = BotMemory_AllocationCount() - allocationsBefore;
+    if (allocations == 0)
+    {
+        return;
+    }
+
+    g_botInterfaceThinkAllocations += allocations;
+#ifdef NDEBUG
+    if (LibVarValue("bot_developer", "0") == 0.0f)
+    {
+        return;
+    }
+#endif
+    BotInterface_Printf(PRT_WARNING,
+                         "[bot_interface] BotAI: client %d made %zu heap allocations after warm-up\n",
+                         state->client_number,
+                         allocations);
+    assert(allocations == 0);
+}
+
 static int BotAI(int client, float thinktime)
 {
     if (g_botImport == NULL)
@@ -2480,7 +2758,12 @@ static int BotAI(int client, float thinktime)
         return BLERR_AICLIENTNOTSETUP;
     }
 
-    return BotAI_Think(state, thinktime);
+    size_t allocations = BotMemory_AllocationCount();
+    AAS_SetTravelMemo(&state->travel_memo);
+    int status = BotAI_Think(state, thinktime);
+    AAS_SetTravelMemo(NULL);
+    BotAI_CheckAllocations(state, allocations);
+    return status;
 }
 
 static int BotConsoleMessage(int client, int type, char *message)
@@ -3150,6 +3433,44 @@ static void BotInterface_BotMoveToGoal(bot_moveresult_t *result,
     BotMoveToGoal(result, movestate, goal, travelflags);
 }
 
+static void BotInterface_BotMoveToGoalBatch(bot_moveresult_t *results,
+                                            const int *movestates,
+                                            const bot_goal_t *goals,
+                                            const int *travelflags,
+                                            int count)
+{
+    if (!BotInterface_EnsureLibraryReady("BotMoveToGoalBatch"))
+    {
+        if (results != NULL && count > 0)
+        {
+            memset(results, 0, (size_t)count * sizeof(*results));
+        }
+        return;
+    }
+
+    BotMoveToGoalBatch(results, movestates, goals, travelflags, count);
+}
+
+static void BotInterface_BotAddReachPenalty(int reachnum, int cost, float duration)
+{
+    if (!BotInterface_EnsureLibraryReady("BotAddReachPenalty"))
+    {
+        return;
+    }
+
+    BotMove_AddReachPenalty(reachnum, cost, duration);
+}
+
+static void BotInterface_BotAddAreaPenalty(int areanum, int cost, float duration)
+{
+    if (!BotInterface_EnsureLibraryReady("BotAddAreaPenalty"))
+    {
+        return;
+    }
+
+    BotMove_AddAreaPenalty(areanum, cost, duration);
+}
+
 static int BotInterface_BotMoveInDirection(int movestate, const vec3_t dir, float speed, int type)
 {
     if (!BotInterface_EnsureLibraryReady("BotMoveInDirection"))
@@ -3482,6 +3803,9 @@ GLADIATOR_API bot_export_t *GetBotAPI(bot_import_t *import)
     exportTable.BotEnterChat = BotInterface_BotEnterChat;
     exportTable.BotReplyChat = BotInterface_BotReplyChat;
     exportTable.BotChatLength = BotInterface_BotChatLength;
+    exportTable.BotMoveToGoalBatch = BotInterface_BotMoveToGoalBatch;
+    exportTable.BotAddReachPenalty = BotInterface_BotAddReachPenalty;
+    exportTable.BotAddAreaPenalty = BotInterface_BotAddAreaPenalty;
 
     return &exportTable;
 }
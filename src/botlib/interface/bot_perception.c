@@ -0,0 +1,369 @@
+#include "bot_perception.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BOT_PERCEPTION_LOS_CACHE_SIZE 1024 /* power of two */
+#define BOT_PERCEPTION_LOS_QUANTUM 8.0f    /* eye positions closer than this share a trace */
+
+/*
+ * Line-of-sight results for the current frame, keyed by the viewer's eye
+ * cell and the target entity, so every viewer whose eye falls in the same
+ * cell shares the trace to a target.  Targets are traced to their eyes, so a
+ * target looking back from its eye finds the entry under the viewer's cell
+ * and its own number.  Entries from older frames are ignored through the
+ * frame stamp.
+ */
+typedef struct bot_perception_los_entry_s
+{
+    unsigned int frame;
+    int cell[3];
+    int target;
+    bool visible;
+} bot_perception_los_entry_t;
+
+#define BOT_PERCEPTION_CLIENTGRID_CELL 512.0f
+#define BOT_PERCEPTION_CLIENTGRID_BUCKETS 256 /* power of two */
+
+/*
+ * Client origins bucketed by a coarse horizontal grid so enemy searches only
+ * visit clients near the bot.  Cells are hashed into a fixed bucket array,
+ * which bounds the memory however large the map is; a bucket may therefore
+ * hold clients from distant cells and callers still test the real distance.
+ * Rebuilt on the first query of each frame, after the entity updates.
+ */
+typedef struct bot_perception_clientgrid_s
+{
+    unsigned int frame;
+    bool built;
+    int numclients; /* clients linked, the max_clients of the rebuild */
+    int heads[BOT_PERCEPTION_CLIENTGRID_BUCKETS];
+    int next[BOT_PERCEPTION_MAX_CLIENTS];
+    unsigned int visited[BOT_PERCEPTION_CLIENTGRID_BUCKETS];
+    unsigned int querystamp;
+} bot_perception_clientgrid_t;
+
+static bot_perception_los_entry_t g_perceptionLOSCache[BOT_PERCEPTION_LOS_CACHE_SIZE];
+static unsigned int g_perceptionLOSFrame = 0;
+static int g_perceptionLOSCount = 0;
+static int g_perceptionFrameTraces = 0;
+static bot_perception_clientgrid_t g_perceptionClientGrid;
+
+void BotPerception_BeginFrame(void)
+{
+    g_perceptionLOSFrame += 1U;
+    if (g_perceptionLOSFrame == 0U)
+    {
+        memset(g_perceptionLOSCache, 0, sizeof(g_perceptionLOSCache));
+        g_perceptionLOSFrame = 1U;
+    }
+    g_perceptionLOSCount = 0;
+    g_perceptionFrameTraces = 0;
+}
+
+int BotPerception_FrameTraces(void)
+{
+    return g_perceptionFrameTraces;
+}
+
+static void BotPerception_LineOfSightCell(const vec3_t point, int cell[3])
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        cell[axis] = (int)floorf(point[axis] * (1.0f / BOT_PERCEPTION_LOS_QUANTUM));
+    }
+}
+
+/*
+ * Finds the entry for the segment from cell to target's eye.  On a miss the
+ * slot it would go in is returned through free_slot.
+ */
+static const bot_perception_los_entry_t *BotPerception_FindLineOfSight(const int cell[3], int target, int *free_slot)
+{
+    unsigned int hash = (unsigned int)target * 2654435761u;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        hash = (hash ^ (unsigned int)cell[axis]) * 16777619u;
+    }
+
+    int slot = (int)(hash & (BOT_PERCEPTION_LOS_CACHE_SIZE - 1));
+    while (g_perceptionLOSFrame != 0U && g_perceptionLOSCache[slot].frame == g_perceptionLOSFrame)
+    {
+        const bot_perception_los_entry_t *entry = &g_perceptionLOSCache[slot];
+        if (entry->target == target && memcmp(entry->cell, cell, sizeof(entry->cell)) == 0)
+        {
+            return entry;
+        }
+        slot = (slot + 1) & (BOT_PERCEPTION_LOS_CACHE_SIZE - 1);
+    }
+
+    *free_slot = slot;
+    return NULL;
+}
+
+bool BotPerception_HasLineOfSight(const vec3_t from,
+                                  const vec3_t to,
+                                  int viewer,
+                                  int target,
+                                  bot_perception_trace_t trace)
+{
+    if (from == NULL || to == NULL || trace == NULL)
+    {
+        return false;
+    }
+
+    int cell[3];
+    int slot = 0;
+    BotPerception_LineOfSightCell(from, cell);
+    const bot_perception_los_entry_t *entry = BotPerception_FindLineOfSight(cell, target, &slot);
+    if (entry != NULL)
+    {
+        return entry->visible;
+    }
+
+    /* the same segment seen from the target's end */
+    int reverse_cell[3];
+    int reverse_slot = 0;
+    BotPerception_LineOfSightCell(to, reverse_cell);
+    entry = BotPerception_FindLineOfSight(reverse_cell, viewer, &reverse_slot);
+    if (entry != NULL)
+    {
+        return entry->visible;
+    }
+
+    bool visible = trace(from, to, viewer, target);
+    g_perceptionFrameTraces += 1;
+
+    /* keep the table at most half full so probe runs stay short */
+    if (g_perceptionLOSFrame != 0U && g_perceptionLOSCount < BOT_PERCEPTION_LOS_CACHE_SIZE / 2)
+    {
+        bot_perception_los_entry_t *stored = &g_perceptionLOSCache[slot];
+        stored->frame = g_perceptionLOSFrame;
+        memcpy(stored->cell, cell, sizeof(stored->cell));
+        stored->target = target;
+        stored->visible = visible;
+        ++g_perceptionLOSCount;
+    }
+
+    return visible;
+}
+
+static int BotPerception_ClientGridCoord(float value)
+{
+    return (int)floorf(value * (1.0f / BOT_PERCEPTION_CLIENTGRID_CELL));
+}
+
+static int BotPerception_ClientGridBucket(int x, int y)
+{
+    unsigned int hash = (unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u;
+    return (int)(hash & (BOT_PERCEPTION_CLIENTGRID_BUCKETS - 1));
+}
+
+static void BotPerception_ClientGridRebuild(unsigned int frame, int max_clients, bot_perception_origin_t client_origin)
+{
+    bot_perception_clientgrid_t *grid = &g_perceptionClientGrid;
+    for (int bucket = 0; bucket < BOT_PERCEPTION_CLIENTGRID_BUCKETS; ++bucket)
+    {
+        grid->heads[bucket] = -1;
+    }
+
+    /* link in reverse so every bucket lists its clients in ascending order */
+    for (int ent = max_clients - 1; ent >= 0; --ent)
+    {
+        grid->next[ent] = -1;
+        const float *origin = client_origin(ent);
+        if (origin == NULL)
+        {
+            continue;
+        }
+
+        int bucket = BotPerception_ClientGridBucket(BotPerception_ClientGridCoord(origin[0]),
+                                                    BotPerception_ClientGridCoord(origin[1]));
+        grid->next[ent] = grid->heads[bucket];
+        grid->heads[bucket] = ent;
+    }
+
+    grid->frame = frame;
+    grid->numclients = max_clients;
+    grid->built = true;
+}
+
+static int BotPerception_CompareClientNumbers(const void *lhs, const void *rhs)
+{
+    return *(const int *)lhs - *(const int *)rhs;
+}
+
+int BotPerception_ClientGridQuery(const vec3_t origin,
+                                  float range,
+                                  const vec3_t apex,
+                                  const vec3_t forward,
+                                  unsigned int frame,
+                                  int max_clients,
+                                  bot_perception_origin_t client_origin,
+                                  int *clients)
+{
+    if (origin == NULL || client_origin == NULL || clients == NULL)
+    {
+        return 0;
+    }
+
+    max_clients = (max_clients < BOT_PERCEPTION_MAX_CLIENTS) ? max_clients : BOT_PERCEPTION_MAX_CLIENTS;
+    bot_perception_clientgrid_t *grid = &g_perceptionClientGrid;
+    if (!grid->built || grid->frame != frame || frame == 0U || grid->numclients != max_clients)
+    {
+        BotPerception_ClientGridRebuild(frame, max_clients, client_origin);
+    }
+
+    int minx = BotPerception_ClientGridCoord(origin[0] - range);
+    int maxx = BotPerception_ClientGridCoord(origin[0] + range);
+    int miny = BotPerception_ClientGridCoord(origin[1] - range);
+    int maxy = BotPerception_ClientGridCoord(origin[1] + range);
+
+    /*
+     * A square wider than the bucket array visits every bucket anyway and
+     * would leave a long list to sort, so hand back every linked client in
+     * order instead.
+     */
+    if ((long long)(maxx - minx + 1) * (long long)(maxy - miny + 1) > BOT_PERCEPTION_CLIENTGRID_BUCKETS)
+    {
+        int count = 0;
+        for (int ent = 0; ent < max_clients; ++ent)
+        {
+            if (client_origin(ent) != NULL)
+            {
+                clients[count++] = ent;
+            }
+        }
+        return count;
+    }
+
+    grid->querystamp += 1U;
+    if (grid->querystamp == 0U)
+    {
+        memset(grid->visited, 0, sizeof(grid->visited));
+        grid->querystamp = 1U;
+    }
+
+    float range_sq = range * range;
+    int count = 0;
+
+    for (int x = minx; x <= maxx; ++x)
+    {
+        float cellmin[2];
+        float cellmax[2];
+        cellmin[0] = (float)x * BOT_PERCEPTION_CLIENTGRID_CELL;
+        cellmax[0] = cellmin[0] + BOT_PERCEPTION_CLIENTGRID_CELL;
+        for (int y = miny; y <= maxy; ++y)
+        {
+            cellmin[1] = (float)y * BOT_PERCEPTION_CLIENTGRID_CELL;
+            cellmax[1] = cellmin[1] + BOT_PERCEPTION_CLIENTGRID_CELL;
+
+            float dist_sq = 0.0f;
+            for (int axis = 0; axis < 2; ++axis)
+            {
+                float nearest = origin[axis];
+                nearest = (nearest < cellmin[axis]) ? cellmin[axis] : nearest;
+                nearest = (nearest > cellmax[axis]) ? cellmax[axis] : nearest;
+                dist_sq += (nearest - origin[axis]) * (nearest - origin[axis]);
+            }
+            if (dist_sq > range_sq)
+            {
+                continue;
+            }
+
+            if (forward != NULL && apex != NULL)
+            {
+                /* a linear function peaks at a corner, so test only those */
+                bool ahead = false;
+                for (int corner = 0; corner < 4 && !ahead; ++corner)
+                {
+                    float dx = ((corner & 1) ? cellmax[0] : cellmin[0]) - apex[0];
+                    float dy = ((corner & 2) ? cellmax[1] : cellmin[1]) - apex[1];
+                    /* a unit of slack covers rounding for clients at the edge of the view */
+                    ahead = dx * forward[0] + dy * forward[1] >= -1.0f;
+                }
+                if (!ahead)
+                {
+                    continue;
+                }
+            }
+
+            int bucket = BotPerception_ClientGridBucket(x, y);
+            if (grid->visited[bucket] == grid->querystamp)
+            {
+                continue;
+            }
+            grid->visited[bucket] = grid->querystamp;
+
+            for (int ent = grid->heads[bucket]; ent >= 0; ent = grid->next[ent])
+            {
+                clients[count++] = ent;
+            }
+        }
+    }
+
+    qsort(clients, (size_t)count, sizeof(clients[0]), BotPerception_CompareClientNumbers);
+    return count;
+}
+
+float BotPerception_SearchInterval(float reaction, float reaction_delay, bool in_combat)
+{
+    float interval = reaction - ((reaction_delay > 0.0f) ? reaction_delay : 0.0f);
+    if (in_combat)
+    {
+        interval *= BOT_PERCEPTION_COMBAT_SCALE;
+    }
+
+    if (interval < BOT_PERCEPTION_MIN_INTERVAL)
+    {
+        interval = BOT_PERCEPTION_MIN_INTERVAL;
+    }
+    if (interval > BOT_PERCEPTION_MAX_INTERVAL)
+    {
+        interval = BOT_PERCEPTION_MAX_INTERVAL;
+    }
+    return interval;
+}
+
+bool BotPerception_SearchDue(const bot_perception_schedule_t *schedule,
+                             float now,
+                             float interval,
+                             bool under_fire,
+                             bool budget_spent)
+{
+    if (schedule == NULL || !schedule->valid || under_fire)
+    {
+        return true;
+    }
+
+    /* a schedule far in the future belongs to an earlier map, whose clock has restarted */
+    if (schedule->next_time - now > BOT_PERCEPTION_MAX_INTERVAL)
+    {
+        return true;
+    }
+
+    if (now < schedule->next_time)
+    {
+        return false;
+    }
+
+    return !budget_spent || now >= schedule->next_time + interval;
+}
+
+void BotPerception_ScheduleSearch(bot_perception_schedule_t *schedule, int client, float now, float interval)
+{
+    if (schedule == NULL)
+    {
+        return;
+    }
+
+    float delay = interval;
+    if (!schedule->valid)
+    {
+        delay *= (float)((client & 3) + 1) * 0.25f;
+    }
+
+    schedule->valid = true;
+    schedule->next_time = now + delay;
+}
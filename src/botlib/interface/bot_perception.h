@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "shared/q_shared.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Traces the segment from an eye position to a target point and answers
+ * whether nothing but the target blocks it.
+ */
+typedef bool (*bot_perception_trace_t)(const vec3_t from, const vec3_t to, int viewer, int target);
+
+/*
+ * Starts a new server frame: line-of-sight results from earlier frames are
+ * dropped and the frame's trace count restarts.  Until the first call no
+ * result is cached.
+ */
+void BotPerception_BeginFrame(void);
+
+/* traces run through BotPerception_HasLineOfSight since the frame began */
+int BotPerception_FrameTraces(void);
+
+/*
+ * Line of sight between viewer's eye at from and target's eye at to, shared
+ * for the rest of the frame by every viewer whose eye falls in the same cell,
+ * and by the target looking back at a viewer in that cell.  Misses call
+ * trace.
+ */
+bool BotPerception_HasLineOfSight(const vec3_t from,
+                                  const vec3_t to,
+                                  int viewer,
+                                  int target,
+                                  bot_perception_trace_t trace);
+
+/*
+ * Perception scheduler.  A full enemy search costs a trace per candidate,
+ * yet a bot cannot act on what it sees faster than its reaction time, so
+ * each bot searches once per reaction time while idle and four times as
+ * often while it holds a visible enemy.  The deathmatch layer already holds
+ * fire for its own reaction delay after an enemy is first sighted, and that
+ * delay is taken out of the interval so the two do not add up to twice the
+ * character's reaction time.  Losing health forces a search at once.  When
+ * the frame's trace budget is spent, due searches slip to a later frame, but
+ * never by more than one interval.  Between searches the bot keeps its last
+ * enemy and extrapolates its position.
+ */
+#define BOT_PERCEPTION_MIN_INTERVAL 0.05f
+#define BOT_PERCEPTION_MAX_INTERVAL 1.0f
+#define BOT_PERCEPTION_COMBAT_SCALE 0.25f
+
+typedef struct bot_perception_schedule_s
+{
+    bool valid;      /* a search has run since the bot was set up */
+    float next_time; /* when the next search falls due */
+} bot_perception_schedule_t;
+
+/*
+ * Seconds between searches for a character with the given reaction time,
+ * less the reaction delay the attack code adds after a sighting.
+ */
+float BotPerception_SearchInterval(float reaction, float reaction_delay, bool in_combat);
+
+/*
+ * Whether a search should run at now.  budget_spent reports that the
+ * frame's trace budget is used up.
+ */
+bool BotPerception_SearchDue(const bot_perception_schedule_t *schedule,
+                             float now,
+                             float interval,
+                             bool under_fire,
+                             bool budget_spent);
+
+/*
+ * Records a search run at now.  The first search of each bot is followed
+ * by a shorter wait that depends on its client number, so bots added
+ * together do not stay in step.
+ */
+void BotPerception_ScheduleSearch(bot_perception_schedule_t *schedule, int client, float now, float interval);
+
+#define BOT_PERCEPTION_MAX_CLIENTS 1024
+
+/* origin of client ent, or NULL when it has no snapshot this frame */
+typedef const float *(*bot_perception_origin_t)(int ent);
+
+/*
+ * Collects, in ascending order, the clients below max_clients that may lie
+ * within range of origin; callers still test the real distance.  With
+ * forward set, clients wholly behind the vertical plane through apex may be
+ * left out too, which is only safe for searches whose field of view is at
+ * most 180 degrees.  The client positions are read through client_origin
+ * once per frame, on the first query whose frame differs from the last;
+ * frame 0 reads them on every query.  clients must hold max_clients entries.
+ */
+int BotPerception_ClientGridQuery(const vec3_t origin,
+                                  float range,
+                                  const vec3_t apex,
+                                  const vec3_t forward,
+                                  unsigned int frame,
+                                  int max_clients,
+                                  bot_perception_origin_t client_origin,
+                                  int *clients);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -32,6 +32,9 @@ static void BotState_ResetCombat(bot_combat_state_t *combat)
     combat->took_damage = false;
     VectorClear(combat->last_enemy_origin);
     VectorClear(combat->last_enemy_velocity);
+    combat->perception.valid = false;
+    combat->perception.next_time = -FLT_MAX;
+    combat->perceived.entity = -1;
 }
 
 static void BotState_FreeResources(bot_client_state_t *state)
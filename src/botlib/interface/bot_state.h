@@ -3,6 +3,7 @@
 #include <stdbool.h>
 
 #include "q2bridge/botlib.h"
+#include "botlib/aas/aas_local.h"
 #include "botlib/ai_character/bot_character.h"
 #include "botlib/ai_chat/ai_chat.h"
 #include "botlib/ai_weapon/bot_weapon.h"
@@ -11,6 +12,7 @@
 #include "botlib/ai_move/bot_move.h"
 #include "botlib/ai_goal/bot_goal.h"
 #include "botlib/ai/ai_dm.h"
+#include "bot_perception.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,6 +51,9 @@ typedef struct bot_combat_state_s
     float last_damage_time;
     bool last_health_valid;
     bool took_damage;
+    /* last full enemy search, reused until the perception scheduler runs it again */
+    bot_perception_schedule_t perception;
+    ai_dm_enemy_info_t perceived;
 } bot_combat_state_t;
 
 struct bot_client_state_s {
@@ -79,6 +84,8 @@ struct bot_client_state_s {
     float goal_avoid_duration;
     int active_goal_number;
     bot_combat_state_t combat;
+    int think_frames;
+    aas_travelmemo_t travel_memo;
 };
 
 bot_client_state_t *BotState_Get(int client);
@@ -93,6 +93,11 @@ bool BotLibraryInitialized(void);
  */
 const botlib_library_variables_t *BotInterface_GetLibraryVariables(void);
 
+/**
+ * Botlib heap allocations made by BotAI calls after the bots warmed up.
+ */
+size_t BotInterface_ThinkAllocations(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -290,6 +290,13 @@ typedef struct bot_export_s {
     void (*BotEnterChat)(bot_chatstate_t *state, int client, int sendto);
     int (*BotReplyChat)(bot_chatstate_t *state, const char *message, unsigned long context);
     int (*BotChatLength)(const char *message);
+    void (*BotMoveToGoalBatch)(bot_moveresult_t *results,
+                               const int *movestates,
+                               const bot_goal_t *goals,
+                               const int *travelflags,
+                               int count);
+    void (*BotAddReachPenalty)(int reachnum, int cost, float duration);
+    void (*BotAddAreaPenalty)(int areanum, int cost, float duration);
 } bot_export_t;
 
 // Bot library imported functions
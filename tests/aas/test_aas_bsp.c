@@ -0,0 +1,597 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdbool.h>
+
+#include "botlib/aas/aas_local.h"
+#include "botlib/aas/aas_map.h"
+#include "q2bridge/botlib.h"
+
+#ifndef PROJECT_SOURCE_DIR
+#error "PROJECT_SOURCE_DIR must be defined so regression tests can resolve asset paths."
+#endif
+
+#define TEST_BSP_PATH PROJECT_SOURCE_DIR "/dev_tools/assets/maps/2box4.bsp"
+#define TEST_BSP_SEGMENTS 2000
+
+/*
+ * Reference sweep for a point trace: clip the segment against every brush
+ * independently, ignoring the node tree.  The engine trace walks the same
+ * brushes through the tree, so both must agree on the first hit.
+ */
+static float reference_point_trace(const vec3_t start,
+                                   const vec3_t end,
+                                   int contentmask,
+                                   bool *startsolid,
+                                   const cplane_t **hitplane)
+{
+    float best = 1.0f;
+    *startsolid = false;
+    *hitplane = NULL;
+
+    for (int b = 0; b < bspworld.numBrushes; ++b)
+    {
+        const aas_bspbrush_t *brush = &bspworld.brushes[b];
+        if (!(brush->contents & contentmask) || brush->numsides <= 0)
+        {
+            continue;
+        }
+
+        float enter = 0.0f;
+        float leave = 1.0f;
+        const cplane_t *enterplane = NULL;
+        bool inside = true;
+        bool miss = false;
+        for (int s = 0; s < brush->numsides && !miss; ++s)
+        {
+            const cplane_t *plane = bspworld.brushsides[brush->firstside + s].plane;
+            float d1 = DotProduct(start, plane->normal) - plane->dist;
+            float d2 = DotProduct(end, plane->normal) - plane->dist;
+            if (d1 > 0.0f)
+            {
+                inside = false;
+            }
+            if (d1 > 0.0f && d2 > 0.0f)
+            {
+                miss = true;
+            }
+            else if (d1 > 0.0f)
+            {
+                float f = d1 / (d1 - d2);
+                if (f > enter)
+                {
+                    enter = f;
+                    enterplane = plane;
+                }
+            }
+            else if (d2 > 0.0f)
+            {
+                float f = d1 / (d1 - d2);
+                leave = (f < leave) ? f : leave;
+            }
+        }
+
+        if (miss)
+        {
+            continue;
+        }
+        if (inside)
+        {
+            *startsolid = true;
+            continue;
+        }
+        if (enter < leave && enter < best)
+        {
+            best = enter;
+            *hitplane = enterplane;
+        }
+    }
+
+    return best;
+}
+
+/* Distance from point to the closest brush, zero or negative when inside. */
+static float distance_to_nearest_brush(const vec3_t point, int contentmask)
+{
+    float nearest = 99999.0f;
+    for (int b = 0; b < bspworld.numBrushes; ++b)
+    {
+        const aas_bspbrush_t *brush = &bspworld.brushes[b];
+        if (!(brush->contents & contentmask) || brush->numsides <= 0)
+        {
+            continue;
+        }
+
+        float outside = -99999.0f;
+        for (int s = 0; s < brush->numsides; ++s)
+        {
+            const cplane_t *plane = bspworld.brushsides[brush->firstside + s].plane;
+            float d = DotProduct(point, plane->normal) - plane->dist;
+            outside = (d > outside) ? d : outside;
+        }
+        nearest = (outside < nearest) ? outside : nearest;
+    }
+
+    return nearest;
+}
+
+static uint32_t test_random(uint32_t *seed)
+{
+    *seed = *seed * 1664525U + 1013904223U;
+    return *seed >> 8;
+}
+
+static float test_random_range(uint32_t *seed, float lo, float hi)
+{
+    return lo + (hi - lo) * (float)(test_random(seed) & 0xFFFFU) / 65535.0f;
+}
+
+/*
+ * The world model bounds in the fixture are inflated, so sample inside the
+ * axial brush faces instead, ignoring anything beyond the Quake II limits.
+ */
+static void brush_bounds(vec3_t mins, vec3_t maxs)
+{
+    VectorSet(mins, 99999.0f, 99999.0f, 99999.0f);
+    VectorSet(maxs, -99999.0f, -99999.0f, -99999.0f);
+    for (int s = 0; s < bspworld.numBrushSides; ++s)
+    {
+        const cplane_t *plane = bspworld.brushsides[s].plane;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float value = 0.0f;
+            if (plane->normal[axis] == 1.0f)
+            {
+                value = plane->dist;
+            }
+            else if (plane->normal[axis] == -1.0f)
+            {
+                value = -plane->dist;
+            }
+            else
+            {
+                continue;
+            }
+            if (fabsf(value) > 4096.0f)
+            {
+                continue;
+            }
+            mins[axis] = (value < mins[axis]) ? value : mins[axis];
+            maxs[axis] = (value > maxs[axis]) ? value : maxs[axis];
+        }
+    }
+}
+
+static int bsp_setup(void **state)
+{
+    (void)state;
+
+    FILE *file = fopen(TEST_BSP_PATH, "rb");
+    if (file == NULL)
+    {
+        print_message("bsp trace tests skipped: missing %s\n", TEST_BSP_PATH);
+        return 0;
+    }
+    fclose(file);
+
+    assert_int_equal(AAS_LoadBSPCollision(TEST_BSP_PATH), BLERR_NOERROR);
+    return 0;
+}
+
+static int bsp_teardown(void **state)
+{
+    (void)state;
+    AAS_BSPClearCollision();
+    return 0;
+}
+
+static void test_bsp_collision_loads(void **state)
+{
+    (void)state;
+    if (!AAS_BSPCollisionLoaded())
+    {
+        skip();
+    }
+
+    assert_true(bspworld.numPlanes > 0);
+    assert_true(bspworld.numNodes > 0);
+    assert_true(bspworld.numLeafs > 0);
+    assert_true(bspworld.numBrushes > 0);
+    assert_true(bspworld.numModels >= 1);
+
+    /* leaf 0 is the shared solid leaf in every Quake II map */
+    assert_true(bspworld.leafs[0].contents & CONTENTS_SOLID);
+}
+
+static void test_bsp_point_trace_matches_brush_reference(void **state)
+{
+    (void)state;
+    if (!AAS_BSPCollisionLoaded())
+    {
+        skip();
+    }
+
+    vec3_t worldmins;
+    vec3_t worldmaxs;
+    brush_bounds(worldmins, worldmaxs);
+    uint32_t seed = 0x2b0c4u;
+    int hits = 0;
+    int compared = 0;
+
+    for (int i = 0; i < TEST_BSP_SEGMENTS; ++i)
+    {
+        vec3_t start;
+        vec3_t end;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            start[axis] = test_random_range(&seed, worldmins[axis], worldmaxs[axis]);
+            end[axis] = test_random_range(&seed, worldmins[axis], worldmaxs[axis]);
+        }
+
+        bool refStartSolid = false;
+        const cplane_t *refPlane = NULL;
+        float reference = reference_point_trace(start, end, MASK_SOLID, &refStartSolid, &refPlane);
+        bsp_trace_t trace = AAS_BSPTrace(start, NULL, NULL, end, -1, MASK_SOLID);
+
+        if (refStartSolid)
+        {
+            assert_true(trace.startsolid);
+            continue;
+        }
+
+        vec3_t delta;
+        VectorSubtract(end, start, delta);
+        if (DotProduct(delta, delta) < 1.0f)
+        {
+            continue;
+        }
+
+        /*
+         * The engine backs off DIST_EPSILON along the plane normal, which can
+         * be a long way along a grazing segment, so distances are compared
+         * along the hit plane rather than along the segment.
+         */
+        if (reference < 1.0f)
+        {
+            /* never tunnel through a brush the reference hit */
+            float approach = fabsf(DotProduct(delta, refPlane->normal));
+            assert_true((trace.fraction - reference) * approach <= 0.1f);
+        }
+
+        if (trace.fraction < reference)
+        {
+            /* early stops only happen when the segment grazes a brush */
+            vec3_t stop;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                stop[axis] = start[axis] + trace.fraction * delta[axis];
+            }
+            assert_true(distance_to_nearest_brush(stop, MASK_SOLID) <= 0.1f);
+        }
+        assert_int_equal(trace.ent, 0);
+
+        if (trace.fraction < 1.0f)
+        {
+            ++hits;
+            assert_true(trace.contents & MASK_SOLID);
+            assert_true(DotProduct(trace.plane.normal, delta) < 0.0f);
+        }
+        ++compared;
+    }
+
+    assert_true(compared > TEST_BSP_SEGMENTS / 4);
+    assert_true(hits > 0);
+}
+
+static void test_bsp_box_trace_stops_before_point_trace(void **state)
+{
+    (void)state;
+    if (!AAS_BSPCollisionLoaded())
+    {
+        skip();
+    }
+
+    vec3_t worldmins;
+    vec3_t worldmaxs;
+    brush_bounds(worldmins, worldmaxs);
+    vec3_t mins = {-16.0f, -16.0f, -24.0f};
+    vec3_t maxs = {16.0f, 16.0f, 32.0f};
+    uint32_t seed = 0x51ab3u;
+
+    for (int i = 0; i < TEST_BSP_SEGMENTS; ++i)
+    {
+        vec3_t start;
+        vec3_t end;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            start[axis] = test_random_range(&seed, worldmins[axis], worldmaxs[axis]);
+            end[axis] = test_random_range(&seed, worldmins[axis], worldmaxs[axis]);
+        }
+
+        bsp_trace_t point = AAS_BSPTrace(start, NULL, NULL, end, -1, MASK_PLAYERSOLID);
+        bsp_trace_t box = AAS_BSPTrace(start, mins, maxs, end, -1, MASK_PLAYERSOLID);
+        if (point.startsolid)
+        {
+            assert_true(box.startsolid);
+            continue;
+        }
+        if (box.startsolid)
+        {
+            continue;
+        }
+
+        /* a box around the swept point cannot travel further than the point */
+        if (point.fraction < 1.0f)
+        {
+            vec3_t delta;
+            VectorSubtract(end, start, delta);
+            float approach = fabsf(DotProduct(delta, point.plane.normal));
+            assert_true((box.fraction - point.fraction) * approach <= 0.1f);
+        }
+
+        if (box.fraction < 1.0f)
+        {
+            /* the reported end position must itself be a valid box position */
+            bsp_trace_t settle = AAS_BSPTrace(box.endpos, mins, maxs, box.endpos, -1, MASK_PLAYERSOLID);
+            assert_false(settle.allsolid);
+        }
+    }
+}
+
+static void test_bsp_point_contents_agrees_with_trace(void **state)
+{
+    (void)state;
+    if (!AAS_BSPCollisionLoaded())
+    {
+        skip();
+    }
+
+    vec3_t worldmins;
+    vec3_t worldmaxs;
+    brush_bounds(worldmins, worldmaxs);
+    uint32_t seed = 0x7f00du;
+    vec3_t zero = {0.0f, 0.0f, 0.0f};
+
+    for (int i = 0; i < TEST_BSP_SEGMENTS; ++i)
+    {
+        vec3_t point;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            point[axis] = test_random_range(&seed, worldmins[axis], worldmaxs[axis]);
+        }
+
+        bsp_trace_t trace = AAS_BSPTrace(point, zero, zero, point, -1, CONTENTS_SOLID);
+        if (trace.allsolid)
+        {
+            assert_true(AAS_BSPPointContents(point) & CONTENTS_SOLID);
+        }
+    }
+}
+
+/*
+ * The PVS may let hidden pairs through but must never reject a pair with a
+ * clear line between them.  Random segments mostly end in solid, so collect
+ * an open point per cluster and test every pair of those instead.
+ */
+static void test_bsp_pvs_never_rejects_clear_segments(void **state)
+{
+    (void)state;
+    if (!AAS_BSPCollisionLoaded())
+    {
+        skip();
+    }
+
+    assert_non_null(bspworld.pvs);
+    assert_true(bspworld.numClusters > 1);
+    assert_true(AAS_BSPClustersInPVS(-1, 0));
+
+    vec3_t worldmins;
+    vec3_t worldmaxs;
+    brush_bounds(worldmins, worldmaxs);
+    uint32_t seed = 0x915u;
+
+    enum { MAX_TEST_CLUSTERS = 256 };
+    vec3_t samples[MAX_TEST_CLUSTERS];
+    int sampled[MAX_TEST_CLUSTERS];
+    int numSamples = 0;
+    bool seen[MAX_TEST_CLUSTERS] = {false};
+    assert_true(bspworld.numClusters <= MAX_TEST_CLUSTERS);
+
+    for (int i = 0; i < TEST_BSP_SEGMENTS * 10; ++i)
+    {
+        vec3_t point;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            point[axis] = test_random_range(&seed, worldmins[axis], worldmaxs[axis]);
+        }
+
+        int cluster = AAS_BSPPointCluster(point);
+        if (cluster < 0 || seen[cluster])
+        {
+            continue;
+        }
+        seen[cluster] = true;
+        sampled[numSamples] = cluster;
+        VectorCopy(point, samples[numSamples]);
+        ++numSamples;
+    }
+    assert_true(numSamples > 1);
+
+    int rejected = 0;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        assert_true(AAS_BSPClustersInPVS(sampled[i], sampled[i]));
+        for (int j = 0; j < numSamples; ++j)
+        {
+            if (AAS_BSPInPVS(samples[i], samples[j]))
+            {
+                continue;
+            }
+
+            bsp_trace_t trace = AAS_BSPTrace(samples[i], NULL, NULL, samples[j], -1, CONTENTS_SOLID);
+            assert_true(trace.fraction < 1.0f);
+            ++rejected;
+        }
+    }
+
+    assert_true(rejected > 0);
+}
+
+static void set_box_entity(int entnum, int solid, float x)
+{
+    AASEntityFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.number = entnum;
+    frame.solid = solid;
+    VectorSet(frame.origin, x, 0.0f, 64.0f);
+    VectorSet(frame.mins, -16.0f, -16.0f, -24.0f);
+    VectorSet(frame.maxs, 16.0f, 16.0f, 32.0f);
+    frame.bounds_dirty = true;
+    frame.origin_dirty = true;
+    assert_int_equal(AAS_UpdateEntity(entnum, &frame), BLERR_NOERROR);
+}
+
+static void test_bsp_trace_walks_only_solid_entities(void **state)
+{
+    (void)state;
+    if (!AAS_BSPCollisionLoaded())
+    {
+        skip();
+    }
+
+    /* one area spanning the map so entities get linked */
+    aasworld.loaded = qtrue;
+    aasworld.numAreas = 1;
+    aasworld.areas = calloc(2, sizeof(aas_area_t));
+    assert_non_null(aasworld.areas);
+    aasworld.areas[1].areanum = 1;
+    VectorSet(aasworld.areas[1].mins, -4096.0f, -4096.0f, -4096.0f);
+    VectorSet(aasworld.areas[1].maxs, 4096.0f, 4096.0f, 4096.0f);
+
+    vec3_t start = {-96.0f, 0.0f, 64.0f};
+    vec3_t end = {96.0f, 0.0f, 64.0f};
+    assert_true(AAS_BSPTrace(start, NULL, NULL, end, -1, MASK_PLAYERSOLID).fraction == 1.0f);
+
+    for (int entnum = 1; entnum <= 32; ++entnum)
+    {
+        set_box_entity(entnum, SOLID_NOT, 0.0f);
+    }
+    set_box_entity(40, SOLID_BBOX, 0.0f);
+    assert_int_equal(aasworld.numBoxEntities, 1);
+    assert_int_equal(aasworld.numMoverEntities, 0);
+
+    bsp_trace_t trace = AAS_BSPTrace(start, NULL, NULL, end, -1, MASK_PLAYERSOLID);
+    assert_int_equal(trace.ent, 40);
+    assert_true(fabsf(trace.endpos[0] + 16.0f) < 0.1f);
+
+    /* the passent and masks without CONTENTS_MONSTER skip the box */
+    assert_true(AAS_BSPTrace(start, NULL, NULL, end, 40, MASK_PLAYERSOLID).fraction == 1.0f);
+    assert_true(AAS_BSPTrace(start, NULL, NULL, end, -1, MASK_SOLID).fraction == 1.0f);
+
+    /* a second box keeps the list compact when the first one leaves it */
+    set_box_entity(41, SOLID_BBOX, 48.0f);
+    set_box_entity(40, SOLID_NOT, 0.0f);
+    assert_int_equal(aasworld.numBoxEntities, 1);
+    assert_int_equal(aasworld.boxEntities[0], 41);
+    assert_int_equal(aasworld.entities[41].collisionSlot, 0);
+    trace = AAS_BSPTrace(start, NULL, NULL, end, -1, MASK_PLAYERSOLID);
+    assert_int_equal(trace.ent, 41);
+
+    assert_int_equal(AAS_UpdateEntity(41, NULL), BLERR_NOERROR);
+    assert_int_equal(aasworld.numBoxEntities, 0);
+    assert_true(AAS_BSPTrace(start, NULL, NULL, end, -1, MASK_PLAYERSOLID).fraction == 1.0f);
+
+    AAS_Shutdown();
+}
+
+/*
+ * The fixture has a floor at z = 16 around the origin and a raised block
+ * with its top at z = 128 around y = -256.  Player origins sit 24 units
+ * above the surface they stand on.
+ */
+static void test_predict_drop_lands_on_floor(void **state)
+{
+    (void)state;
+    if (!AAS_BSPCollisionLoaded())
+    {
+        skip();
+    }
+
+    vec3_t origin = {0.0f, 0.0f, 150.0f};
+    vec3_t zero = {0.0f, 0.0f, 0.0f};
+    aas_clientmove_t move;
+    assert_true(AAS_PredictClientMovement(&move, -1, origin, NULL, NULL, false, zero, zero, 0, 50, 0.1f, SE_HITGROUND, 0));
+    assert_int_equal(move.stopevent, SE_HITGROUND);
+    assert_float_equal(move.endpos[2], 40.03125f, 0.1f);
+    assert_false(move.events & SE_HITGROUNDDAMAGE);
+}
+
+static void test_predict_jump_returns_to_ground(void **state)
+{
+    (void)state;
+    if (!AAS_BSPCollisionLoaded())
+    {
+        skip();
+    }
+
+    vec3_t origin = {0.0f, 0.0f, 40.03125f};
+    vec3_t zero = {0.0f, 0.0f, 0.0f};
+    vec3_t jump = {0.0f, 0.0f, 300.0f};
+    aas_clientmove_t move;
+    assert_true(AAS_PredictClientMovement(&move, -1, origin, NULL, NULL, true, zero, jump, 1, 40, 0.05f, SE_HITGROUND, 0));
+
+    /* airtime is 2 * jumpvel / gravity with the default physics */
+    assert_float_equal(move.time, 2.0f * 224.0f / 800.0f, 0.06f);
+    assert_float_equal(move.endpos[2], origin[2], 0.1f);
+    assert_false(move.events & SE_LEAVEGROUND);
+}
+
+static void test_predict_walk_off_ledge(void **state)
+{
+    (void)state;
+    if (!AAS_BSPCollisionLoaded())
+    {
+        skip();
+    }
+
+    vec3_t origin = {0.0f, -256.0f, 152.03125f};
+    vec3_t zero = {0.0f, 0.0f, 0.0f};
+    vec3_t walk = {0.0f, 300.0f, 0.0f};
+    aas_clientmove_t move;
+
+    /* walking on flat ground keeps the box at the same height */
+    assert_false(AAS_PredictClientMovement(&move, -1, origin, NULL, NULL, true, zero, walk, 1, 1, 0.1f, SE_LEAVEGROUND, 0));
+    assert_float_equal(move.endpos[1], -226.0f, 0.1f);
+    assert_float_equal(move.endpos[2], origin[2], 0.1f);
+
+    assert_true(AAS_PredictClientMovement(&move, -1, origin, NULL, NULL, true, zero, walk, 40, 40, 0.1f, SE_HITGROUND, 0));
+    assert_true(move.events & SE_LEAVEGROUND);
+    assert_true(move.endpos[1] > -180.0f);
+    assert_true(move.endpos[2] < origin[2]);
+    assert_false(move.endcontents & (CONTENTS_LAVA | CONTENTS_SLIME));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_bsp_collision_loads, bsp_setup, bsp_teardown),
+        cmocka_unit_test_setup_teardown(test_bsp_point_trace_matches_brush_reference, bsp_setup, bsp_teardown),
+        cmocka_unit_test_setup_teardown(test_bsp_box_trace_stops_before_point_trace, bsp_setup, bsp_teardown),
+        cmocka_unit_test_setup_teardown(test_bsp_point_contents_agrees_with_trace, bsp_setup, bsp_teardown),
+        cmocka_unit_test_setup_teardown(test_bsp_pvs_never_rejects_clear_segments, bsp_setup, bsp_teardown),
+        cmocka_unit_test_setup_teardown(test_bsp_trace_walks_only_solid_entities, bsp_setup, bsp_teardown),
+        cmocka_unit_test_setup_teardown(test_predict_drop_lands_on_floor, bsp_setup, bsp_teardown),
+        cmocka_unit_test_setup_teardown(test_predict_jump_returns_to_ground, bsp_setup, bsp_teardown),
+        cmocka_unit_test_setup_teardown(test_predict_walk_off_ledge, bsp_setup, bsp_teardown),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -15,6 +15,12 @@
 #define chdir _chdir
 #define getcwd _getcwd
 #define unlink _unlink
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #endif
 
 #ifndef PATH_MAX
@@ -307,6 +313,304 @@ static void assert_travel_time_for_area(int areanum, unsigned short expected_tim
     assert_true(matched);
 }
 
+/*
+ * Synthetic worlds: tests that only need a handful of hand-built areas use
+ * this setup so they run without the test_nav assets.
+ */
+static int aas_synthetic_setup(void **state)
+{
+    (void)state;
+
+    BotInterface_SetImportTable(&g_test_imports);
+    LibVar_Init();
+    if (!BotMemory_Init(TEST_BOTLIB_HEAP_SIZE)) {
+        return -1;
+    }
+
+    memset(&aasworld, 0, sizeof(aasworld));
+    return 0;
+}
+
+static void synthetic_world_release(void)
+{
+    AAS_ClearAreaOverlaps();
+    AAS_ClearReachabilityData();
+    if (aasworld.sharedData) {
+        aasworld.areas = NULL;
+        aasworld.areasettings = NULL;
+        aasworld.reachability = NULL;
+        aasworld.nodes = NULL;
+        aasworld.planes = NULL;
+    }
+    AAS_SharedWorldDetach();
+
+    free(aasworld.areas);
+    free(aasworld.areasettings);
+    free(aasworld.reachability);
+    free(aasworld.nodes);
+    free(aasworld.planes);
+    memset(&aasworld, 0, sizeof(aasworld));
+}
+
+static int aas_synthetic_teardown(void **state)
+{
+    (void)state;
+
+    synthetic_world_release();
+    BotMemory_Shutdown();
+    LibVar_Shutdown();
+    BotInterface_SetImportTable(NULL);
+    return 0;
+}
+
+/*
+ * Allocates count areas numbered from 1.  Like a loaded file, the area
+ * count includes the unused area 0; the area scans run through numAreas
+ * inclusive, so one spare entry with an empty box closes the array.
+ */
+static void synthetic_world_alloc(int count)
+{
+    aasworld.numAreas = count + 1;
+    aasworld.areas = (aas_area_t *)calloc((size_t)count + 2U, sizeof(aas_area_t));
+    aasworld.numAreaSettings = aasworld.numAreas;
+    aasworld.areasettings = (aas_areasettings_t *)calloc((size_t)count + 1U, sizeof(aas_areasettings_t));
+    assert_non_null(aasworld.areas);
+    assert_non_null(aasworld.areasettings);
+
+    aas_area_t *spare = &aasworld.areas[count + 1];
+    VectorSet(spare->mins, 1.0f, 1.0f, 1.0f);
+    VectorSet(spare->maxs, -1.0f, -1.0f, -1.0f);
+    aasworld.loaded = qtrue;
+}
+
+static void synthetic_world_set_box(int area, float minx, float maxx, float half_height)
+{
+    aas_area_t *entry = &aasworld.areas[area];
+    entry->areanum = area;
+    VectorSet(entry->mins, minx, -half_height, -half_height);
+    VectorSet(entry->maxs, maxx, half_height, half_height);
+    VectorSet(entry->center, 0.5f * (minx + maxx), 0.0f, 0.0f);
+}
+
+/* Gives every area the outgoing reachabilities listed in links[area]. */
+static void synthetic_world_link(int count, int links[][4], const int *numlinks)
+{
+    int total = 0;
+    for (int area = 1; area <= count; ++area) {
+        total += numlinks[area];
+    }
+
+    aasworld.numReachability = total;
+    aasworld.reachability = (aas_reachability_t *)calloc((size_t)total + 1U, sizeof(aas_reachability_t));
+    assert_non_null(aasworld.reachability);
+
+    int index = 0;
+    for (int area = 1; area <= count; ++area) {
+        aasworld.areasettings[area].firstreachablearea = index;
+        aasworld.areasettings[area].numreachableareas = numlinks[area];
+        for (int link = 0; link < numlinks[area]; ++link) {
+            aasworld.reachability[index].areanum = links[area][link];
+            aasworld.reachability[index].traveltype = TRAVEL_WALK;
+            index++;
+        }
+    }
+
+    assert_int_equal(AAS_PrepareReachability(), BLERR_NOERROR);
+}
+
+/* Builds a row of boxes, area n spanning [n*64, n*64+64] along x. */
+static void synthetic_world_build_row(int count)
+{
+    synthetic_world_alloc(count);
+    for (int area = 1; area <= count; ++area) {
+        synthetic_world_set_box(area, (float)(area * 64), (float)(area * 64 + 64), 32.0f);
+    }
+}
+
+/*
+ * Node tree for a row: node n splits at the far side of area n along x,
+ * with area n behind the plane and the rest of the row in front.
+ */
+static void synthetic_world_build_tree(int count)
+{
+    aasworld.numNodes = count;
+    aasworld.nodes = (aas_node_t *)calloc((size_t)count, sizeof(aas_node_t));
+    aasworld.numPlanes = count;
+    aasworld.planes = (aas_plane_t *)calloc((size_t)count, sizeof(aas_plane_t));
+    assert_non_null(aasworld.nodes);
+    assert_non_null(aasworld.planes);
+
+    for (int node = 1; node < count; ++node) {
+        aas_plane_t *plane = &aasworld.planes[node];
+        VectorSet(plane->normal, 1.0f, 0.0f, 0.0f);
+        plane->dist = (float)(node * 64 + 64);
+        aasworld.nodes[node].planenum = node;
+        aasworld.nodes[node].children[0] = (node + 1 < count) ? node + 1 : -count;
+        aasworld.nodes[node].children[1] = -node;
+    }
+}
+
+#ifndef _WIN32
+static void shared_segment_name(char *buffer, size_t size, int bspChecksum, int aasChecksum)
+{
+    snprintf(buffer, size, "/gladiator_aas_%08x_%08x", (unsigned)bspChecksum, (unsigned)aasChecksum);
+}
+
+static bool shared_segment_exists(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return true;
+}
+
+static bool shared_segment_lock_exists(const char *name)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "/tmp%s.lock", name);
+    return access(path, F_OK) == 0;
+}
+
+/*
+ * Forks a publisher that keeps the segment until told to detach; with
+ * detach_cleanly false it exits without detaching, like a crashed server.
+ */
+static pid_t shared_segment_fork_publisher(int bspChecksum, int aasChecksum, bool detach_cleanly,
+                                           int *ready_fd, int *release_fd)
+{
+    int ready[2];
+    int release[2];
+    assert_int_equal(pipe(ready), 0);
+    assert_int_equal(pipe(release), 0);
+
+    pid_t child = fork();
+    assert_true(child >= 0);
+    if (child == 0) {
+        close(ready[0]);
+        close(release[1]);
+
+        synthetic_world_build_row(4);
+        synthetic_world_build_tree(4);
+        aasworld.bspChecksum = bspChecksum;
+        aasworld.aasChecksum = aasChecksum;
+        AAS_SharedWorldPublish();
+        char status = aasworld.sharedData ? 1 : 0;
+        if (write(ready[1], &status, 1) != 1) {
+            _exit(2);
+        }
+
+        char go = 0;
+        if (read(release[0], &go, 1) != 1) {
+            _exit(2);
+        }
+        if (!detach_cleanly) {
+            _exit(0);
+        }
+
+        char name[64];
+        shared_segment_name(name, sizeof(name), bspChecksum, aasChecksum);
+        synthetic_world_release();
+        /* the parent is still attached, so the segment must survive */
+        _exit(shared_segment_exists(name) ? 0 : 1);
+    }
+
+    close(ready[1]);
+    close(release[0]);
+    *ready_fd = ready[0];
+    *release_fd = release[1];
+    return child;
+}
+
+static void test_shared_world_outlives_publisher_detach(void **state)
+{
+    (void)state;
+
+    LibVarSet("aas_sharedmemory", "1");
+    int bspChecksum = (int)getpid();
+    int aasChecksum = 0x5a5a0001;
+    char name[64];
+    shared_segment_name(name, sizeof(name), bspChecksum, aasChecksum);
+
+    int ready_fd = -1;
+    int release_fd = -1;
+    pid_t child = shared_segment_fork_publisher(bspChecksum, aasChecksum, true, &ready_fd, &release_fd);
+
+    char published = 0;
+    assert_int_equal(read(ready_fd, &published, 1), 1);
+    assert_int_equal(published, 1);
+
+    assert_true(AAS_SharedWorldAttach(bspChecksum, aasChecksum));
+    assert_true(aasworld.sharedData);
+    assert_int_equal(aasworld.numAreas, 5);
+    assert_int_equal(aasworld.areas[3].areanum, 3);
+    assert_true(aasworld.areas[3].mins[0] == 192.0f);
+
+    /* the node tree and its planes come with the segment */
+    assert_int_equal(aasworld.numNodes, 4);
+    assert_int_equal(aasworld.nodes[3].children[0], -4);
+    assert_int_equal(aasworld.numPlanes, 4);
+    assert_true(aasworld.planes[2].dist == 192.0f);
+
+    char go = 1;
+    assert_int_equal(write(release_fd, &go, 1), 1);
+    int status = 0;
+    assert_int_equal(waitpid(child, &status, 0), child);
+    assert_true(WIFEXITED(status));
+    assert_int_equal(WEXITSTATUS(status), 0);
+
+    /* the publisher is gone but the mapping stays valid */
+    assert_int_equal(aasworld.areas[4].areanum, 4);
+
+    synthetic_world_release();
+    errno = 0;
+    assert_false(shared_segment_exists(name));
+    assert_int_equal(errno, ENOENT);
+    assert_false(shared_segment_lock_exists(name));
+
+    close(ready_fd);
+    close(release_fd);
+    LibVarSet("aas_sharedmemory", "0");
+}
+
+static void test_shared_world_survives_publisher_crash(void **state)
+{
+    (void)state;
+
+    LibVarSet("aas_sharedmemory", "1");
+    int bspChecksum = (int)getpid();
+    int aasChecksum = 0x5a5a0002;
+    char name[64];
+    shared_segment_name(name, sizeof(name), bspChecksum, aasChecksum);
+
+    int ready_fd = -1;
+    int release_fd = -1;
+    pid_t child = shared_segment_fork_publisher(bspChecksum, aasChecksum, false, &ready_fd, &release_fd);
+
+    char published = 0;
+    assert_int_equal(read(ready_fd, &published, 1), 1);
+    assert_int_equal(published, 1);
+
+    char go = 1;
+    assert_int_equal(write(release_fd, &go, 1), 1);
+    int status = 0;
+    assert_int_equal(waitpid(child, &status, 0), child);
+
+    /* the orphaned segment is reused, and the last detach removes it */
+    assert_true(shared_segment_exists(name));
+    assert_true(AAS_SharedWorldAttach(bspChecksum, aasChecksum));
+    assert_int_equal(aasworld.numAreas, 5);
+    synthetic_world_release();
+    assert_false(shared_segment_exists(name));
+    assert_false(shared_segment_lock_exists(name));
+
+    close(ready_fd);
+    close(release_fd);
+    LibVarSet("aas_sharedmemory", "0");
+}
+#endif
+
 static void test_aas_loads_sample_map(void **state)
 {
     (void)state;
@@ -376,7 +680,8 @@ static void test_aas_entity_linking_and_reachability(void **state)
 
     aasworld.time = 1.0f;
     AASEntityFrame translated = {0};
-    status = TranslateEntityUpdate(1, &fixtures[0], aasworld.time, &translated);
+    TranslateEntity_SetCurrentTime(aasworld.time);
+    status = TranslateEntityUpdate(1, &fixtures[0], &translated);
     assert_int_equal(status, BLERR_NOERROR);
     status = AAS_UpdateEntity(1, &translated);
     assert_int_equal(status, BLERR_NOERROR);
@@ -389,7 +694,8 @@ static void test_aas_entity_linking_and_reachability(void **state)
     assert_area_entity_list_contains(1, 1);
 
     aasworld.time = 2.0f;
-    status = TranslateEntityUpdate(1, &fixtures[1], aasworld.time, &translated);
+    TranslateEntity_SetCurrentTime(aasworld.time);
+    status = TranslateEntityUpdate(1, &fixtures[1], &translated);
     assert_int_equal(status, BLERR_NOERROR);
     status = AAS_UpdateEntity(1, &translated);
     assert_int_equal(status, BLERR_NOERROR);
@@ -401,7 +707,8 @@ static void test_aas_entity_linking_and_reachability(void **state)
     assert_area_entity_list_contains(2, 1);
 
     aasworld.time = 3.0f;
-    status = TranslateEntityUpdate(1, &fixtures[2], aasworld.time, &translated);
+    TranslateEntity_SetCurrentTime(aasworld.time);
+    status = TranslateEntityUpdate(1, &fixtures[2], &translated);
     assert_int_equal(status, BLERR_NOERROR);
     status = AAS_UpdateEntity(1, &translated);
     assert_int_equal(status, BLERR_NOERROR);
@@ -416,6 +723,219 @@ static void test_aas_entity_linking_and_reachability(void **state)
     AAS_Shutdown();
 }
 
+static void test_area_occupancy_follows_links(void **state)
+{
+    (void)state;
+
+    /* areas 1 and 2 form cluster 1, area 3 is a portal into cluster 2 */
+    synthetic_world_build_row(4);
+    aasworld.areasettings[1].cluster = 1;
+    aasworld.areasettings[2].cluster = 1;
+    aasworld.areasettings[3].cluster = -1;
+    aasworld.areasettings[4].cluster = 2;
+    aasworld.maxClients = 4;
+
+    /* Entity 1 is a client slot; entity 10 is a point sized projectile. */
+    AASEntityFrame player = {0};
+    player.solid = SOLID_BBOX;
+    VectorSet(player.origin, 128.0f, 0.0f, 0.0f);
+    VectorSet(player.mins, -40.0f, -8.0f, -8.0f);
+    VectorSet(player.maxs, 40.0f, 8.0f, 8.0f);
+    player.origin_dirty = true;
+    player.bounds_dirty = true;
+
+    AASEntityFrame rocket = {0};
+    rocket.solid = SOLID_BBOX;
+    VectorSet(rocket.origin, 96.0f, 0.0f, 0.0f);
+    rocket.origin_dirty = true;
+
+    assert_int_equal(AAS_UpdateEntity(1, &player), BLERR_NOERROR);
+    assert_int_equal(AAS_UpdateEntity(10, &rocket), BLERR_NOERROR);
+
+    int players = AAS_OCCUPANT_MASK(AAS_OCCUPANT_PLAYER);
+    int projectiles = AAS_OCCUPANT_MASK(AAS_OCCUPANT_PROJECTILE);
+    assert_int_equal(AAS_AreaOccupancy(1, players), 1);
+    assert_int_equal(AAS_AreaOccupancy(2, players), 1);
+    assert_int_equal(AAS_AreaOccupancy(1, projectiles), 1);
+    assert_int_equal(AAS_AreaOccupancy(2, projectiles), 0);
+    assert_int_equal(AAS_AreaOccupancy(1, AAS_OCCUPANT_ALL), 2);
+
+    /* Straddling two areas of one cluster still counts as one player. */
+    assert_int_equal(AAS_ClusterOccupancy(1, players), 1);
+    assert_int_equal(AAS_ClusterOccupancy(2, AAS_OCCUPANT_ALL), 0);
+
+    assert_int_equal(AAS_UpdateEntity(10, NULL), BLERR_NOERROR);
+    assert_int_equal(AAS_AreaOccupancy(1, projectiles), 0);
+    assert_int_equal(AAS_AreaOccupancy(1, AAS_OCCUPANT_ALL), 1);
+
+    /* maxclients is read at map load, later changes keep the client range */
+    LibVarSet("maxclients", "1");
+
+    /* In the portal the player counts for the area but no cluster. */
+    VectorSet(player.origin, 224.0f, 0.0f, 0.0f);
+    VectorSet(player.mins, -8.0f, -8.0f, -8.0f);
+    VectorSet(player.maxs, 8.0f, 8.0f, 8.0f);
+    assert_int_equal(AAS_UpdateEntity(1, &player), BLERR_NOERROR);
+    assert_int_equal(AAS_AreaOccupancy(3, players), 1);
+    assert_int_equal(AAS_AreaOccupancy(1, AAS_OCCUPANT_ALL), 0);
+    assert_int_equal(AAS_ClusterOccupancy(1, AAS_OCCUPANT_ALL), 0);
+    assert_int_equal(AAS_ClusterOccupancy(2, AAS_OCCUPANT_ALL), 0);
+
+    VectorSet(player.origin, 1024.0f, 0.0f, 0.0f);
+    assert_int_equal(AAS_UpdateEntity(1, &player), BLERR_NOERROR);
+    assert_int_equal(AAS_AreaOccupancy(3, AAS_OCCUPANT_ALL), 0);
+
+    AAS_Shutdown();
+    LibVarSet("maxclients", "4");
+}
+
+static void test_route_cache_fill_counts_allocations(void **state)
+{
+    (void)state;
+
+    synthetic_world_build_row(3);
+    int links[4][4] = {{0}, {2}, {3}, {0}};
+    int numlinks[4] = {0, 1, 1, 0};
+    synthetic_world_link(3, links, numlinks);
+    aasworld.reachability[0].traveltime = 100;
+    aasworld.reachability[1].traveltime = 100;
+    AAS_InitTravelFlagFromType();
+
+    /* the routing cache is filled with calloc/malloc, which are counted too */
+    size_t before = BotMemory_AllocationCount();
+    vec3_t origin = {96.0f, 0.0f, 0.0f};
+    assert_true(AAS_AreaTravelTimeToGoalArea(1, origin, 3, TFL_DEFAULT) > 0);
+    size_t filled = BotMemory_AllocationCount();
+    assert_true(filled > before);
+
+    /* a cached answer allocates nothing */
+    assert_true(AAS_AreaTravelTimeToGoalArea(2, origin, 3, TFL_DEFAULT) > 0);
+    assert_int_equal(BotMemory_AllocationCount(), filled);
+
+    AAS_FreeAllRoutingCaches();
+}
+
+static void test_point_area_hint_resolves_overlaps_like_full_lookup(void **state)
+{
+    (void)state;
+
+    /* area 2 lies inside area 1, area 3 overlaps the end of area 1 */
+    synthetic_world_alloc(3);
+    synthetic_world_set_box(1, 0.0f, 256.0f, 32.0f);
+    synthetic_world_set_box(2, 64.0f, 128.0f, 32.0f);
+    synthetic_world_set_box(3, 192.0f, 384.0f, 32.0f);
+    int links[4][4] = {{0}, {2}, {3}, {1}};
+    int numlinks[4] = {0, 1, 1, 1};
+    synthetic_world_link(3, links, numlinks);
+    assert_int_equal(AAS_PrepareAreaOverlaps(), BLERR_NOERROR);
+
+    /* The hint's own box holds the point, but area 1 comes first. */
+    vec3_t nested = {96.0f, 0.0f, 0.0f};
+    assert_int_equal(AAS_PointAreaNum(nested), 1);
+    assert_int_equal(AAS_PointAreaNumHinted(nested, 2), 1);
+
+    /* The neighbour of the hint holds the point and nothing before it does. */
+    vec3_t beyond = {320.0f, 0.0f, 0.0f};
+    assert_int_equal(AAS_PointAreaNum(beyond), 3);
+    assert_int_equal(AAS_PointAreaNumHinted(beyond, 2), 3);
+
+    /* The neighbour holds the point, but so does the lower area 1. */
+    vec3_t shared = {224.0f, 0.0f, 0.0f};
+    assert_int_equal(AAS_PointAreaNum(shared), 1);
+    assert_int_equal(AAS_PointAreaNumHinted(shared, 2), 1);
+    assert_int_equal(AAS_PointAreaNumHinted(shared, 3), 1);
+
+    /* Out-of-range hints and points outside every area. */
+    assert_int_equal(AAS_PointAreaNumHinted(beyond, aasworld.numAreas + 5), 3);
+    vec3_t outside = {1024.0f, 0.0f, 0.0f};
+    assert_int_equal(AAS_PointAreaNumHinted(outside, 3), 0);
+}
+
+static void test_point_area_hint_matches_full_lookup(void **state)
+{
+    (void)state;
+
+    enum { count = 48 };
+    srand(27);
+    synthetic_world_alloc(count);
+    for (int area = 1; area <= count; ++area) {
+        aas_area_t *entry = &aasworld.areas[area];
+        entry->areanum = area;
+        for (int axis = 0; axis < 3; ++axis) {
+            float low = (float)(rand() % 512);
+            entry->mins[axis] = low;
+            entry->maxs[axis] = low + (float)(16 + rand() % 128);
+        }
+    }
+
+    int links[count + 1][4];
+    int numlinks[count + 1];
+    memset(links, 0, sizeof(links));
+    memset(numlinks, 0, sizeof(numlinks));
+    for (int area = 1; area <= count; ++area) {
+        numlinks[area] = 1 + rand() % 4;
+        for (int link = 0; link < numlinks[area]; ++link) {
+            links[area][link] = 1 + rand() % count;
+        }
+    }
+    synthetic_world_link(count, links, numlinks);
+    assert_int_equal(AAS_PrepareAreaOverlaps(), BLERR_NOERROR);
+
+    int hits = 0;
+    for (int sample = 0; sample < 20000; ++sample) {
+        vec3_t point = {(float)(rand() % 640), (float)(rand() % 640), (float)(rand() % 640)};
+        int full = AAS_PointAreaNum(point);
+        int hint = rand() % (count + 2);
+        assert_int_equal(AAS_PointAreaNumHinted(point, hint), full);
+        if (full > 0) {
+            assert_int_equal(AAS_PointAreaNumHinted(point, full), full);
+            hits++;
+        }
+    }
+    assert_true(hits > 0);
+}
+
+static void test_trace_areas_walks_node_tree(void **state)
+{
+    (void)state;
+
+    synthetic_world_build_row(4);
+    synthetic_world_build_tree(4);
+
+    vec3_t start = {96.0f, 0.0f, 0.0f};
+    vec3_t end = {96.0f, 0.0f, 0.0f};
+    int areas[16];
+    vec3_t points[16];
+
+    /* A degenerate segment reports the area containing the point. */
+    int count = AAS_TraceAreas(start, end, areas, points, 16);
+    assert_int_equal(count, 1);
+    assert_int_equal(areas[0], AAS_PointAreaNum(start));
+    assert_float_equal(points[0][0], start[0], 0.001f);
+
+    /* Longer segments list each area once, with the point where it is entered. */
+    end[0] = 288.0f;
+    count = AAS_TraceAreas(start, end, areas, points, 16);
+    assert_int_equal(count, 4);
+    for (int index = 0; index < count; ++index) {
+        assert_int_equal(areas[index], index + 1);
+    }
+    assert_float_equal(points[0][0], 96.0f, 0.001f);
+    assert_float_equal(points[1][0], 128.0f, 0.001f);
+    assert_float_equal(points[3][0], 256.0f, 0.001f);
+
+    /* Walking back visits the same areas in reverse. */
+    count = AAS_TraceAreas(end, start, areas, points, 16);
+    assert_int_equal(count, 4);
+    assert_int_equal(areas[0], 4);
+    assert_int_equal(areas[3], 1);
+    assert_float_equal(points[1][0], 256.0f, 0.001f);
+
+    /* The caller's limit is honoured. */
+    assert_int_equal(AAS_TraceAreas(start, end, areas, NULL, 1), 1);
+    assert_int_equal(areas[0], 1);
+}
+
 static void test_routing_frame_respects_framereachability(void **state)
 {
     (void)state;
@@ -515,6 +1035,9 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_aas_entity_linking_and_reachability,
                                         aas_environment_setup,
                                         aas_environment_teardown),
+        cmocka_unit_test_setup_teardown(test_trace_areas_walks_node_tree,
+                                        aas_synthetic_setup,
+                                        aas_synthetic_teardown),
         cmocka_unit_test_setup_teardown(test_routing_frame_respects_framereachability,
                                         aas_environment_setup,
                                         aas_environment_teardown),
@@ -527,6 +1050,26 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_reachability_force_clustering_toggle,
                                         aas_environment_setup,
                                         aas_environment_teardown),
+        cmocka_unit_test_setup_teardown(test_area_occupancy_follows_links,
+                                        aas_synthetic_setup,
+                                        aas_synthetic_teardown),
+        cmocka_unit_test_setup_teardown(test_route_cache_fill_counts_allocations,
+                                        aas_synthetic_setup,
+                                        aas_synthetic_teardown),
+        cmocka_unit_test_setup_teardown(test_point_area_hint_resolves_overlaps_like_full_lookup,
+                                        aas_synthetic_setup,
+                                        aas_synthetic_teardown),
+        cmocka_unit_test_setup_teardown(test_point_area_hint_matches_full_lookup,
+                                        aas_synthetic_setup,
+                                        aas_synthetic_teardown),
+#ifndef _WIN32
+        cmocka_unit_test_setup_teardown(test_shared_world_outlives_publisher_detach,
+                                        aas_synthetic_setup,
+                                        aas_synthetic_teardown),
+        cmocka_unit_test_setup_teardown(test_shared_world_survives_publisher_crash,
+                                        aas_synthetic_setup,
+                                        aas_synthetic_teardown),
+#endif
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,750 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdbool.h>
+
+#include "botlib/aas/aas_local.h"
+#include "botlib/aas/aas_sound.h"
+#include "botlib/ai_goal/ai_goal.h"
+#include "botlib/ai_goal/bot_goal.h"
+
+#define TEST_GOAL_BULK_ITEMS 400
+
+static int test_setup(void **state)
+{
+    (void)state;
+
+    memset(&aasworld, 0, sizeof(aasworld));
+    aasworld.loaded = qtrue;
+    aasworld.numAreas = 4;
+    aasworld.numAreaSettings = 5;
+    aasworld.numClusters = 2;
+    aasworld.areasettings = calloc(5, sizeof(aas_areasettings_t));
+    if (aasworld.areasettings == NULL)
+    {
+        return -1;
+    }
+    aasworld.areasettings[1].cluster = 1;
+    aasworld.areasettings[2].cluster = 1;
+    aasworld.areasettings[3].cluster = 2;
+    aasworld.areasettings[4].cluster = 2;
+    return 0;
+}
+
+static int test_teardown(void **state)
+{
+    (void)state;
+
+    free(aasworld.areasettings);
+    memset(&aasworld, 0, sizeof(aasworld));
+
+    /* without a world this drops the item travel matrix and its request */
+    BotGoal_UpdateItemTravelMatrix(1);
+    return 0;
+}
+
+static void register_weighted_item(int number, const char *classname, int areanum, float weight)
+{
+    bot_levelitem_setup_t setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.classname = classname;
+    setup.goal.number = number;
+    setup.goal.entitynum = number;
+    setup.goal.areanum = areanum;
+    setup.weight = weight;
+    setup.flags = GFL_ITEM;
+    assert_int_equal(BotGoal_RegisterLevelItem(&setup), number);
+}
+
+static void register_item(int number, const char *classname, int areanum)
+{
+    register_weighted_item(number, classname, areanum, 1.0f);
+}
+
+static bool contains(const int *numbers, int count, int number)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (numbers[i] == number)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_level_items_filed_by_area_and_cluster(void **state)
+{
+    (void)state;
+
+    register_item(10, "item_armor_body", 1);
+    register_item(11, "item_health", 1);
+    register_item(12, "item_health", 3);
+
+    int numbers[8];
+    int count = BotGoal_ItemsInArea(1, numbers, 8);
+    assert_int_equal(count, 2);
+    assert_true(contains(numbers, count, 10));
+    assert_true(contains(numbers, count, 11));
+    assert_int_equal(BotGoal_ItemsInArea(2, numbers, 8), 0);
+    assert_int_equal(BotGoal_ItemsInCluster(2, numbers, 8), 1);
+    assert_int_equal(numbers[0], 12);
+
+    /* moving an item refiles it */
+    register_item(11, "item_health", 4);
+    assert_int_equal(BotGoal_ItemsInArea(1, numbers, 8), 1);
+    assert_int_equal(numbers[0], 10);
+    count = BotGoal_ItemsInCluster(2, numbers, 8);
+    assert_int_equal(count, 2);
+    assert_true(contains(numbers, count, 11));
+    assert_true(contains(numbers, count, 12));
+
+    BotGoal_UnregisterLevelItem(10);
+    assert_int_equal(BotGoal_ItemsInArea(1, numbers, 8), 0);
+    assert_int_equal(BotGoal_ItemsInCluster(1, numbers, 8), 0);
+
+    char name[64];
+    BotGoalName(10, name, sizeof(name));
+    assert_string_equal(name, "10");
+    BotGoalName(12, name, sizeof(name));
+    assert_string_equal(name, "item_health");
+
+    /* a world with a different layout gets fresh buckets */
+    aasworld.numAreas = 3;
+    aasworld.numAreaSettings = 4;
+    aasworld.numClusters = 0;
+    assert_int_equal(BotGoal_ItemsInArea(3, numbers, 8), 1);
+    assert_int_equal(numbers[0], 12);
+    assert_int_equal(BotGoal_ItemsInCluster(2, numbers, 8), 0);
+
+    BotGoal_UnregisterLevelItem(11);
+    BotGoal_UnregisterLevelItem(12);
+}
+
+static void test_level_item_lookup_survives_many_items(void **state)
+{
+    (void)state;
+
+    char classname[64];
+    for (int i = 0; i < TEST_GOAL_BULK_ITEMS; ++i)
+    {
+        snprintf(classname, sizeof(classname), "item_bulk_%d", i % 37);
+        register_item(1000 + i * 7, classname, (i % 4) + 1);
+    }
+
+    char name[64];
+    for (int i = 0; i < TEST_GOAL_BULK_ITEMS; ++i)
+    {
+        snprintf(classname, sizeof(classname), "item_bulk_%d", i % 37);
+        BotGoalName(1000 + i * 7, name, sizeof(name));
+        assert_string_equal(name, classname);
+    }
+
+    int numbers[TEST_GOAL_BULK_ITEMS];
+    assert_int_equal(BotGoal_ItemsInArea(2, numbers, TEST_GOAL_BULK_ITEMS), TEST_GOAL_BULK_ITEMS / 4);
+    assert_int_equal(BotGoal_ItemsInCluster(1, numbers, TEST_GOAL_BULK_ITEMS), TEST_GOAL_BULK_ITEMS / 2);
+
+    for (int i = 0; i < TEST_GOAL_BULK_ITEMS; i += 2)
+    {
+        BotGoal_UnregisterLevelItem(1000 + i * 7);
+    }
+    for (int i = 0; i < TEST_GOAL_BULK_ITEMS; ++i)
+    {
+        BotGoalName(1000 + i * 7, name, sizeof(name));
+        if (i % 2 == 0)
+        {
+            snprintf(classname, sizeof(classname), "%d", 1000 + i * 7);
+        }
+        else
+        {
+            snprintf(classname, sizeof(classname), "item_bulk_%d", i % 37);
+        }
+        assert_string_equal(name, classname);
+    }
+    assert_int_equal(BotGoal_ItemsInCluster(1, numbers, TEST_GOAL_BULK_ITEMS), TEST_GOAL_BULK_ITEMS / 4);
+
+    for (int i = 1; i < TEST_GOAL_BULK_ITEMS; i += 2)
+    {
+        BotGoal_UnregisterLevelItem(1000 + i * 7);
+    }
+}
+
+static void test_item_snapshot_tracks_availability(void **state)
+{
+    (void)state;
+
+    int handle = BotAllocGoalState(1);
+    assert_true(handle > 0);
+
+    register_item(20, "item_armor_body", 2);
+    BotGoal_UpdateItemSnapshot(5.0f);
+
+    vec3_t origin = {0.0f, 0.0f, 0.0f};
+    int inventory[MAX_ITEMS];
+    memset(inventory, 0, sizeof(inventory));
+
+    bot_goal_t goal;
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 20);
+    BotEmptyGoalStack(handle);
+
+    /* taking the item invalidates the snapshot for the rest of the frame */
+    BotGoal_MarkItemTaken(20, 10.0f);
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 0);
+
+    BotGoal_UpdateItemSnapshot(10.0f);
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 0);
+
+    BotGoal_UpdateItemSnapshot(15.0f);
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 20);
+
+    BotGoal_UnregisterLevelItem(20);
+    BotEmptyGoalStack(handle);
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 0);
+
+    BotFreeGoalState(handle);
+    BotGoal_SetCurrentTime(0.0f);
+}
+
+/*
+ * Lays the fixture's areas out along the x axis, 100 units apart.  Areas 1 to
+ * 3 form a walkable corridor and area 4 cannot be reached from it.
+ */
+static void build_corridor_world(void)
+{
+    aasworld.areas = calloc(5, sizeof(aas_area_t));
+    aasworld.numReachability = 2;
+    aasworld.reachability = calloc(2, sizeof(aas_reachability_t));
+    aasworld.reachabilityFromArea = calloc(2, sizeof(int));
+    aasworld.reversedReachability = calloc(5, sizeof(aas_reversedreachability_t));
+    assert_non_null(aasworld.areas);
+    assert_non_null(aasworld.reachability);
+    assert_non_null(aasworld.reachabilityFromArea);
+    assert_non_null(aasworld.reversedReachability);
+
+    for (int areanum = 1; areanum <= 4; ++areanum)
+    {
+        aas_area_t *area = &aasworld.areas[areanum];
+        area->areanum = areanum;
+        VectorSet(area->mins, (float)(areanum - 1) * 100.0f, 0.0f, -10.0f);
+        VectorSet(area->maxs, (float)areanum * 100.0f, 100.0f, 10.0f);
+        VectorSet(area->center, (float)areanum * 100.0f - 50.0f, 50.0f, 0.0f);
+    }
+
+    static int reach_into[5][1] = {{0}, {0}, {0}, {1}, {0}};
+    for (int index = 0; index < 2; ++index)
+    {
+        aasworld.reachability[index].areanum = index + 2;
+        aasworld.reachability[index].traveltype = TRAVEL_WALK;
+        aasworld.reachability[index].traveltime = 40;
+        aasworld.reachabilityFromArea[index] = index + 1;
+        aasworld.areasettings[index + 1].firstreachablearea = index;
+        aasworld.areasettings[index + 1].numreachableareas = 1;
+        aasworld.reversedReachability[index + 2].count = 1;
+        aasworld.reversedReachability[index + 2].reachIndexes = reach_into[index + 2];
+    }
+}
+
+static void free_corridor_world(void)
+{
+    /* the next fixture may get the same reachability array back from calloc */
+    AAS_InvalidateRouteCache();
+    aasworld.reachabilityEpoch += 1U;
+    free(aasworld.areas);
+    free(aasworld.reachability);
+    free(aasworld.reachabilityFromArea);
+    free(aasworld.reversedReachability);
+    aasworld.areas = NULL;
+    aasworld.reachability = NULL;
+    aasworld.reachabilityFromArea = NULL;
+    aasworld.reversedReachability = NULL;
+    aasworld.numReachability = 0;
+}
+
+static void test_ltg_selection_prunes_route_queries(void **state)
+{
+    (void)state;
+
+    build_corridor_world();
+    int handle = BotAllocGoalState(1);
+    assert_true(handle > 0);
+
+    register_weighted_item(30, "item_armor_body", 3, 10.0f);
+    register_weighted_item(31, "item_health", 2, 2.0f);
+    register_weighted_item(32, "item_health", 1, 1.0f);
+    register_weighted_item(33, "item_quad", 4, 50.0f);
+    BotGoal_UpdateItemSnapshot(1.0f);
+
+    vec3_t origin = {10.0f, 50.0f, 0.0f};
+    int inventory[MAX_ITEMS];
+    memset(inventory, 0, sizeof(inventory));
+
+    /* the unreachable quad is tried and dropped, the armor beats every bound left */
+    bot_goal_t goal;
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 30);
+    assert_int_equal(BotGoal_LastRouteQueries(), 2);
+    BotEmptyGoalStack(handle);
+
+    BotGoal_MarkItemTaken(30, 30.0f);
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 31);
+    assert_int_equal(BotGoal_LastRouteQueries(), 2);
+    BotEmptyGoalStack(handle);
+
+    for (int number = 30; number <= 33; ++number)
+    {
+        BotGoal_UnregisterLevelItem(number);
+    }
+    BotFreeGoalState(handle);
+    BotGoal_SetCurrentTime(0.0f);
+    free_corridor_world();
+}
+
+static void test_ltg_bound_allows_for_teleporters(void **state)
+{
+    (void)state;
+
+    /* area 3 sits far down the x axis behind a teleporter out of area 2 */
+    build_corridor_world();
+    AAS_InitTravelFlagFromType();
+    VectorSet(aasworld.areas[3].mins, 10000.0f, 0.0f, -10.0f);
+    VectorSet(aasworld.areas[3].maxs, 10100.0f, 100.0f, 10.0f);
+    VectorSet(aasworld.areas[3].center, 10050.0f, 50.0f, 0.0f);
+    aasworld.reachability[1].traveltype = TRAVEL_TELEPORT;
+    aasworld.reachability[1].traveltime = 10;
+    VectorSet(aasworld.reachability[1].start, 150.0f, 50.0f, 0.0f);
+    VectorSet(aasworld.reachability[1].end, 10050.0f, 50.0f, 0.0f);
+
+    int handle = BotAllocGoalState(1);
+    assert_true(handle > 0);
+    register_weighted_item(34, "item_armor_body", 3, 20.0f);
+    register_weighted_item(35, "item_health", 2, 2.0f);
+    BotGoal_UpdateItemSnapshot(1.0f);
+
+    vec3_t origin = {10.0f, 50.0f, 0.0f};
+    int inventory[MAX_ITEMS];
+    memset(inventory, 0, sizeof(inventory));
+
+    /* a run-speed bound would write the armor off without asking the router */
+    bot_goal_t goal;
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 34);
+    BotEmptyGoalStack(handle);
+
+    /* without teleporters the armor is out of reach */
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT & ~TFL_TELEPORT), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 35);
+    BotEmptyGoalStack(handle);
+
+    BotGoal_UnregisterLevelItem(34);
+    BotGoal_UnregisterLevelItem(35);
+    BotFreeGoalState(handle);
+    BotGoal_SetCurrentTime(0.0f);
+    free_corridor_world();
+}
+
+static void test_goal_update_plans_with_travel_flags(void **state)
+{
+    (void)state;
+
+    /* the interface drives goal selection through AI_GoalBotlib_Update */
+    build_corridor_world();
+    AAS_InitTravelFlagFromType();
+    int handle = AI_GoalBotlib_AllocState(1);
+    assert_true(handle > 0);
+    register_weighted_item(36, "item_health", 2, 2.0f);
+    BotGoal_UpdateItemSnapshot(1.0f);
+
+    vec3_t origin = {10.0f, 50.0f, 0.0f};
+    int inventory[MAX_ITEMS];
+    memset(inventory, 0, sizeof(inventory));
+
+    /* no travel flags means no route to anything */
+    bot_goal_t goal;
+    assert_int_equal(AI_GoalBotlib_Update(handle, origin, inventory, 0, 1.0f, 0.0f), BLERR_INVALIDIMPORT);
+    assert_int_equal(AI_GoalBotlib_GetTopGoal(handle, &goal), 0);
+
+    assert_int_equal(AI_GoalBotlib_Update(handle, origin, inventory, TFL_DEFAULT, 1.0f, 0.0f), BLERR_NOERROR);
+    assert_int_equal(AI_GoalBotlib_GetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 36);
+
+    BotGoal_UnregisterLevelItem(36);
+    AI_GoalBotlib_FreeState(handle);
+    BotGoal_SetCurrentTime(0.0f);
+    free_corridor_world();
+}
+
+static void test_ltg_assignment_spreads_bots_over_items(void **state)
+{
+    (void)state;
+
+    build_corridor_world();
+    int handles[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        handles[i] = BotAllocGoalState(i + 1);
+        assert_true(handles[i] > 0);
+    }
+
+    register_weighted_item(40, "item_health_mega", 3, 10.0f);
+    register_weighted_item(41, "item_health", 2, 5.0f);
+    BotGoal_UpdateItemSnapshot(1.0f);
+
+    int inventory[MAX_ITEMS];
+    memset(inventory, 0, sizeof(inventory));
+    bot_goalassignment_t bots[3];
+    memset(bots, 0, sizeof(bots));
+    for (int i = 0; i < 3; ++i)
+    {
+        bots[i].handle = handles[i];
+        VectorSet(bots[i].origin, 20.0f - (float)i, 50.0f, 0.0f);
+        bots[i].inventory = inventory;
+        bots[i].travelflags = TFL_DEFAULT;
+    }
+
+    /* on their own both bots would run for the mega health */
+    assert_int_equal(BotAssignLTGItems(bots, 2), 2);
+    assert_int_equal(bots[0].number, 40);
+    assert_int_equal(bots[1].number, 41);
+
+    bot_goal_t goal;
+    assert_int_equal(BotGetTopGoal(handles[1], &goal), 1);
+    assert_int_equal(goal.number, 41);
+
+    /* with every item taken the last bot falls back to its favourite */
+    for (int i = 0; i < 3; ++i)
+    {
+        BotEmptyGoalStack(handles[i]);
+    }
+    assert_int_equal(BotAssignLTGItems(bots, 3), 3);
+    assert_int_equal(bots[0].number, 40);
+    assert_int_equal(bots[1].number, 41);
+    assert_int_equal(bots[2].number, 40);
+
+    BotGoal_UnregisterLevelItem(40);
+    BotGoal_UnregisterLevelItem(41);
+    for (int i = 0; i < 3; ++i)
+    {
+        BotFreeGoalState(handles[i]);
+    }
+    BotGoal_SetCurrentTime(0.0f);
+    free_corridor_world();
+}
+
+static void test_nbg_selection_searches_neighbourhood(void **state)
+{
+    (void)state;
+
+    build_corridor_world();
+    int handle = BotAllocGoalState(1);
+    assert_true(handle > 0);
+
+    register_weighted_item(40, "item_health", 1, 1.0f);
+    register_weighted_item(41, "item_armor_shard", 2, 3.0f);
+    register_weighted_item(42, "item_armor_body", 3, 10.0f);
+    register_weighted_item(43, "item_quad", 4, 50.0f);
+    BotGoal_UpdateItemSnapshot(1.0f);
+
+    vec3_t origin = {10.0f, 50.0f, 0.0f};
+    int inventory[MAX_ITEMS];
+    memset(inventory, 0, sizeof(inventory));
+
+    /* the body armor is just outside the radius */
+    bot_goal_t goal;
+    assert_int_equal(BotChooseNBGItem(handle, origin, inventory, TFL_DEFAULT, NULL, 0.6f), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 41);
+    BotEmptyGoalStack(handle);
+
+    assert_int_equal(BotChooseNBGItem(handle, origin, inventory, TFL_DEFAULT, NULL, 1.0f), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 42);
+    BotEmptyGoalStack(handle);
+
+    /* the long-term goal itself is never picked as a nearby goal */
+    bot_goal_t ltg;
+    memset(&ltg, 0, sizeof(ltg));
+    ltg.number = 42;
+    assert_int_equal(BotChooseNBGItem(handle, origin, inventory, TFL_DEFAULT, &ltg, 1.0f), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 41);
+    BotEmptyGoalStack(handle);
+
+    /* walking to the centre of the bot's own area already takes too long */
+    assert_int_equal(BotChooseNBGItem(handle, origin, inventory, TFL_DEFAULT, NULL, 0.1f), 0);
+
+    for (int number = 40; number <= 43; ++number)
+    {
+        BotGoal_UnregisterLevelItem(number);
+    }
+    BotFreeGoalState(handle);
+    BotGoal_SetCurrentTime(0.0f);
+    free_corridor_world();
+    AAS_FreeLocalRouteScratch();
+}
+
+static void test_travel_memo_reuses_route_times_within_frame(void **state)
+{
+    (void)state;
+
+    build_corridor_world();
+    vec3_t origin = {10.0f, 50.0f, 0.0f};
+    vec3_t other = {90.0f, 50.0f, 0.0f};
+    int expected = AAS_AreaTravelTimeToGoalArea(1, origin, 3, TFL_DEFAULT);
+    int expected_other = AAS_AreaTravelTimeToGoalArea(1, other, 3, TFL_DEFAULT);
+    assert_true(expected > 0);
+
+    aas_travelmemo_t memo;
+    memset(&memo, 0, sizeof(memo));
+    AAS_SetTravelMemo(&memo);
+    AAS_RouteFrameUpdate();
+
+    /* the start point only changes the local part, the route time is shared */
+    assert_int_equal(AAS_AreaTravelTimeToGoalArea(1, origin, 3, TFL_DEFAULT), expected);
+    assert_int_equal(AAS_AreaTravelTimeToGoalArea(1, other, 3, TFL_DEFAULT), expected_other);
+    assert_int_equal(AAS_AreaTravelTimeToGoalArea(1, origin, 3, TFL_DEFAULT), expected);
+    assert_int_equal(AAS_AreaTravelTimeToGoalArea(1, origin, 2, TFL_DEFAULT), expected - 40);
+
+    AAS_RouteFrameUpdate();
+    assert_int_equal(AAS_RouteFrameMemoLookups(), 4);
+    assert_int_equal(AAS_RouteFrameMemoHits(), 2);
+    assert_true(AAS_RouteFrameMemoHitRate() > 0.49f && AAS_RouteFrameMemoHitRate() < 0.51f);
+
+    /* a new frame starts with an empty memo */
+    aasworld.numFrames += 1;
+    AAS_SetTravelMemo(&memo);
+    assert_int_equal(AAS_AreaTravelTimeToGoalArea(1, origin, 3, TFL_DEFAULT), expected);
+    AAS_RouteFrameUpdate();
+    assert_int_equal(AAS_RouteFrameMemoLookups(), 1);
+    assert_int_equal(AAS_RouteFrameMemoHits(), 0);
+
+    AAS_SetTravelMemo(NULL);
+    free_corridor_world();
+}
+
+static void test_item_travel_matrix_fills_over_frames(void **state)
+{
+    (void)state;
+
+    build_corridor_world();
+    register_item(50, "item_health", 1);
+    register_item(51, "item_armor_shard", 3);
+    register_item(52, "item_quad", 4);
+    vec3_t start = {0.0f, 0.0f, 0.0f};
+    int expected = AAS_AreaTravelTimeToGoalArea(1, start, 3, TFL_DEFAULT);
+    assert_true(expected > 0);
+
+    /* nothing is filled until the table is read */
+    BotGoal_UpdateItemTravelMatrix(1);
+    assert_int_equal(BotGoal_ItemTravelTime(50, 51, TFL_DEFAULT), -1);
+
+    /* one row per frame: only the first item's row is known after one */
+    BotGoal_UpdateItemTravelMatrix(1);
+    assert_false(BotGoal_ItemTravelMatrixComplete(TFL_DEFAULT));
+    assert_int_equal(BotGoal_ItemTravelTime(50, 51, TFL_DEFAULT), expected);
+    assert_int_equal(BotGoal_ItemTravelTime(50, 50, TFL_DEFAULT), 0);
+    assert_int_equal(BotGoal_ItemTravelTime(50, 52, TFL_DEFAULT), 0);
+    assert_int_equal(BotGoal_ItemTravelTime(51, 50, TFL_DEFAULT), -1);
+    assert_int_equal(BotGoal_ItemTravelTime(50, 51, TFL_WALK), -1);
+
+    /* the table spans every item slot, including those earlier tests freed */
+    BotGoal_UpdateItemTravelMatrix(2 * TEST_GOAL_BULK_ITEMS);
+    assert_true(BotGoal_ItemTravelMatrixComplete(TFL_DEFAULT));
+    assert_true(BotGoal_ItemTravelMatrixComplete(TFL_DEFAULT | TFL_ROCKETJUMP));
+    assert_int_equal(BotGoal_ItemTravelTime(50, 51, TFL_DEFAULT | TFL_ROCKETJUMP), expected);
+    assert_int_equal(BotGoal_ItemTravelTime(51, 50, TFL_DEFAULT), 0);
+
+    /* a mover flushing the route cache leaves the table alone */
+    AAS_InvalidateRouteCache();
+    assert_int_equal(BotGoal_ItemTravelTime(50, 51, TFL_DEFAULT), expected);
+    assert_true(BotGoal_ItemTravelMatrixComplete(TFL_DEFAULT));
+
+    /* rebuilt reachabilities or a new item start it over */
+    aasworld.reachabilityEpoch += 1U;
+    assert_int_equal(BotGoal_ItemTravelTime(50, 51, TFL_DEFAULT), -1);
+    BotGoal_UpdateItemTravelMatrix(2 * TEST_GOAL_BULK_ITEMS);
+    assert_int_equal(BotGoal_ItemTravelTime(50, 51, TFL_DEFAULT), expected);
+    register_item(53, "item_health", 2);
+    assert_false(BotGoal_ItemTravelMatrixComplete(TFL_DEFAULT));
+
+    for (int number = 50; number <= 53; ++number)
+    {
+        BotGoal_UnregisterLevelItem(number);
+    }
+    free_corridor_world();
+}
+
+static void test_ltg_chaining_reads_item_travel_matrix(void **state)
+{
+    (void)state;
+
+    build_corridor_world();
+    int handle = BotAllocGoalState(1);
+    assert_true(handle > 0);
+
+    register_weighted_item(60, "item_health", 1, 1.0f);
+    register_weighted_item(61, "item_armor_body", 3, 10.0f);
+    register_weighted_item(62, "item_health", 2, 2.0f);
+    BotGoal_SetCurrentTime(1.0f);
+    BotGoal_MarkItemTaken(60, 30.0f);
+
+    vec3_t origin = {10.0f, 50.0f, 0.0f};
+    int inventory[MAX_ITEMS];
+    memset(inventory, 0, sizeof(inventory));
+
+    /* standing on an item asks for its row, the router answers meanwhile */
+    bot_goal_t goal;
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 61);
+    assert_true(BotGoal_LastRouteQueries() > 0);
+    BotEmptyGoalStack(handle);
+
+    /* once the row is filled the choice is made without routing */
+    BotGoal_UpdateItemTravelMatrix(2 * TEST_GOAL_BULK_ITEMS);
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_DEFAULT), 1);
+    assert_int_equal(BotGetTopGoal(handle, &goal), 1);
+    assert_int_equal(goal.number, 61);
+    assert_int_equal(BotGoal_LastRouteQueries(), 0);
+    BotEmptyGoalStack(handle);
+
+    /* flags outside the table still go to the router */
+    assert_int_equal(BotChooseLTGItem(handle, origin, inventory, TFL_WALK), 1);
+    assert_true(BotGoal_LastRouteQueries() > 0);
+    BotEmptyGoalStack(handle);
+
+    for (int number = 60; number <= 62; ++number)
+    {
+        BotGoal_UnregisterLevelItem(number);
+    }
+    BotFreeGoalState(handle);
+    BotGoal_SetCurrentTime(0.0f);
+    free_corridor_world();
+}
+
+static void test_sound_events_bucketed_by_hearing_range(void **state)
+{
+    (void)state;
+
+    build_corridor_world();
+
+    char config_path[] = "/tmp/gladiator_soundsXXXXXX";
+    int fd = mkstemp(config_path);
+    assert_true(fd >= 0);
+    FILE *config = fdopen(fd, "w");
+    assert_non_null(config);
+    fputs("soundinfo\n{\n    name \"player/step1.wav\"\n    type 1\n}\n", config);
+    fclose(config);
+
+    botlib_library_variables_t vars;
+    memset(&vars, 0, sizeof(vars));
+    vars.max_soundinfo = 4;
+    vars.max_aassounds = 8;
+    strncpy(vars.soundconfig, config_path, sizeof(vars.soundconfig) - 1);
+    assert_int_equal(AAS_SoundSubsystem_Init(&vars), BLERR_NOERROR);
+    remove(config_path);
+
+    vec3_t close = {50.0f, 50.0f, 0.0f};
+    vec3_t distant = {10000.0f, 50.0f, 0.0f};
+    vec3_t everywhere = {20000.0f, 50.0f, 0.0f};
+    vec3_t corridor_end = {250.0f, 50.0f, 0.0f};
+    vec3_t static_hum = {1000.0f, 50.0f, 0.0f};
+    assert_true(AAS_SoundSubsystem_RecordSound(close, 1, 0, 0, 1.0f, ATTN_NORM, 0.0f));
+    assert_true(AAS_SoundSubsystem_RecordSound(distant, 2, 0, 0, 1.0f, ATTN_NORM, 0.0f));
+    assert_true(AAS_SoundSubsystem_RecordSound(everywhere, 3, 0, 0, 1.0f, ATTN_NONE, 0.0f));
+    assert_true(AAS_SoundSubsystem_RecordSound(corridor_end, 4, 0, 0, 1.0f, ATTN_NORM, 0.0f));
+    assert_true(AAS_SoundSubsystem_RecordSound(static_hum, 5, 0, 0, 1.0f, ATTN_STATIC, 0.0f));
+
+    /* the static sound shares the listener's cell but fades out long before */
+    vec3_t listener = {10.0f, 50.0f, 0.0f};
+    const size_t *indexes = NULL;
+    assert_int_equal(AAS_SoundSubsystem_SoundEventsNear(listener, &indexes), 3);
+    assert_int_equal((int)indexes[0], 0);
+    assert_int_equal((int)indexes[1], 2);
+    assert_int_equal((int)indexes[2], 3);
+    assert_int_equal(AAS_SoundSubsystem_SoundEvent(0)->areanum, 1);
+    assert_int_equal(AAS_SoundSubsystem_SoundEvent(2)->areanum, 0);
+    assert_int_equal(AAS_SoundSubsystem_SoundEvent(3)->areanum, 3);
+
+    assert_int_equal(AAS_SoundSubsystem_SoundEventsNear(NULL, &indexes), 5);
+    for (int index = 0; index < 5; ++index)
+    {
+        assert_int_equal((int)indexes[index], index);
+    }
+
+    vec3_t far_light = {9000.0f, 50.0f, 0.0f};
+    assert_true(AAS_SoundSubsystem_RecordPointLight(far_light, 6, 200.0f, 1.0f, 1.0f, 1.0f, 0.1f, 0.1f));
+    assert_true(AAS_SoundSubsystem_RecordPointLight(close, 7, 200.0f, 1.0f, 1.0f, 1.0f, 0.1f, 0.1f));
+    /* lights are seen from anywhere, so the distant flash is kept too */
+    assert_int_equal(AAS_SoundSubsystem_PointLightsNear(listener, &indexes), 2);
+    assert_int_equal((int)indexes[0], 0);
+    assert_int_equal((int)indexes[1], 1);
+    assert_int_equal(AAS_SoundSubsystem_PointLight(0)->areanum, 0);
+    assert_int_equal(AAS_SoundSubsystem_PointLight(1)->areanum, 1);
+
+    AAS_SoundSubsystem_ResetFrameEvents();
+    assert_int_equal(AAS_SoundSubsystem_SoundEventsNear(listener, &indexes), 0);
+
+    AAS_SoundSubsystem_Shutdown();
+    free_corridor_world();
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_level_items_filed_by_area_and_cluster,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_level_item_lookup_survives_many_items,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_item_snapshot_tracks_availability,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_ltg_selection_prunes_route_queries,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_ltg_bound_allows_for_teleporters,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_goal_update_plans_with_travel_flags,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_ltg_assignment_spreads_bots_over_items,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_nbg_selection_searches_neighbourhood,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_travel_memo_reuses_route_times_within_frame,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_item_travel_matrix_fills_over_frames,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_ltg_chaining_reads_item_travel_matrix,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_sound_events_bucketed_by_hearing_range,
+                                        test_setup,
+                                        test_teardown),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -10,6 +10,7 @@
 
 #include "botlib/ai_move/bot_move.h"
 #include "botlib/aas/aas_local.h"
+#include "botlib/aas/aas_map.h"
 #include "botlib/common/l_libvar.h"
 #include "botlib/common/l_memory.h"
 #include "botlib/ea/ea_local.h"
@@ -166,20 +167,6 @@ static botlib_import_table_t g_test_lib_imports = {
     .BotLibVarSet = test_botlib_var_set,
 };
 
-static const botlib_import_table_t *g_active_lib_imports = NULL;
-
-void BotInterface_SetImportTable(const botlib_import_table_t *import_table)
-{
-    g_active_lib_imports = import_table;
-}
-
-const botlib_import_table_t *BotInterface_GetImportTable(void)
-{
-    return g_active_lib_imports;
-}
-
-aas_world_t aasworld = {0};
-
 static int test_setup(void **state)
 {
     (void)state;
@@ -246,13 +233,14 @@ static void test_bot_move_handles_elevator_landing(void **state)
     aasworld.entities = calloc((size_t)aasworld.maxEntities, sizeof(aas_entity_t));
     assert_non_null(aasworld.entities);
 
+    aasworld.entitiesValid = qtrue;
     aasworld.entities[1].inuse = qtrue;
     aasworld.entities[1].number = 1;
 
     aasworld.entities[2].inuse = qtrue;
     aasworld.entities[2].number = 2;
     aasworld.entities[2].solid = SOLID_BSP;
-    aasworld.entities[2].modelindex = 5;
+    aasworld.entities[2].modelindex = 6; /* inline model *5 */
 
     aas_link_t *botLink = calloc(1, sizeof(aas_link_t));
     aas_link_t *moverLink = calloc(1, sizeof(aas_link_t));
@@ -280,6 +268,10 @@ static void test_bot_move_handles_elevator_landing(void **state)
     };
     assert_true(BotMove_MoverCatalogueInsert(&entry));
 
+    char *names[] = {"", "", "*1", "*2", "*3", "*4", "*5"};
+    botinterface_asset_list_t models = {names, 7U};
+    assert_true(BotMove_MoverCatalogueFinalize(&models));
+
     int handle = BotAllocMoveState();
     assert_int_not_equal(handle, 0);
     bot_movestate_t *ms = BotMoveStateFromHandle(handle);
@@ -325,6 +317,869 @@ static void test_bot_move_handles_elevator_landing(void **state)
     aasworld.numAreas = 0;
 }
 
+static void test_bot_move_follows_corridor(void **state)
+{
+    (void)state;
+
+    BotMove_MoverCatalogueReset();
+
+    aasworld.time = 1.0f;
+    aasworld.numAreas = 3;
+    aasworld.numAreaSettings = 4;
+    aasworld.areasettings = calloc(4, sizeof(aas_areasettings_t));
+    assert_non_null(aasworld.areasettings);
+    aasworld.areasettings[1].firstreachablearea = 1;
+    aasworld.areasettings[1].numreachableareas = 1;
+    aasworld.areasettings[2].firstreachablearea = 2;
+    aasworld.areasettings[2].numreachableareas = 1;
+
+    aasworld.numReachability = 3;
+    aasworld.reachability = calloc(3, sizeof(aas_reachability_t));
+    assert_non_null(aasworld.reachability);
+    aasworld.reachability[1].areanum = 2;
+    aasworld.reachability[1].traveltype = TRAVEL_WALK;
+    VectorSet(aasworld.reachability[1].end, 64.0f, 0.0f, 0.0f);
+    aasworld.reachability[2].areanum = 3;
+    aasworld.reachability[2].traveltype = TRAVEL_WALK;
+    VectorSet(aasworld.reachability[2].end, 128.0f, 0.0f, 0.0f);
+
+    aasworld.travelflagfortype[TRAVEL_WALK] = TFL_WALK;
+
+    int handle = BotAllocMoveState();
+    assert_int_not_equal(handle, 0);
+    bot_movestate_t *ms = BotMoveStateFromHandle(handle);
+    assert_non_null(ms);
+    ms->entitynum = 1;
+    ms->areanum = 1;
+    VectorClear(ms->origin);
+
+    bot_goal_t goal = {0};
+    goal.areanum = 3;
+    VectorSet(goal.origin, 160.0f, 0.0f, 0.0f);
+
+    bot_moveresult_t result;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 1);
+    assert_int_equal(ms->corridorlength, 2);
+    assert_int_equal(ms->corridorindex, 0);
+
+    /* Cut the graph: the next leg must come from the corridor, not a search. */
+    aasworld.areasettings[2].numreachableareas = 0;
+    ms->areanum = 2;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 2);
+    assert_int_equal(ms->corridorindex, 1);
+
+    /* A moving SOLID_BSP entity invalidates routes, but the corridor is kept. */
+    AASEntityFrame door;
+    memset(&door, 0, sizeof(door));
+    door.number = 5;
+    door.solid = SOLID_BSP;
+    door.modelindex = 2;
+    VectorSet(door.previous_origin, 96.0f, 0.0f, 0.0f);
+    VectorSet(door.origin, 96.0f, 0.0f, 8.0f);
+    door.origin_dirty = true;
+    unsigned int routeEpoch = aasworld.routeEpoch;
+    assert_int_equal(AAS_UpdateEntity(5, &door), BLERR_NOERROR);
+    assert_int_not_equal(aasworld.routeEpoch, routeEpoch);
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 2);
+    assert_int_equal(ms->corridorlength, 2);
+    assert_int_equal(ms->corridorindex, 1);
+
+    /* A new reachability epoch forces a re-plan, which now finds no path. */
+    aasworld.reachabilityEpoch++;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 0);
+    assert_int_equal(ms->corridorlength, 0);
+
+    /* Full searches run in the move state's scratch buffers. */
+    size_t allocations = BotMemory_AllocationCount();
+    for (int i = 0; i < 4; ++i)
+    {
+        aasworld.reachabilityEpoch++;
+        BotClearMoveResult(&result);
+        BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    }
+    assert_int_equal(BotMemory_AllocationCount(), allocations);
+    assert_int_equal(ms->scratchareas, aasworld.numAreaSettings);
+
+    BotFreeMoveState(handle);
+
+    /* releases the hand-built arrays together with the door */
+    AAS_Shutdown();
+}
+
+static void test_bot_move_walks_straight_through_walk_areas(void **state)
+{
+    (void)state;
+
+    BotMove_MoverCatalogueReset();
+
+    /* three boxes in a row along x, split by the planes x = 64 and x = 128 */
+    aasworld.time = 1.0f;
+    aasworld.numAreas = 3;
+    aasworld.areas = calloc(4, sizeof(aas_area_t));
+    assert_non_null(aasworld.areas);
+    for (int area = 1; area <= 3; ++area)
+    {
+        aasworld.areas[area].areanum = area;
+        VectorSet(aasworld.areas[area].mins, (float)(area * 64 - 64), -64.0f, -64.0f);
+        VectorSet(aasworld.areas[area].maxs, (float)(area * 64), 64.0f, 64.0f);
+    }
+
+    aasworld.numPlanes = 3;
+    aasworld.planes = calloc(3, sizeof(aas_plane_t));
+    aasworld.numNodes = 3;
+    aasworld.nodes = calloc(3, sizeof(aas_node_t));
+    assert_non_null(aasworld.planes);
+    assert_non_null(aasworld.nodes);
+    for (int node = 1; node <= 2; ++node)
+    {
+        VectorSet(aasworld.planes[node].normal, 1.0f, 0.0f, 0.0f);
+        aasworld.planes[node].dist = (float)(node * 64);
+        aasworld.nodes[node].planenum = node;
+        aasworld.nodes[node].children[0] = (node == 1) ? 2 : -3;
+        aasworld.nodes[node].children[1] = -node;
+    }
+
+    aasworld.numAreaSettings = 4;
+    aasworld.areasettings = calloc(4, sizeof(aas_areasettings_t));
+    assert_non_null(aasworld.areasettings);
+    aasworld.areasettings[1].firstreachablearea = 1;
+    aasworld.areasettings[1].numreachableareas = 1;
+    aasworld.areasettings[2].firstreachablearea = 2;
+    aasworld.areasettings[2].numreachableareas = 1;
+
+    aasworld.numReachability = 3;
+    aasworld.reachability = calloc(3, sizeof(aas_reachability_t));
+    assert_non_null(aasworld.reachability);
+    aasworld.reachability[1].areanum = 2;
+    aasworld.reachability[1].traveltype = TRAVEL_WALK;
+    VectorSet(aasworld.reachability[1].end, 64.0f, 0.0f, 0.0f);
+    aasworld.reachability[2].areanum = 3;
+    aasworld.reachability[2].traveltype = TRAVEL_WALK;
+    VectorSet(aasworld.reachability[2].end, 128.0f, 0.0f, 0.0f);
+
+    aasworld.travelflagfortype[TRAVEL_WALK] = TFL_WALK;
+    aasworld.travelflagfortype[TRAVEL_JUMP] = TFL_JUMP;
+
+    int handle = BotAllocMoveState();
+    assert_int_not_equal(handle, 0);
+    bot_movestate_t *ms = BotMoveStateFromHandle(handle);
+    assert_non_null(ms);
+    ms->entitynum = 1;
+    ms->areanum = 1;
+    VectorSet(ms->origin, 32.0f, 0.0f, 0.0f);
+
+    bot_goal_t goal = {0};
+    goal.areanum = 3;
+    VectorSet(goal.origin, 160.0f, 32.0f, 0.0f);
+
+    /* every area on the segment is walk-connected: head for the goal itself */
+    bot_moveresult_t result;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 0);
+    assert_int_equal(result.traveltype, TRAVEL_WALK);
+    assert_true(result.movedir[1] > 0.1f);
+
+    /* a jump on the way means following the reachabilities */
+    aasworld.reachability[2].traveltype = TRAVEL_JUMP;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 1);
+
+    /* so does a walk the bot is avoiding */
+    aasworld.reachability[2].traveltype = TRAVEL_WALK;
+    ms->avoidreach[0] = 2;
+    ms->avoidreachtimes[0] = aasworld.time + 5.0f;
+    ms->lastreachnum = 0;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_not_equal(ms->lastreachnum, 0);
+
+    BotFreeMoveState(handle);
+
+    free(aasworld.areas);
+    free(aasworld.planes);
+    free(aasworld.nodes);
+    free(aasworld.areasettings);
+    free(aasworld.reachability);
+    aasworld.areas = NULL;
+    aasworld.planes = NULL;
+    aasworld.nodes = NULL;
+    aasworld.areasettings = NULL;
+    aasworld.reachability = NULL;
+    aasworld.numPlanes = 0;
+    aasworld.numNodes = 0;
+    aasworld.numAreaSettings = 0;
+    aasworld.numReachability = 0;
+    aasworld.numAreas = 0;
+}
+
+static void test_bot_move_batch_matches_single_calls(void **state)
+{
+    (void)state;
+
+    BotMove_MoverCatalogueReset();
+
+    aasworld.time = 1.0f;
+    aasworld.numAreas = 3;
+    aasworld.numAreaSettings = 4;
+    aasworld.areasettings = calloc(4, sizeof(aas_areasettings_t));
+    assert_non_null(aasworld.areasettings);
+    aasworld.areasettings[1].firstreachablearea = 1;
+    aasworld.areasettings[1].numreachableareas = 1;
+    aasworld.areasettings[2].firstreachablearea = 2;
+    aasworld.areasettings[2].numreachableareas = 1;
+
+    aasworld.numReachability = 3;
+    aasworld.reachability = calloc(3, sizeof(aas_reachability_t));
+    assert_non_null(aasworld.reachability);
+    aasworld.reachability[1].areanum = 2;
+    aasworld.reachability[1].traveltype = TRAVEL_WALK;
+    VectorSet(aasworld.reachability[1].end, 64.0f, 0.0f, 0.0f);
+    aasworld.reachability[2].areanum = 3;
+    aasworld.reachability[2].traveltype = TRAVEL_WALK;
+    VectorSet(aasworld.reachability[2].end, 128.0f, 0.0f, 0.0f);
+    aasworld.travelflagfortype[TRAVEL_WALK] = TFL_WALK;
+
+    /* two identical sets of bots, one moved singly and one in a batch */
+    const int startAreas[3] = {2, 1, 3};
+    int single[3];
+    int batch[4];
+    bot_goal_t goals[4];
+    int flags[4];
+    memset(goals, 0, sizeof(goals));
+    for (int i = 0; i < 3; ++i)
+    {
+        single[i] = BotAllocMoveState();
+        batch[i] = BotAllocMoveState();
+        assert_int_not_equal(single[i], 0);
+        assert_int_not_equal(batch[i], 0);
+        BotMoveStateFromHandle(single[i])->areanum = startAreas[i];
+        BotMoveStateFromHandle(batch[i])->areanum = startAreas[i];
+        VectorSet(BotMoveStateFromHandle(single[i])->origin, 8.0f * (float)i, 0.0f, 0.0f);
+        VectorSet(BotMoveStateFromHandle(batch[i])->origin, 8.0f * (float)i, 0.0f, 0.0f);
+        goals[i].areanum = 3;
+        VectorSet(goals[i].origin, 160.0f, 0.0f, 0.0f);
+        flags[i] = TFL_DEFAULT;
+    }
+    batch[3] = MAX_CLIENTS + 1;
+    goals[3].areanum = 3;
+    flags[3] = TFL_DEFAULT;
+
+    bot_moveresult_t expected[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        BotClearMoveResult(&expected[i]);
+        BotMoveToGoal(&expected[i], single[i], &goals[i], flags[i]);
+    }
+
+    bot_moveresult_t results[4];
+    memset(results, 0, sizeof(results));
+    BotMoveToGoalBatch(results, batch, goals, flags, 4);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        assert_memory_equal(&results[i], &expected[i], sizeof(bot_moveresult_t));
+        bot_movestate_t *a = BotMoveStateFromHandle(single[i]);
+        bot_movestate_t *b = BotMoveStateFromHandle(batch[i]);
+        assert_int_equal(a->lastreachnum, b->lastreachnum);
+        assert_int_equal(a->reachareanum, b->reachareanum);
+        assert_int_equal(a->corridorlength, b->corridorlength);
+    }
+    assert_int_equal(results[3].failure, 1);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        BotFreeMoveState(single[i]);
+        BotFreeMoveState(batch[i]);
+    }
+
+    free(aasworld.areasettings);
+    free(aasworld.reachability);
+    aasworld.areasettings = NULL;
+    aasworld.reachability = NULL;
+    aasworld.numAreaSettings = 0;
+    aasworld.numReachability = 0;
+    aasworld.numAreas = 0;
+}
+
+/* area 1 has two ways into the goal area 2 and one into the dead end area 3 */
+static void test_build_stuck_world(void)
+{
+    aasworld.time = 1.0f;
+    aasworld.numAreas = 3;
+    aasworld.areas = calloc(4, sizeof(aas_area_t));
+    assert_non_null(aasworld.areas);
+    VectorSet(aasworld.areas[2].center, 64.0f, 0.0f, 0.0f);
+    aasworld.numAreaSettings = 4;
+    aasworld.areasettings = calloc(4, sizeof(aas_areasettings_t));
+    assert_non_null(aasworld.areasettings);
+    aasworld.areasettings[1].firstreachablearea = 1;
+    aasworld.areasettings[1].numreachableareas = 3;
+
+    aasworld.numReachability = 4;
+    aasworld.reachability = calloc(4, sizeof(aas_reachability_t));
+    assert_non_null(aasworld.reachability);
+    aasworld.reachability[1].areanum = 2;
+    aasworld.reachability[1].traveltype = TRAVEL_WALK;
+    aasworld.reachability[1].traveltime = 10;
+    VectorSet(aasworld.reachability[1].start, 0.0f, 32.0f, 0.0f);
+    VectorSet(aasworld.reachability[1].end, 64.0f, 32.0f, 0.0f);
+    aasworld.reachability[2].areanum = 2;
+    aasworld.reachability[2].traveltype = TRAVEL_WALK;
+    aasworld.reachability[2].traveltime = 50;
+    VectorSet(aasworld.reachability[2].start, 32.0f, 0.0f, 0.0f);
+    VectorSet(aasworld.reachability[2].end, 64.0f, 0.0f, 0.0f);
+    aasworld.reachability[3].areanum = 3;
+    aasworld.reachability[3].traveltype = TRAVEL_WALK;
+    aasworld.travelflagfortype[TRAVEL_WALK] = TFL_WALK;
+    aasworld.reversedReachability = calloc(4, sizeof(aas_reversedreachability_t));
+    assert_non_null(aasworld.reversedReachability);
+}
+
+static void test_free_stuck_world(void)
+{
+    AAS_InvalidateRouteCache();
+    free(aasworld.areas);
+    free(aasworld.areasettings);
+    free(aasworld.reachability);
+    free(aasworld.reversedReachability);
+    aasworld.areas = NULL;
+    aasworld.reversedReachability = NULL;
+    aasworld.areasettings = NULL;
+    aasworld.reachability = NULL;
+    aasworld.numAreaSettings = 0;
+    aasworld.numReachability = 0;
+    aasworld.numAreas = 0;
+}
+
+static void test_bot_move_recovers_when_stuck(void **state)
+{
+    (void)state;
+
+    BotMove_MoverCatalogueReset();
+    BotMove_ResetRecoveryStats();
+    test_build_stuck_world();
+
+    int handle = BotAllocMoveState();
+    assert_int_not_equal(handle, 0);
+    bot_movestate_t *ms = BotMoveStateFromHandle(handle);
+    assert_non_null(ms);
+    ms->areanum = 1;
+    VectorClear(ms->origin);
+
+    bot_goal_t goal = {0};
+    goal.areanum = 2;
+    VectorSet(goal.origin, 96.0f, 0.0f, 0.0f);
+
+    bot_moveresult_t result;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 1);
+
+    /* no progress for a second: the other reachability into the goal is tried */
+    aasworld.time = 2.1f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->recoverytier, BOT_MOVE_RECOVERY_ALTREACH);
+    assert_int_equal(ms->lastreachnum, 2);
+
+    /* still stuck: sidestep away from the reachability start */
+    aasworld.time = 3.2f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->recoverytier, BOT_MOVE_RECOVERY_SIDESTEP);
+    assert_float_equal(result.movedir[0], 0.0f, 0.001f);
+    assert_float_equal(result.movedir[1], 1.0f, 0.001f);
+
+    /* once the sidestep ends the original route is retried, then abandoned */
+    aasworld.time = 3.8f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 1);
+
+    aasworld.time = 4.9f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->recoverytier, BOT_MOVE_RECOVERY_REROUTE);
+    assert_int_equal(ms->lastreachnum, 2);
+
+    /* reaching another area resolves the stuck state */
+    ms->areanum = 2;
+    aasworld.time = 5.0f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->recoverytier, BOT_MOVE_RECOVERY_NONE);
+
+    bot_move_recovery_stats_t stats;
+    BotMove_GetRecoveryStats(&stats);
+    assert_int_equal(stats.attempts[BOT_MOVE_RECOVERY_ALTREACH], 1);
+    assert_int_equal(stats.attempts[BOT_MOVE_RECOVERY_SIDESTEP], 1);
+    assert_int_equal(stats.attempts[BOT_MOVE_RECOVERY_REROUTE], 1);
+    assert_int_equal(stats.resolved[BOT_MOVE_RECOVERY_ALTREACH], 0);
+    assert_int_equal(stats.resolved[BOT_MOVE_RECOVERY_REROUTE], 1);
+
+    BotFreeMoveState(handle);
+    test_free_stuck_world();
+}
+
+/* runs a bot standing still at the origin up to its first sidestep */
+static void test_stuck_until_sidestep(int handle, const bot_goal_t *goal, bot_moveresult_t *result)
+{
+    bot_movestate_t *ms = BotMoveStateFromHandle(handle);
+    ms->areanum = 1;
+    VectorClear(ms->origin);
+
+    aasworld.time = 1.0f;
+    BotClearMoveResult(result);
+    BotMoveToGoal(result, handle, goal, TFL_DEFAULT);
+    aasworld.time = 2.1f;
+    BotClearMoveResult(result);
+    BotMoveToGoal(result, handle, goal, TFL_DEFAULT);
+    aasworld.time = 3.2f;
+    BotClearMoveResult(result);
+    BotMoveToGoal(result, handle, goal, TFL_DEFAULT);
+    assert_int_equal(ms->recoverytier, BOT_MOVE_RECOVERY_SIDESTEP);
+}
+
+static void test_bot_move_recovery_is_per_bot(void **state)
+{
+    (void)state;
+
+    BotMove_MoverCatalogueReset();
+    BotMove_ResetRecoveryStats();
+    test_build_stuck_world();
+
+    bot_goal_t goal = {0};
+    goal.areanum = 2;
+    VectorSet(goal.origin, 96.0f, 0.0f, 0.0f);
+
+    int first = BotAllocMoveState();
+    int second = BotAllocMoveState();
+    assert_int_not_equal(first, 0);
+    assert_int_not_equal(second, 0);
+
+    /* another bot's sidestep does not flip the side this one picks */
+    bot_moveresult_t result;
+    test_stuck_until_sidestep(first, &goal, &result);
+    assert_float_equal(result.movedir[1], 1.0f, 0.001f);
+    test_stuck_until_sidestep(second, &goal, &result);
+    assert_float_equal(result.movedir[1], 1.0f, 0.001f);
+
+    /* a new goal drops the sidestep planned for the old route */
+    bot_movestate_t *ms = BotMoveStateFromHandle(second);
+    bot_goal_t other = {0};
+    other.areanum = 3;
+    aasworld.time = 3.3f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, second, &other, TFL_DEFAULT);
+    assert_int_equal(ms->recoverytier, BOT_MOVE_RECOVERY_NONE);
+    assert_int_equal(ms->recoveryarea, 0);
+    assert_float_equal(ms->sidesteptime, 0.0f, 0.001f);
+    assert_int_equal(ms->lastreachnum, 3);
+
+    BotFreeMoveState(first);
+    BotFreeMoveState(second);
+    test_free_stuck_world();
+}
+
+static void test_bot_move_penalty_reranks_reach(void **state)
+{
+    (void)state;
+
+    BotMove_MoverCatalogueReset();
+    BotMove_ClearPenalties();
+
+    aasworld.time = 1.0f;
+    aasworld.numAreas = 2;
+    aasworld.areas = calloc(3, sizeof(aas_area_t));
+    assert_non_null(aasworld.areas);
+    aasworld.numAreaSettings = 3;
+    aasworld.areasettings = calloc(3, sizeof(aas_areasettings_t));
+    assert_non_null(aasworld.areasettings);
+    aasworld.areasettings[1].firstreachablearea = 1;
+    aasworld.areasettings[1].numreachableareas = 2;
+
+    aasworld.numReachability = 3;
+    aasworld.reachability = calloc(3, sizeof(aas_reachability_t));
+    assert_non_null(aasworld.reachability);
+    aasworld.reachability[1].areanum = 2;
+    aasworld.reachability[1].traveltype = TRAVEL_WALK;
+    aasworld.reachability[1].traveltime = 10;
+    VectorSet(aasworld.reachability[1].end, 64.0f, 0.0f, 0.0f);
+    aasworld.reachability[2].areanum = 2;
+    aasworld.reachability[2].traveltype = TRAVEL_WALK;
+    aasworld.reachability[2].traveltime = 50;
+    VectorSet(aasworld.reachability[2].end, 0.0f, 64.0f, 0.0f);
+    aasworld.travelflagfortype[TRAVEL_WALK] = TFL_WALK;
+
+    int handle = BotAllocMoveState();
+    assert_int_not_equal(handle, 0);
+    bot_movestate_t *ms = BotMoveStateFromHandle(handle);
+    assert_non_null(ms);
+    ms->areanum = 1;
+
+    bot_goal_t goal = {0};
+    goal.areanum = 2;
+
+    bot_moveresult_t result;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 1);
+
+    /* a penalty outweighing the difference moves the bot to the other way in */
+    BotMove_AddReachPenalty(1, 100, 0.5f);
+    aasworld.time = 1.1f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 2);
+    assert_int_equal(ms->corridor[0], 1);
+
+    /* once it expires the planned route is taken again */
+    aasworld.time = 1.7f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 1);
+
+    /* an area penalty applies to every way into the area alike */
+    BotMove_AddAreaPenalty(2, 100, 1.0f);
+    aasworld.time = 1.8f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 1);
+
+    BotFreeMoveState(handle);
+    BotMove_ClearPenalties();
+
+    free(aasworld.areas);
+    free(aasworld.areasettings);
+    free(aasworld.reachability);
+    aasworld.areas = NULL;
+    aasworld.areasettings = NULL;
+    aasworld.reachability = NULL;
+    aasworld.numAreaSettings = 0;
+    aasworld.numReachability = 0;
+    aasworld.numAreas = 0;
+}
+
+static void test_bot_move_penalty_along_corridor(void **state)
+{
+    (void)state;
+
+    BotMove_MoverCatalogueReset();
+    BotMove_ClearPenalties();
+
+    /* 1 -> 2 -> 4 is planned; a slower way into 2 and a way round through 3 */
+    aasworld.time = 1.0f;
+    aasworld.numAreas = 4;
+    aasworld.areas = calloc(5, sizeof(aas_area_t));
+    assert_non_null(aasworld.areas);
+    aasworld.numAreaSettings = 5;
+    aasworld.areasettings = calloc(5, sizeof(aas_areasettings_t));
+    assert_non_null(aasworld.areasettings);
+    aasworld.areasettings[1].firstreachablearea = 1;
+    aasworld.areasettings[1].numreachableareas = 3;
+    aasworld.areasettings[2].firstreachablearea = 4;
+    aasworld.areasettings[2].numreachableareas = 1;
+    aasworld.areasettings[3].firstreachablearea = 5;
+    aasworld.areasettings[3].numreachableareas = 1;
+
+    static const int links[6][2] = {
+        {0, 0},
+        {2, 10},
+        {2, 30},
+        {3, 40},
+        {4, 10},
+        {4, 10},
+    };
+    aasworld.numReachability = 6;
+    aasworld.reachability = calloc(6, sizeof(aas_reachability_t));
+    assert_non_null(aasworld.reachability);
+    for (int i = 1; i < 6; ++i)
+    {
+        aasworld.reachability[i].areanum = links[i][0];
+        aasworld.reachability[i].traveltype = TRAVEL_WALK;
+        aasworld.reachability[i].traveltime = (unsigned short)links[i][1];
+    }
+    aasworld.travelflagfortype[TRAVEL_WALK] = TFL_WALK;
+    assert_int_equal(AAS_PrepareReachability(), BLERR_NOERROR);
+
+    int handle = BotAllocMoveState();
+    assert_int_not_equal(handle, 0);
+    bot_movestate_t *ms = BotMoveStateFromHandle(handle);
+    assert_non_null(ms);
+    ms->areanum = 1;
+
+    bot_goal_t goal = {0};
+    goal.areanum = 4;
+
+    bot_moveresult_t result;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 1);
+    assert_int_equal(ms->corridor[1], 4);
+
+    /*
+     * A penalty on the second leg turns the bot, and the slower way into
+     * area 2 pays it too, so the way round through area 3 is taken.
+     */
+    BotMove_AddReachPenalty(4, 100, 1.0f);
+    aasworld.time = 1.1f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 3);
+
+    BotFreeMoveState(handle);
+    BotMove_ClearPenalties();
+
+    AAS_InvalidateRouteCache();
+    AAS_ClearReachabilityData();
+    free(aasworld.areas);
+    free(aasworld.areasettings);
+    free(aasworld.reachability);
+    aasworld.areas = NULL;
+    aasworld.areasettings = NULL;
+    aasworld.reachability = NULL;
+    aasworld.numAreaSettings = 0;
+    aasworld.numReachability = 0;
+    aasworld.numAreas = 0;
+}
+
+/*
+ * Floor brush spanning z -64..0 with lava above it for x >= 128.  Node 0
+ * splits on the floor plane, node 1 on x = 128.
+ */
+static void test_build_lava_world(void)
+{
+    bspworld.numPlanes = 8;
+    bspworld.planes = calloc(8, sizeof(cplane_t));
+    assert_non_null(bspworld.planes);
+    static const float planedefs[8][4] = {
+        {0.0f, 0.0f, 1.0f, 0.0f},
+        {1.0f, 0.0f, 0.0f, 128.0f},
+        {1.0f, 0.0f, 0.0f, 1024.0f},
+        {-1.0f, 0.0f, 0.0f, 1024.0f},
+        {0.0f, 1.0f, 0.0f, 1024.0f},
+        {0.0f, -1.0f, 0.0f, 1024.0f},
+        {0.0f, 0.0f, -1.0f, 64.0f},
+        {0.0f, 0.0f, 1.0f, 0.0f},
+    };
+    for (int i = 0; i < 8; ++i)
+    {
+        cplane_t *plane = &bspworld.planes[i];
+        VectorSet(plane->normal, planedefs[i][0], planedefs[i][1], planedefs[i][2]);
+        plane->dist = planedefs[i][3];
+        plane->type = 3;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (plane->normal[axis] == 1.0f)
+            {
+                plane->type = (byte)axis;
+            }
+            if (plane->normal[axis] < 0.0f)
+            {
+                plane->signbits |= (byte)(1 << axis);
+            }
+        }
+    }
+
+    bspworld.numNodes = 2;
+    bspworld.nodes = calloc(2, sizeof(aas_bspnode_t));
+    assert_non_null(bspworld.nodes);
+    bspworld.nodes[0].plane = &bspworld.planes[0];
+    bspworld.nodes[0].children[0] = 1;
+    bspworld.nodes[0].children[1] = -1; /* leaf 0, the floor */
+    bspworld.nodes[1].plane = &bspworld.planes[1];
+    bspworld.nodes[1].children[0] = -2; /* leaf 1, lava */
+    bspworld.nodes[1].children[1] = -3; /* leaf 2, open air */
+
+    bspworld.numLeafs = 3;
+    bspworld.leafs = calloc(3, sizeof(aas_bspleaf_t));
+    assert_non_null(bspworld.leafs);
+    bspworld.leafs[0].contents = CONTENTS_SOLID;
+    bspworld.leafs[0].numleafbrushes = 1;
+    bspworld.leafs[1].contents = CONTENTS_LAVA;
+    for (int i = 0; i < 3; ++i)
+    {
+        bspworld.leafs[i].cluster = -1;
+    }
+
+    bspworld.numLeafBrushes = 1;
+    bspworld.leafbrushes = calloc(1, sizeof(int));
+    assert_non_null(bspworld.leafbrushes);
+
+    bspworld.numBrushes = 1;
+    bspworld.brushes = calloc(1, sizeof(aas_bspbrush_t));
+    assert_non_null(bspworld.brushes);
+    bspworld.brushes[0].contents = CONTENTS_SOLID;
+    bspworld.brushes[0].numsides = 6;
+
+    bspworld.numBrushSides = 6;
+    bspworld.brushsides = calloc(6, sizeof(aas_bspbrushside_t));
+    assert_non_null(bspworld.brushsides);
+    for (int i = 0; i < 6; ++i)
+    {
+        bspworld.brushsides[i].plane = &bspworld.planes[2 + i];
+        bspworld.brushsides[i].surface = -1;
+    }
+
+    bspworld.numModels = 1;
+    bspworld.models = calloc(1, sizeof(aas_bspmodel_t));
+    assert_non_null(bspworld.models);
+    bspworld.loaded = qtrue;
+}
+
+static void test_bot_move_skips_jumps_into_lava(void **state)
+{
+    (void)state;
+
+    BotMove_MoverCatalogueReset();
+    BotMove_ClearPenalties();
+    test_build_lava_world();
+
+    aasworld.time = 1.0f;
+    aasworld.numAreas = 2;
+    aasworld.areas = calloc(3, sizeof(aas_area_t));
+    assert_non_null(aasworld.areas);
+    aasworld.numAreaSettings = 3;
+    aasworld.areasettings = calloc(3, sizeof(aas_areasettings_t));
+    assert_non_null(aasworld.areasettings);
+    aasworld.areasettings[1].firstreachablearea = 1;
+    aasworld.areasettings[1].numreachableareas = 3;
+
+    /* two jumps that come down in the lava and a slower walk around it */
+    aasworld.numReachability = 4;
+    aasworld.reachability = calloc(4, sizeof(aas_reachability_t));
+    assert_non_null(aasworld.reachability);
+    aasworld.reachability[1].areanum = 2;
+    aasworld.reachability[1].traveltype = TRAVEL_JUMP;
+    aasworld.reachability[1].traveltime = 10;
+    VectorSet(aasworld.reachability[1].end, 300.0f, 0.0f, 24.0f);
+    aasworld.reachability[2].areanum = 2;
+    aasworld.reachability[2].traveltype = TRAVEL_JUMP;
+    aasworld.reachability[2].traveltime = 20;
+    VectorSet(aasworld.reachability[2].start, 0.0f, 32.0f, 0.0f);
+    VectorSet(aasworld.reachability[2].end, 300.0f, 64.0f, 24.0f);
+    aasworld.reachability[3].areanum = 2;
+    aasworld.reachability[3].traveltype = TRAVEL_WALK;
+    aasworld.reachability[3].traveltime = 50;
+    VectorSet(aasworld.reachability[3].end, 0.0f, 300.0f, 24.0f);
+    aasworld.travelflagfortype[TRAVEL_WALK] = TFL_WALK;
+    aasworld.travelflagfortype[TRAVEL_JUMP] = TFL_JUMP;
+
+    int handle = BotAllocMoveState();
+    assert_int_not_equal(handle, 0);
+    bot_movestate_t *ms = BotMoveStateFromHandle(handle);
+    assert_non_null(ms);
+    ms->areanum = 1;
+    VectorSet(ms->origin, 0.0f, 0.0f, 24.0f);
+
+    bot_goal_t goal = {0};
+    goal.areanum = 2;
+
+    /* landings are not predicted unless asked for */
+    bot_moveresult_t result;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 1);
+
+    /* only newly chosen reaches are checked; the replacement lands in lava too */
+    LibVarSet("bot_avoidhazards", "1");
+    ms->lastreachnum = 0;
+    aasworld.time = 1.1f;
+    BotClearMoveResult(&result);
+    BotMoveToGoal(&result, handle, &goal, TFL_DEFAULT);
+    assert_int_equal(ms->lastreachnum, 3);
+    LibVarSet("bot_avoidhazards", "0");
+
+    BotFreeMoveState(handle);
+    BotMove_ClearPenalties();
+    AAS_BSPClearCollision();
+
+    free(aasworld.areas);
+    free(aasworld.areasettings);
+    free(aasworld.reachability);
+    aasworld.areas = NULL;
+    aasworld.areasettings = NULL;
+    aasworld.reachability = NULL;
+    aasworld.numAreaSettings = 0;
+    aasworld.numReachability = 0;
+    aasworld.numAreas = 0;
+}
+
+static void test_mover_snapshot_tracks_plat(void **state)
+{
+    (void)state;
+
+    BotMove_MoverCatalogueReset();
+
+    bot_mover_catalogue_entry_t entry = {
+        .modelnum = 4,
+        .lip = 8.0f,
+        .height = 96.0f,
+        .speed = 200.0f,
+        .kind = BOT_MOVER_KIND_FUNC_PLAT,
+    };
+    assert_true(BotMove_MoverCatalogueInsert(&entry));
+
+    char *names[] = {"", "*1", "*2", "*3", "*4"};
+    botinterface_asset_list_t models = {names, 5U};
+    assert_true(BotMove_MoverCatalogueFinalize(&models));
+    assert_non_null(BotMove_MoverCatalogueFindByModel(4));
+    assert_null(BotMove_MoverCatalogueFindByModel(3));
+    assert_null(BotMove_MoverCatalogueFindByModel(4096));
+
+    aasworld.maxEntities = 4;
+    aasworld.entities = calloc((size_t)aasworld.maxEntities, sizeof(aas_entity_t));
+    assert_non_null(aasworld.entities);
+
+    aas_entity_t *plat = &aasworld.entities[3];
+    plat->inuse = qtrue;
+    plat->number = 3;
+    plat->solid = SOLID_BSP;
+    plat->modelindex = 5;
+    plat->deltaTime = 0.1f;
+    VectorSet(plat->origin, 0.0f, 0.0f, -96.0f);
+    VectorCopy(plat->origin, plat->previousOrigin);
+    VectorSet(plat->mins, -32.0f, -32.0f, 0.0f);
+    VectorSet(plat->maxs, 32.0f, 32.0f, 8.0f);
+
+    aasworld.numFrames = 10;
+    assert_int_equal(BotMove_MoverSnapshotCount(), 1);
+    assert_null(BotMove_MoverSnapshotForEntity(2));
+    const bot_mover_state_t *mover = BotMove_MoverSnapshotForEntity(3);
+    assert_non_null(mover);
+    assert_ptr_equal(mover->catalogue, BotMove_MoverCatalogueFindByModel(4));
+    assert_true(mover->atrest);
+    assert_true(mover->atbottom);
+    assert_false(mover->attop);
+    assert_float_equal(mover->absmaxs[2], -88.0f, 0.001f);
+
+    /* The snapshot is only rebuilt when the frame advances. */
+    VectorSet(plat->origin, 0.0f, 0.0f, -76.0f);
+    assert_true(BotMove_MoverSnapshotForEntity(3)->atbottom);
+
+    aasworld.numFrames = 11;
+    mover = BotMove_MoverSnapshotForEntity(3);
+    assert_false(mover->atrest);
+    assert_false(mover->atbottom);
+    assert_float_equal(mover->velocity[2], 200.0f, 0.01f);
+
+    BotMove_MoverCatalogueReset();
+    free(aasworld.entities);
+    aasworld.entities = NULL;
+    aasworld.maxEntities = 0;
+    aasworld.numFrames = 0;
+}
+
 static void test_bot_travel_grapple_hook_toggles(void **state)
 {
     (void)state;
@@ -372,6 +1227,33 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_bot_move_handles_elevator_landing,
                                         test_setup,
                                         test_teardown),
+        cmocka_unit_test_setup_teardown(test_bot_move_follows_corridor,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_bot_move_walks_straight_through_walk_areas,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_bot_move_batch_matches_single_calls,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_bot_move_recovers_when_stuck,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_bot_move_recovery_is_per_bot,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_bot_move_penalty_reranks_reach,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_bot_move_penalty_along_corridor,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_bot_move_skips_jumps_into_lava,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_mover_snapshot_tracks_plat,
+                                        test_setup,
+                                        test_teardown),
         cmocka_unit_test_setup_teardown(test_bot_travel_grapple_hook_toggles,
                                         test_setup,
                                         test_teardown),
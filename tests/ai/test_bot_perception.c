@@ -0,0 +1,327 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdbool.h>
+
+#include "botlib/interface/bot_perception.h"
+
+static int g_test_traces = 0;
+static bool g_test_visible = true;
+
+static bool test_trace(const vec3_t from, const vec3_t to, int viewer, int target)
+{
+    (void)from;
+    (void)to;
+    (void)viewer;
+    (void)target;
+    g_test_traces += 1;
+    return g_test_visible;
+}
+
+static int test_setup(void **state)
+{
+    (void)state;
+
+    g_test_traces = 0;
+    g_test_visible = true;
+    BotPerception_BeginFrame();
+    return 0;
+}
+
+static void test_line_of_sight_shared_by_both_ends(void **state)
+{
+    (void)state;
+
+    vec3_t a = {0.0f, 0.0f, 22.0f};
+    vec3_t b = {400.0f, 0.0f, 22.0f};
+    assert_true(BotPerception_HasLineOfSight(a, b, 1, 2, test_trace));
+    assert_int_equal(g_test_traces, 1);
+
+    /* the target looking back, from a point in the same cell, reuses the trace */
+    vec3_t b_nudged = {401.0f, 1.0f, 23.0f};
+    g_test_visible = false;
+    assert_true(BotPerception_HasLineOfSight(b_nudged, a, 2, 1, test_trace));
+    assert_int_equal(g_test_traces, 1);
+    assert_int_equal(BotPerception_FrameTraces(), 1);
+
+    /* another viewer whose eye is in the same cell reuses it too */
+    vec3_t a_nudged = {3.0f, 2.0f, 20.0f};
+    assert_true(BotPerception_HasLineOfSight(a_nudged, b, 3, 2, test_trace));
+    assert_int_equal(g_test_traces, 1);
+
+    /* another target or an eye in another cell traces again */
+    assert_false(BotPerception_HasLineOfSight(a, b, 1, 4, test_trace));
+    vec3_t a_moved = {0.0f, 0.0f, 40.0f};
+    assert_false(BotPerception_HasLineOfSight(a_moved, b, 1, 2, test_trace));
+    assert_int_equal(g_test_traces, 3);
+    assert_int_equal(BotPerception_FrameTraces(), 3);
+}
+
+static void test_line_of_sight_shared_by_viewers_in_cell(void **state)
+{
+    (void)state;
+
+    /* bots bunched in one cell looking at the same enemy trace once */
+    vec3_t eyes[3] = {{0.0f, 0.0f, 22.0f}, {2.0f, 5.0f, 22.0f}, {7.0f, 1.0f, 17.0f}};
+    vec3_t enemy = {400.0f, 0.0f, 22.0f};
+    for (int viewer = 0; viewer < 3; ++viewer)
+    {
+        assert_true(BotPerception_HasLineOfSight(eyes[viewer], enemy, viewer, 5, test_trace));
+    }
+    assert_int_equal(g_test_traces, 1);
+
+    /* the enemy looking back at any of them reuses that trace */
+    for (int viewer = 0; viewer < 3; ++viewer)
+    {
+        assert_true(BotPerception_HasLineOfSight(enemy, eyes[viewer], 5, viewer, test_trace));
+    }
+    assert_int_equal(g_test_traces, 1);
+    assert_int_equal(BotPerception_FrameTraces(), 1);
+}
+
+static void test_line_of_sight_expires_with_frame(void **state)
+{
+    (void)state;
+
+    vec3_t a = {0.0f, 0.0f, 22.0f};
+    vec3_t b = {400.0f, 0.0f, 22.0f};
+    assert_true(BotPerception_HasLineOfSight(a, b, 1, 2, test_trace));
+
+    g_test_visible = false;
+    BotPerception_BeginFrame();
+    assert_int_equal(BotPerception_FrameTraces(), 0);
+    assert_false(BotPerception_HasLineOfSight(a, b, 1, 2, test_trace));
+    assert_false(BotPerception_HasLineOfSight(a, b, 1, 2, test_trace));
+    assert_int_equal(g_test_traces, 2);
+}
+
+static void test_line_of_sight_traces_past_full_table(void **state)
+{
+    (void)state;
+
+    /* once the table is half full new segments are still traced, just not kept */
+    vec3_t a = {0.0f, 0.0f, 22.0f};
+    for (int target = 1; target <= 600; ++target)
+    {
+        vec3_t b = {(float)target * 16.0f, 0.0f, 22.0f};
+        g_test_visible = (target & 1) != 0;
+        assert_true(BotPerception_HasLineOfSight(a, b, 0, target, test_trace) == g_test_visible);
+    }
+    assert_int_equal(g_test_traces, 600);
+
+    g_test_visible = true;
+    vec3_t kept = {16.0f * 2.0f, 0.0f, 22.0f};
+    vec3_t dropped = {16.0f * 600.0f, 0.0f, 22.0f};
+    assert_false(BotPerception_HasLineOfSight(a, kept, 0, 2, test_trace));
+    assert_int_equal(g_test_traces, 600);
+    assert_true(BotPerception_HasLineOfSight(a, dropped, 0, 600, test_trace));
+    assert_int_equal(g_test_traces, 601);
+}
+
+#define TEST_PERCEPTION_CLIENTS 8
+
+static vec3_t g_test_origins[TEST_PERCEPTION_CLIENTS];
+static bool g_test_present[TEST_PERCEPTION_CLIENTS];
+
+static const float *test_client_origin(int ent)
+{
+    if (ent < 0 || ent >= TEST_PERCEPTION_CLIENTS || !g_test_present[ent])
+    {
+        return NULL;
+    }
+    return g_test_origins[ent];
+}
+
+static void place_client(int ent, float x, float y)
+{
+    VectorSet(g_test_origins[ent], x, y, 0.0f);
+    g_test_present[ent] = true;
+}
+
+static void place_clients(void)
+{
+    memset(g_test_present, 0, sizeof(g_test_present));
+    place_client(0, 100.0f, 100.0f);
+    place_client(1, 300.0f, -200.0f);
+    place_client(2, 20000.0f, 0.0f);
+    place_client(3, -600.0f, 100.0f);
+    place_client(5, 150.0f, 900.0f);
+}
+
+static void test_client_grid_collects_nearby_clients_in_order(void **state)
+{
+    (void)state;
+
+    place_clients();
+    vec3_t origin = {100.0f, 100.0f, 0.0f};
+    int clients[TEST_PERCEPTION_CLIENTS];
+    int count = BotPerception_ClientGridQuery(origin,
+                                              1000.0f,
+                                              NULL,
+                                              NULL,
+                                              1U,
+                                              TEST_PERCEPTION_CLIENTS,
+                                              test_client_origin,
+                                              clients);
+    assert_int_equal(count, 4);
+    assert_int_equal(clients[0], 0);
+    assert_int_equal(clients[1], 1);
+    assert_int_equal(clients[2], 3);
+    assert_int_equal(clients[3], 5);
+
+    /* looking along +x drops the cells wholly behind the bot */
+    vec3_t forward = {1.0f, 0.0f, 0.0f};
+    count = BotPerception_ClientGridQuery(origin,
+                                          1000.0f,
+                                          origin,
+                                          forward,
+                                          1U,
+                                          TEST_PERCEPTION_CLIENTS,
+                                          test_client_origin,
+                                          clients);
+    assert_int_equal(count, 3);
+    assert_int_equal(clients[0], 0);
+    assert_int_equal(clients[1], 1);
+    assert_int_equal(clients[2], 5);
+}
+
+static void test_client_grid_rebuilt_once_per_frame(void **state)
+{
+    (void)state;
+
+    place_clients();
+    vec3_t origin = {100.0f, 100.0f, 0.0f};
+    int clients[TEST_PERCEPTION_CLIENTS];
+    assert_int_equal(BotPerception_ClientGridQuery(origin, 500.0f, NULL, NULL, 7U, TEST_PERCEPTION_CLIENTS,
+                                                   test_client_origin, clients),
+                     3);
+
+    /* a client arriving mid-frame is only seen once the frame moves on */
+    place_client(6, 200.0f, 200.0f);
+    assert_int_equal(BotPerception_ClientGridQuery(origin, 500.0f, NULL, NULL, 7U, TEST_PERCEPTION_CLIENTS,
+                                                   test_client_origin, clients),
+                     3);
+    assert_int_equal(BotPerception_ClientGridQuery(origin, 500.0f, NULL, NULL, 8U, TEST_PERCEPTION_CLIENTS,
+                                                   test_client_origin, clients),
+                     4);
+    assert_int_equal(clients[3], 6);
+}
+
+static void test_client_grid_scans_linearly_past_bucket_count(void **state)
+{
+    (void)state;
+
+    /* an alert bot's 4900 unit range spans about 400 cells, more than there are buckets */
+    place_clients();
+    vec3_t origin = {100.0f, 100.0f, 0.0f};
+    int clients[TEST_PERCEPTION_CLIENTS];
+    int count = BotPerception_ClientGridQuery(origin,
+                                              4900.0f,
+                                              NULL,
+                                              NULL,
+                                              9U,
+                                              TEST_PERCEPTION_CLIENTS,
+                                              test_client_origin,
+                                              clients);
+    assert_int_equal(count, 5);
+    assert_int_equal(clients[0], 0);
+    assert_int_equal(clients[1], 1);
+    assert_int_equal(clients[2], 2);
+    assert_int_equal(clients[3], 3);
+    assert_int_equal(clients[4], 5);
+}
+
+static void test_search_interval_leaves_room_for_reaction_delay(void **state)
+{
+    (void)state;
+
+    /* the attack code waits out its reaction delay after a sighting */
+    assert_float_equal(BotPerception_SearchInterval(1.0f, 0.3f, false), 0.7f, 0.0001f);
+    assert_float_equal(BotPerception_SearchInterval(1.0f, 0.3f, true), 0.175f, 0.0001f);
+    assert_float_equal(BotPerception_SearchInterval(1.0f, 0.0f, false), 1.0f, 0.0001f);
+
+    assert_float_equal(BotPerception_SearchInterval(0.3f, 0.3f, false), BOT_PERCEPTION_MIN_INTERVAL, 0.0001f);
+    assert_float_equal(BotPerception_SearchInterval(5.0f, 0.3f, false), BOT_PERCEPTION_MAX_INTERVAL, 0.0001f);
+}
+
+static void test_search_runs_once_per_interval(void **state)
+{
+    (void)state;
+
+    bot_perception_schedule_t schedule = {false, 0.0f};
+    assert_true(BotPerception_SearchDue(&schedule, 10.0f, 0.4f, false, false));
+
+    /* client 1 waits half an interval after its first search, later ones wait a whole one */
+    BotPerception_ScheduleSearch(&schedule, 1, 10.0f, 0.4f);
+    assert_float_equal(schedule.next_time, 10.2f, 0.0001f);
+    assert_false(BotPerception_SearchDue(&schedule, 10.1f, 0.4f, false, false));
+    assert_true(BotPerception_SearchDue(&schedule, 10.2f, 0.4f, false, false));
+    BotPerception_ScheduleSearch(&schedule, 1, 10.2f, 0.4f);
+    assert_float_equal(schedule.next_time, 10.6f, 0.0001f);
+
+    /* taking damage searches at once */
+    assert_true(BotPerception_SearchDue(&schedule, 10.3f, 0.4f, true, false));
+
+    /* a schedule left over from an earlier map runs straight away */
+    assert_true(BotPerception_SearchDue(&schedule, 1.0f, 0.4f, false, false));
+}
+
+static void test_search_slips_while_budget_spent(void **state)
+{
+    (void)state;
+
+    bot_perception_schedule_t schedule = {true, 20.0f};
+
+    /* a due search waits for a frame with traces to spare, for up to one interval */
+    assert_true(BotPerception_SearchDue(&schedule, 20.1f, 0.4f, false, false));
+    assert_false(BotPerception_SearchDue(&schedule, 20.1f, 0.4f, false, true));
+    assert_false(BotPerception_SearchDue(&schedule, 20.39f, 0.4f, false, true));
+    assert_true(BotPerception_SearchDue(&schedule, 20.4f, 0.4f, false, true));
+
+    /* damage is never held back by the budget */
+    assert_true(BotPerception_SearchDue(&schedule, 20.1f, 0.4f, true, true));
+}
+
+static void test_search_budget_counts_frame_traces(void **state)
+{
+    (void)state;
+
+    /* the interface compares its budget against the traces run this frame */
+    vec3_t a = {0.0f, 0.0f, 22.0f};
+    for (int target = 1; target <= 4; ++target)
+    {
+        vec3_t b = {(float)target * 64.0f, 0.0f, 22.0f};
+        BotPerception_HasLineOfSight(a, b, 0, target, test_trace);
+        BotPerception_HasLineOfSight(b, a, target, 0, test_trace);
+    }
+    assert_int_equal(BotPerception_FrameTraces(), 4);
+
+    BotPerception_BeginFrame();
+    assert_int_equal(BotPerception_FrameTraces(), 0);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_line_of_sight_shared_by_both_ends, test_setup, NULL),
+        cmocka_unit_test_setup_teardown(test_line_of_sight_shared_by_viewers_in_cell, test_setup, NULL),
+        cmocka_unit_test_setup_teardown(test_line_of_sight_expires_with_frame, test_setup, NULL),
+        cmocka_unit_test_setup_teardown(test_line_of_sight_traces_past_full_table, test_setup, NULL),
+        cmocka_unit_test(test_client_grid_collects_nearby_clients_in_order),
+        cmocka_unit_test(test_client_grid_rebuilt_once_per_frame),
+        cmocka_unit_test(test_client_grid_scans_linearly_past_bucket_count),
+        cmocka_unit_test(test_search_interval_leaves_room_for_reaction_delay),
+        cmocka_unit_test(test_search_runs_once_per_interval),
+        cmocka_unit_test(test_search_slips_while_budget_spent),
+        cmocka_unit_test_setup_teardown(test_search_budget_counts_frame_traces, test_setup, NULL),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -9,8 +9,10 @@
 #include <limits.h>
 
 #include "botlib/common/l_assets.h"
+#include "botlib/common/l_avoid.h"
 #include "botlib/common/l_crc.h"
 #include "botlib/common/l_libvar.h"
+#include "botlib/common/l_memory.h"
 #include "botlib/common/l_struct.h"
 #include "botlib/common/l_utils.h"
 #include "botlib/precomp/l_precomp.h"
@@ -615,6 +617,144 @@ static void test_resolve_asset_path_prefers_override_to_pak(void)
     test_rmdir(basedir);
 }
 
+static void test_avoid_table_expires_and_evicts(void) {
+    bot_avoidtable_t table;
+    assert(AvoidTable_Init(&table, 4));
+
+    assert(AvoidTable_Set(&table, 10, 5.0f));
+    assert(AvoidTable_Set(&table, 11, 2.0f));
+    assert(AvoidTable_Set(&table, 12, 8.0f));
+    assert(AvoidTable_Contains(&table, 11, 1.0f));
+    assert(!AvoidTable_Contains(&table, 11, 2.0f));
+    assert(fabsf(AvoidTable_Remaining(&table, 10, 1.0f) - 4.0f) < 0.001f);
+
+    /* refreshing an id moves its expiry instead of adding a second entry */
+    assert(AvoidTable_Set(&table, 11, 9.0f));
+    assert(table.count == 3);
+    assert(AvoidTable_Contains(&table, 11, 8.5f));
+
+    /* a full table drops the entry that expires first */
+    assert(AvoidTable_Set(&table, 13, 7.0f));
+    assert(AvoidTable_Set(&table, 14, 6.0f));
+    assert(table.count == 4);
+    assert(AvoidTable_Find(&table, 10) == NULL);
+    assert(AvoidTable_Find(&table, 14) != NULL);
+
+    AvoidTable_Expire(&table, 7.0f);
+    assert(table.count == 2);
+    assert(AvoidTable_Find(&table, 12) != NULL);
+    assert(AvoidTable_Find(&table, 11) != NULL);
+
+    assert(AvoidTable_Remove(&table, 12));
+    assert(!AvoidTable_Remove(&table, 12));
+    assert(table.count == 1);
+    assert(table.entries[0].id == 11);
+
+    AvoidTable_Clear(&table);
+    assert(table.count == 0);
+    assert(AvoidTable_Find(&table, 11) == NULL);
+    AvoidTable_Free(&table);
+}
+
+static void test_avoid_table_matches_linear_reference(void) {
+    enum { capacity = 16, numids = 48 };
+    bot_avoidtable_t table;
+    assert(AvoidTable_Init(&table, capacity));
+
+    /* multiples of 1024 to crowd the hash, mirrored in a plain expiry array */
+    float reference[numids];
+    for (int i = 0; i < numids; ++i) {
+        reference[i] = -1.0f;
+    }
+
+    unsigned int seed = 12345u;
+    float now = 0.0f;
+    for (int step = 0; step < 4000; ++step) {
+        seed = seed * 1103515245u + 12345u;
+        int id = (int)((seed >> 16) % numids);
+        int op = (int)((seed >> 8) % 8);
+        if (op < 5) {
+            float expiry = now + (float)((seed >> 4) % 50) * 0.1f;
+            float earliest = -1.0f;
+            if (reference[id] < 0.0f && table.count >= capacity) {
+                for (int i = 0; i < numids; ++i) {
+                    if (reference[i] >= 0.0f && (earliest < 0.0f || reference[i] < earliest)) {
+                        earliest = reference[i];
+                    }
+                }
+            }
+            assert(AvoidTable_Set(&table, id * 1024, expiry));
+            if (earliest >= 0.0f) {
+                /* exactly one entry went, and none expired before it */
+                int evicted = 0;
+                for (int i = 0; i < numids; ++i) {
+                    if (i != id && reference[i] >= 0.0f && AvoidTable_Find(&table, i * 1024) == NULL) {
+                        assert(reference[i] == earliest);
+                        reference[i] = -1.0f;
+                        ++evicted;
+                    }
+                }
+                assert(evicted == 1);
+            }
+            reference[id] = expiry;
+        } else if (op < 6) {
+            assert(AvoidTable_Remove(&table, id * 1024) == (reference[id] >= 0.0f));
+            reference[id] = -1.0f;
+        } else {
+            now += 0.25f;
+            AvoidTable_Expire(&table, now);
+            for (int i = 0; i < numids; ++i) {
+                if (reference[i] >= 0.0f && reference[i] <= now) {
+                    reference[i] = -1.0f;
+                }
+            }
+        }
+
+        int live = 0;
+        for (int i = 0; i < numids; ++i) {
+            const bot_avoidentry_t *entry = AvoidTable_Find(&table, i * 1024);
+            if (entry == NULL) {
+                assert(reference[i] < 0.0f);
+                continue;
+            }
+            assert(entry->expiry == reference[i]);
+            ++live;
+        }
+        assert(live == table.count);
+        assert(table.count <= capacity);
+        for (int i = 1; i < table.count; ++i) {
+            assert(table.entries[table.heap[(i - 1) / 2]].expiry <= table.entries[table.heap[i]].expiry);
+        }
+    }
+
+    AvoidTable_Free(&table);
+}
+
+static void test_memory_counts_every_allocation_once(void) {
+    assert(BotMemory_Init(0));
+    size_t before = BotMemory_AllocationCount();
+
+    void *block = GetClearedMemory(64);
+    assert(block != NULL);
+    assert(BotMemory_AllocationCount() == before + 1);
+
+    int *values = (int *)BotMemory_Calloc(4, sizeof(int));
+    assert(values != NULL && values[3] == 0);
+    values = (int *)BotMemory_Realloc(values, 64 * sizeof(int));
+    assert(values != NULL);
+    char *text = (char *)BotMemory_Malloc(16);
+    assert(text != NULL);
+    assert(BotMemory_AllocationCount() == before + 4);
+
+    /* frees never lower the running total */
+    free(text);
+    free(values);
+    FreeMemory(block);
+    assert(BotMemory_AllocationCount() == before + 4);
+
+    BotMemory_Shutdown();
+}
+
 int main(void) {
     test_utils_initialisation_flags();
     test_struct_initialisation_flags();
@@ -627,6 +767,9 @@ int main(void) {
     test_resolve_asset_path_prefers_cddir_over_new_knob();
     test_resolve_asset_path_reads_from_pak_when_available();
     test_resolve_asset_path_prefers_override_to_pak();
+    test_avoid_table_expires_and_evicts();
+    test_avoid_table_matches_linear_reference();
+    test_memory_counts_every_allocation_once();
 
     printf("bot_common_tests: all checks passed\n");
     return 0;